@@ -0,0 +1,571 @@
+/*******************************
+ *                             *
+ *  Benchmark for the A* planner (no roscore needed)
+ *                             *
+ *  Usage: a_star_planner_benchmark [width] [height] [queries]
+ *         a_star_planner_benchmark --map <map.yaml | costmap.pgm> [options]
+ *         a_star_planner_benchmark --snapshot <file> [--repeat n]
+ *                             *
+ *******************************/
+
+#include "a_star_planner/a_star_planner.h"
+#include "a_star_planner/jump_point_planner.h"
+#include "a_star_planner/search_kernel_planner.h"
+#include "a_star_planner/landmark_heuristic.h"
+#include "costmap_file.h"
+
+#include "cb_base_navigation/global_planner/constraint_evaluator.h"
+#include "cb_base_navigation/global_planner/plan_snapshot.h"
+
+#include <float.h>
+#include <malloc.h> // for malloc_trim
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cb_global_planner;
+
+namespace {
+
+// Results of the layout benchmarks are stored here, so the compiler cannot drop the loops that compute them
+volatile double benchmark_sink = 0;
+
+double wallTime()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+// Random rectangular obstacles with an inflation gradient around them
+void generateCostmap(unsigned int width, unsigned int height, std::vector<unsigned char>& costmap)
+{
+    costmap.assign(width * height, 0);
+
+    unsigned int n_obstacles = width * height / 2000;
+    for (unsigned int i = 0; i < n_obstacles; ++i)
+    {
+        int x0 = rand() % width, y0 = rand() % height;
+        int w = 2 + rand() % 20, h = 2 + rand() % 20;
+        int r = 6;
+        for (int y = y0 - r; y < y0 + h + r; ++y)
+        {
+            for (int x = x0 - r; x < x0 + w + r; ++x)
+            {
+                if (x < 0 || y < 0 || x >= (int) width || y >= (int) height) continue;
+                int dx = std::max(0, std::max(x0 - x, x - (x0 + w - 1)));
+                int dy = std::max(0, std::max(y0 - y, y - (y0 + h - 1)));
+                int d = std::max(dx, dy);
+                unsigned char c = (d == 0) ? 254 : (d == 1 ? 253 : (unsigned char) (252 * (r - d) / r));
+                costmap[width * y + x] = std::max(costmap[width * y + x], c);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+// Visited map layout as it was before: one column array per x, indexed [x][y], reallocated per request
+double benchmarkColumnLayout(unsigned int width, unsigned int height, const std::vector<unsigned int>& probes, unsigned int repetitions)
+{
+    double sum = 0;
+    double t_start = wallTime();
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        double** map = new double*[width];
+        for (unsigned int x = 0; x < width; ++x)
+            map[x] = new double[height];
+
+        for (unsigned int x = 0; x < width; ++x)
+            for (unsigned int y = 0; y < height; ++y)
+                map[x][y] = DBL_MAX;
+
+        for (unsigned int i = 0; i < probes.size(); ++i)
+        {
+            unsigned int x = probes[i] % width, y = probes[i] / width;
+            map[x][y] = i;
+            sum += map[x][y];
+        }
+
+        for (unsigned int x = 0; x < width; ++x)
+            delete[] map[x];
+        delete[] map;
+    }
+    benchmark_sink = sum;
+    return (wallTime() - t_start) / repetitions;
+}
+
+// Visited map layout as it is now: one contiguous row-major buffer, allocated once
+double benchmarkRowMajorLayout(unsigned int width, unsigned int height, const std::vector<unsigned int>& probes, unsigned int repetitions)
+{
+    double sum = 0;
+    std::vector<double> map(width * height);
+    double t_start = wallTime();
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        std::fill(map.begin(), map.end(), DBL_MAX);
+
+        for (unsigned int i = 0; i < probes.size(); ++i)
+        {
+            map[probes[i]] = i;
+            sum += map[probes[i]];
+        }
+    }
+    benchmark_sink = sum;
+    return (wallTime() - t_start) / repetitions;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------------------
+
+// A GetPlan request as the A* plugin runs it: the goal cells of the constraint in their goal tiers, and the robot cell
+struct Query
+{
+    std::vector<unsigned int> mx_tier[CostModel::NUM_GOAL_TIERS], my_tier[CostModel::NUM_GOAL_TIERS];
+    int mx_start, my_start;
+};
+
+// Goal cells of a position constraint, divided in tiers like AStarPlannerGPP::calculateGoalTiers. The constraint is in
+// the frame at world_to_constraint, the start and the costmap geometry in the map frame.
+bool makeQuery(const CostmapFile& geometry, const unsigned char* costmap, const CostModel& cost_model, double start_x, double start_y,
+               const std::string& constraint, const tf::Transform& world_to_constraint, Query& q)
+{
+    q.mx_start = (int) floor((start_x - geometry.origin_x) / geometry.resolution);
+    q.my_start = (int) floor((start_y - geometry.origin_y) / geometry.resolution);
+    if (q.mx_start < 0 || q.my_start < 0 || q.mx_start >= (int) geometry.width || q.my_start >= (int) geometry.height)
+    {
+        fprintf(stderr, "Start (%g, %g) is off the map\n", start_x, start_y);
+        return false;
+    }
+
+    ConstraintEvaluator ce;
+    if (!ce.init(constraint)) { fprintf(stderr, "Invalid constraint '%s'\n", constraint.c_str()); return false; }
+
+    // Cell centres; in the map frame only the bounding box of the constraint is evaluated
+    double res = geometry.resolution;
+    double min_x = geometry.origin_x + 0.5 * res, min_y = geometry.origin_y + 0.5 * res;
+    double max_x = min_x + (geometry.width - 1) * res, max_y = min_y + (geometry.height - 1) * res;
+    double bb_min_x = min_x, bb_min_y = min_y, bb_max_x = max_x, bb_max_y = max_y;
+    bool map_frame = world_to_constraint.getOrigin().length2() == 0 && tf::getYaw(world_to_constraint.getRotation()) == 0;
+    if (map_frame) ce.getBoundingBox(min_x, min_y, max_x, max_y, res, bb_min_x, bb_min_y, bb_max_x, bb_max_y);
+
+    int x0 = std::max(0, (int) floor((bb_min_x - min_x) / res)), y0 = std::max(0, (int) floor((bb_min_y - min_y) / res));
+    int x1 = std::min((int) geometry.width - 1, (int) ceil((bb_max_x - min_x) / res));
+    int y1 = std::min((int) geometry.height - 1, (int) ceil((bb_max_y - min_y) / res));
+    if (x0 > x1 || y0 > y1) return true;
+
+    // The cell centres of a row are equally spaced in the constraint frame as well
+    tf::Transform constraint_to_world = world_to_constraint.inverse();
+    tf::Vector3 step = constraint_to_world.getBasis() * tf::Vector3(res, 0, 0);
+    std::vector<unsigned char> result(x1 - x0 + 1);
+    for (int y = y0; y <= y1; ++y)
+    {
+        tf::Point pc = constraint_to_world * tf::Point(min_x + x0 * res, min_y + y * res, 0);
+        ce.evaluateLine(pc.x(), pc.y(), step.x(), step.y(), result.size(), &result[0]);
+        for (int x = x0; x <= x1; ++x)
+        {
+            unsigned char cost = costmap[geometry.width * y + x];
+            if (!result[x - x0] || cost_model.isBlocked(cost)) continue;
+            unsigned int tier = cost_model.getGoalTier(cost);
+            q.mx_tier[tier].push_back(x);
+            q.my_tier[tier].push_back(y);
+        }
+    }
+    return true;
+}
+
+// Query file: per line 'start_x start_y constraint', map frame [m], the rest of the line is the constraint; '#' comments
+bool readQueries(const std::string& filename, const CostmapFile& costmap, const CostModel& cost_model, std::vector<Query>& queries)
+{
+    std::ifstream file(filename.c_str());
+    if (!file) { fprintf(stderr, "Cannot open '%s'\n", filename.c_str()); return false; }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line[line.find_first_not_of(" \t\r")] == '#') continue;
+
+        std::istringstream in(line);
+        double x, y;
+        std::string constraint;
+        if (!(in >> x >> y) || !std::getline(in, constraint))
+        {
+            fprintf(stderr, "Cannot read query '%s'\n", line.c_str());
+            return false;
+        }
+
+        Query q;
+        if (!makeQuery(costmap, &costmap.data[0], cost_model, x, y, constraint, tf::Transform::getIdentity(), q)) return false;
+        queries.push_back(q);
+    }
+    return true;
+}
+
+// Random queries between free cells, to a disc of the given radius around the goal cell
+void randomQueries(const CostmapFile& costmap, const CostModel& cost_model, unsigned int n_query, double goal_radius, std::vector<Query>& queries)
+{
+    unsigned int attempts = 0;
+    while (queries.size() < n_query && ++attempts < 1000 * n_query)
+    {
+        unsigned int gx = 1 + rand() % (costmap.width - 2), gy = 1 + rand() % (costmap.height - 2);
+        unsigned int sx = 1 + rand() % (costmap.width - 2), sy = 1 + rand() % (costmap.height - 2);
+        if (costmap.data[costmap.width * gy + gx] != 0 || costmap.data[costmap.width * sy + sx] != 0) continue;
+
+        double wx = costmap.origin_x + (gx + 0.5) * costmap.resolution, wy = costmap.origin_y + (gy + 0.5) * costmap.resolution;
+        char constraint[256];
+        snprintf(constraint, sizeof(constraint), "(x-%f)^2+(y-%f)^2 < %f", wx, wy, goal_radius * goal_radius);
+
+        Query q;
+        makeQuery(costmap, &costmap.data[0], cost_model, costmap.origin_x + (sx + 0.5) * costmap.resolution,
+                  costmap.origin_y + (sy + 0.5) * costmap.resolution, constraint, tf::Transform::getIdentity(), q);
+        queries.push_back(q);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+// Cost of a plan as the planner sums it: the traversal time of every cell entered, times the step length [cells].
+// The plan runs between a goal cell and the start cell, so the cost is summed towards the start cell. Jump point
+// plans only have the turning points, the cells in between are on straight or diagonal lines.
+double planCost(const unsigned char* costmap, unsigned int width, const CostModel& cost_model,
+                const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, int mx_start, int my_start)
+{
+    if (plan_xs.empty()) return DBL_MAX;
+
+    std::vector<int> xs(plan_xs), ys(plan_ys);
+    if (xs.front() == mx_start && ys.front() == my_start)
+    {
+        std::reverse(xs.begin(), xs.end());
+        std::reverse(ys.begin(), ys.end());
+    }
+
+    double cost = 0;
+    for (unsigned int i = 1; i < xs.size(); ++i)
+    {
+        int x = xs[i-1], y = ys[i-1];
+        while (x != xs[i] || y != ys[i])
+        {
+            int dx = (xs[i] > x) - (xs[i] < x), dy = (ys[i] > y) - (ys[i] < y);
+            x += dx;
+            y += dy;
+            cost += cost_model.getTraversalTime(costmap[width * y + x]) * ((dx != 0 && dy != 0) ? 1.414213562 : 1.0);
+        }
+    }
+    return cost;
+}
+
+// Memory of the process [kB] from /proc/self/status: the current resident size (VmRSS) or its peak (VmHWM)
+long readMemory(const char* field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, strlen(field), field) == 0) return atol(line.c_str() + strlen(field) + 1);
+    }
+    return -1;
+}
+
+// Sets the peak resident size back to the current one (Linux 4.0 and later), after handing freed memory back to the system
+void resetPeakMemory()
+{
+    malloc_trim(0);
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+    std::vector<double> latencies; // [s] per query
+    std::vector<double> costs;     // per query, DBL_MAX without plan
+    double cells_expanded;         // mean per query
+    unsigned int open_list_peak;   // of all queries
+    long memory;                   // peak resident size above the one before the planner was created [kB], -1 if unknown
+    unsigned int n_found;
+};
+
+// Backends: the node storage and open list variants, the bidirectional, landmark and jump point searches, the anytime
+// search from epsilon 3 without a time limit, which ends with the optimal plan, and the 8-connected octile search kernel
+const unsigned int NUM_BACKENDS = 9;
+const char* BACKEND_NAMES[NUM_BACKENDS] = { "pointer", "flat/binary", "flat/quaternary", "flat/radix", "bidirectional", "landmarks", "jump_point", "anytime",
+                                            "kernel" };
+
+void runBackend(unsigned int b, const unsigned char* costmap, unsigned int width, unsigned int height,
+                const CostModel& cost_model, const std::vector<Query>& queries, Result& result)
+{
+    resetPeakMemory();
+    long memory_before = readMemory("VmRSS:");
+
+    AStarPlanner* planner;
+    if (b == 6) planner = new JumpPointPlanner(width, height);
+    else if (b == 8) planner = new SearchKernelPlanner(width, height);
+    else planner = new AStarPlanner(width, height);
+    planner->setCostmap(costmap);
+    planner->setCostModel(cost_model);
+    if (b <= 3)
+    {
+        AStarPlanner::OpenListType open_lists[] = { AStarPlanner::OPEN_LIST_BINARY, AStarPlanner::OPEN_LIST_BINARY,
+                                                    AStarPlanner::OPEN_LIST_QUATERNARY, AStarPlanner::OPEN_LIST_RADIX };
+        planner->setNodeStorage(b == 0 ? AStarPlanner::NODE_STORAGE_POINTER : AStarPlanner::NODE_STORAGE_FLAT);
+        planner->setOpenListType(open_lists[b]);
+    }
+    else if (b <= 5 || b == 7)
+    {
+        planner->setNodeStorage(AStarPlanner::NODE_STORAGE_FLAT);
+    }
+    planner->setBidirectional(b == 4);
+
+    LandmarkHeuristic landmarks;
+    if (b == 5)
+    {
+        double t_start = wallTime();
+        landmarks.build(costmap, width, height, cost_model, 8);
+        planner->setLandmarkHeuristic(&landmarks);
+        printf("  (landmarks built in %.1f ms)\n", 1000 * (wallTime() - t_start));
+    }
+
+    result.latencies.clear();
+    result.costs.clear();
+    result.cells_expanded = 0;
+    result.open_list_peak = 0;
+    result.n_found = 0;
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        const Query& q = queries[i];
+        std::vector<int> plan_xs, plan_ys;
+        unsigned int tier;
+
+        double t_start = wallTime();
+        planner->resize(width, height);
+        if (b == 7)
+        {
+            double epsilon = 3;
+            planner->planAnytime(q.mx_tier, q.my_tier, CostModel::NUM_GOAL_TIERS, q.mx_start, q.my_start, 0.5, DBL_MAX, plan_xs, plan_ys, tier, epsilon);
+        }
+        else
+        {
+            planner->planTiered(q.mx_tier, q.my_tier, CostModel::NUM_GOAL_TIERS, q.mx_start, q.my_start, plan_xs, plan_ys, tier);
+        }
+        result.latencies.push_back(wallTime() - t_start);
+
+        result.costs.push_back(planCost(costmap, width, cost_model, plan_xs, plan_ys, q.mx_start, q.my_start));
+        if (!plan_xs.empty()) ++result.n_found;
+        result.cells_expanded += planner->getStatistics().cells_expanded;
+        result.open_list_peak = std::max(result.open_list_peak, planner->getStatistics().open_list_peak);
+    }
+    result.cells_expanded /= std::max<size_t>(1, queries.size());
+
+    long peak = readMemory("VmHWM:");
+    result.memory = (peak >= 0 && memory_before >= 0) ? std::max(0L, peak - memory_before) : -1;
+
+    delete planner;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    unsigned int i = (unsigned int) ceil(p * values.size());
+    return values[std::max(1u, std::min(i, (unsigned int) values.size())) - 1];
+}
+
+// Runs all backends and compares their plan costs with those of the first (the original implementation)
+// @return The number of backends whose costs differ
+unsigned int benchmarkBackends(const unsigned char* costmap, unsigned int width, unsigned int height,
+                               const CostModel& cost_model, const std::vector<Query>& queries)
+{
+    printf("Planner per query [ms]:          p50      p90      p99      max   expanded  open peak  memory [MB]\n");
+
+    std::vector<Result> results(NUM_BACKENDS);
+    for (unsigned int b = 0; b < NUM_BACKENDS; ++b)
+    {
+        Result& r = results[b];
+        runBackend(b, costmap, width, height, cost_model, queries, r);
+        printf("  %-16s %12.3f %8.3f %8.3f %8.3f %10.0f %10u %12.1f  (%u/%zu found)\n", BACKEND_NAMES[b],
+               1000 * percentile(r.latencies, 0.5), 1000 * percentile(r.latencies, 0.9), 1000 * percentile(r.latencies, 0.99),
+               1000 * percentile(r.latencies, 1.0), r.cells_expanded, r.open_list_peak, r.memory / 1024.0, r.n_found, queries.size());
+    }
+
+    printf("\nPlan costs compared to %s:\n", BACKEND_NAMES[0]);
+    unsigned int n_failed = 0;
+    for (unsigned int b = 1; b < NUM_BACKENDS; ++b)
+    {
+        unsigned int n_differ = 0;
+        for (unsigned int i = 0; i < queries.size(); ++i)
+        {
+            double c0 = results[0].costs[i], c = results[b].costs[i];
+            if (c0 == DBL_MAX || c == DBL_MAX ? c0 != c : fabs(c - c0) > 1e-6 * std::max(1.0, c0))
+            {
+                if (n_differ == 0) printf("  %-16s query %u: %g instead of %g\n", BACKEND_NAMES[b], i, c, c0);
+                ++n_differ;
+            }
+        }
+        printf("  %-16s %s (%u of %zu queries differ)\n", BACKEND_NAMES[b], n_differ == 0 ? "equal" : "DIFFERENT", n_differ, queries.size());
+        if (n_differ > 0) ++n_failed;
+    }
+    return n_failed;
+}
+
+void printUsage()
+{
+    printf("Usage: a_star_planner_benchmark [width] [height] [queries]\n"
+           "       a_star_planner_benchmark --map <map.yaml | costmap.pgm> [options]\n\n"
+           "  --queries <file>          'start_x start_y constraint' per line, map frame [m]\n"
+           "  --random <n>              n random queries (default 20, without --queries)\n"
+           "  --goal_radius <m>         radius of the goal disc of random queries (default 0.3)\n"
+           "  --resolution <m>          resolution of a costmap.pgm dump (default 0.05)\n"
+           "  --inscribed_radius <m>    inflation of YAML maps like the costmap inflation layer (default 0.2)\n"
+           "  --inflation_radius <m>    (default 0.5, 0: no inflation)\n"
+           "  --cost_scaling_factor <f> (default 10)\n\n"
+           "       a_star_planner_benchmark --snapshot <file> [--repeat n]\n\n"
+           "  Replays a plan request recorded by the global planner interface (snapshots/enabled), n times (default 10)\n\n"
+           "Exits with 1 if the plan costs of the planner backends differ.\n");
+}
+
+// Recorded costmap and queries
+int benchmarkMap(int argc, char** argv)
+{
+    std::string map_file, query_file;
+    unsigned int n_random = 20;
+    double goal_radius = 0.3, pgm_resolution = 0.05;
+    double inscribed_radius = 0.2, inflation_radius = 0.5, cost_scaling_factor = 10;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--map") map_file = argv[i + 1];
+        else if (option == "--queries") query_file = argv[i + 1];
+        else if (option == "--random") n_random = atoi(argv[i + 1]);
+        else if (option == "--goal_radius") goal_radius = atof(argv[i + 1]);
+        else if (option == "--resolution") pgm_resolution = atof(argv[i + 1]);
+        else if (option == "--inscribed_radius") inscribed_radius = atof(argv[i + 1]);
+        else if (option == "--inflation_radius") inflation_radius = atof(argv[i + 1]);
+        else if (option == "--cost_scaling_factor") cost_scaling_factor = atof(argv[i + 1]);
+        else { printUsage(); return 2; }
+    }
+    if (map_file.empty() || argc % 2 == 0) { printUsage(); return 2; }
+
+    CostmapFile costmap;
+    if (!loadCostmap(map_file, pgm_resolution, costmap)) return 2;
+    if (costmap.width < 3 || costmap.height < 3) { fprintf(stderr, "'%s' is too small\n", map_file.c_str()); return 2; }
+
+    // Dumps are costmaps already, maps get the inflation of the global costmap
+    bool is_dump = map_file.size() > 4 && map_file.compare(map_file.size() - 4, 4, ".pgm") == 0;
+    if (!is_dump) inflateCostmap(costmap, inscribed_radius, inflation_radius, cost_scaling_factor);
+
+    CostModel cost_model;
+    std::vector<Query> queries;
+    if (!query_file.empty())
+    {
+        if (!readQueries(query_file, costmap, cost_model, queries)) return 2;
+    }
+    else
+    {
+        srand(42);
+        randomQueries(costmap, cost_model, n_random, goal_radius, queries);
+    }
+
+    printf("Costmap '%s': %u x %u cells of %.3f m, %zu queries\n\n", map_file.c_str(), costmap.width, costmap.height, costmap.resolution, queries.size());
+    return benchmarkBackends(&costmap.data[0], costmap.width, costmap.height, cost_model, queries) > 0 ? 1 : 0;
+}
+
+// Plan request recorded by the global planner interface, its costmap is planned on in the file mapping
+int benchmarkSnapshot(int argc, char** argv)
+{
+    if (argc != 3 && !(argc == 5 && strcmp(argv[3], "--repeat") == 0)) { printUsage(); return 2; }
+    unsigned int repeat = argc == 5 ? std::max(1, atoi(argv[4])) : 10;
+
+    PlanSnapshot snapshot;
+    if (!snapshot.map(argv[2])) return 2;
+    const PlanSnapshot::Info& info = snapshot.info;
+    if (info.width < 3 || info.height < 3) { fprintf(stderr, "'%s' is too small\n", argv[2]); return 2; }
+
+    printf("Snapshot '%s' of %.3f: %u x %u cells of %.3f m in '%s'\n", argv[2], info.stamp, info.width, info.height, info.resolution,
+           snapshot.global_frame.c_str());
+    printf("  robot (%.3f, %.3f, %.3f), constraint '%s' in '%s'", info.robot_x, info.robot_y, info.robot_yaw,
+           snapshot.constraint.c_str(), snapshot.constraint_frame.c_str());
+    if (info.has_frame_pose) printf(" at (%.3f, %.3f, %.3f)", info.frame_x, info.frame_y, info.frame_yaw);
+    printf("\n  recorded: %s, %u poses, planned in %.3f ms\n\n", info.succes ? "succes" : "failure", info.plan_size, 1000 * info.planning_time);
+
+    CostmapFile geometry;
+    geometry.width = info.width;
+    geometry.height = info.height;
+    geometry.resolution = info.resolution;
+    geometry.origin_x = info.origin_x;
+    geometry.origin_y = info.origin_y;
+
+    tf::Transform world_to_constraint = tf::Transform::getIdentity();
+    if (info.has_frame_pose)
+        world_to_constraint = tf::Transform(tf::createQuaternionFromYaw(info.frame_yaw), tf::Vector3(info.frame_x, info.frame_y, 0));
+
+    CostModel cost_model;
+    Query q;
+    if (!makeQuery(geometry, snapshot.getCostmap(), cost_model, info.robot_x, info.robot_y, snapshot.constraint, world_to_constraint, q)) return 2;
+
+    std::vector<Query> queries(repeat, q);
+    return benchmarkBackends(snapshot.getCostmap(), info.width, info.height, cost_model, queries) > 0 ? 1 : 0;
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strncmp(argv[1], "--", 2) == 0)
+    {
+        if (strcmp(argv[1], "--help") == 0) { printUsage(); return 0; }
+        if (strcmp(argv[1], "--snapshot") == 0) return benchmarkSnapshot(argc, argv);
+        return benchmarkMap(argc, argv);
+    }
+
+    unsigned int width   = argc > 1 ? atoi(argv[1]) : 1000;
+    unsigned int height  = argc > 2 ? atoi(argv[2]) : 1000;
+    unsigned int n_query = argc > 3 ? atoi(argv[3]) : 20;
+
+    srand(42);
+
+    std::vector<unsigned char> costmap;
+    generateCostmap(width, height, costmap);
+
+    // Random start / goal queries on free cells
+    std::vector<Query> queries;
+    while (queries.size() < n_query)
+    {
+        Query q;
+        unsigned int gx = 1 + rand() % (width - 2), gy = 1 + rand() % (height - 2);
+        q.mx_start = 1 + rand() % (width - 2);
+        q.my_start = 1 + rand() % (height - 2);
+        if (costmap[width * gy + gx] != 0 || costmap[width * q.my_start + q.mx_start] != 0) continue;
+        q.mx_tier[0].push_back(gx);
+        q.my_tier[0].push_back(gy);
+        queries.push_back(q);
+    }
+
+    printf("Costmap %u x %u, %u queries\n\n", width, height, n_query);
+
+    // 1) Visited map layout: reset + scattered access, as done per plan() call
+    std::vector<unsigned int> probes(width * height / 10);
+    for (unsigned int i = 0; i < probes.size(); ++i)
+        probes[i] = rand() % (width * height);
+
+    unsigned int repetitions = std::max(1u, 20000000u / (width * height));
+    printf("Visited map (realloc + reset + %zu probes):\n", probes.size());
+    printf("  double** [x][y], reallocated: %8.3f ms\n", 1000 * benchmarkColumnLayout(width, height, probes, repetitions));
+    printf("  contiguous row-major:         %8.3f ms\n\n", 1000 * benchmarkRowMajorLayout(width, height, probes, repetitions));
+
+    // 2) Full planner per backend
+    return benchmarkBackends(&costmap[0], width, height, CostModel(), queries) > 0 ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+#include "costmap_file.h"
+
+#include "cb_base_navigation/costmap_layers/clearance_layer.h"
+
+#include <costmap_2d/cost_values.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace cb_global_planner {
+
+namespace {
+
+std::string trim(const std::string& s)
+{
+    std::string::size_type begin = s.find_first_not_of(" \t\r\n\"'");
+    if (begin == std::string::npos) return "";
+    std::string::size_type end = s.find_last_not_of(" \t\r\n\"'");
+    return s.substr(begin, end - begin + 1);
+}
+
+// The map_server YAML files are flat 'key: value' lists
+bool readYaml(const std::string& filename, std::map<std::string, std::string>& values)
+{
+    std::ifstream file(filename.c_str());
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::string::size_type colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        values[trim(line.substr(0, colon))] = trim(line.substr(colon + 1));
+    }
+    return true;
+}
+
+// Next header token of a PGM file, skipping comments
+bool readPgmToken(std::istream& in, std::string& token)
+{
+    token.clear();
+    while (in)
+    {
+        int c = in.get();
+        if (c == '#')
+        {
+            std::string comment;
+            std::getline(in, comment);
+        }
+        else if (isspace(c) || c == EOF)
+        {
+            if (!token.empty()) return true;
+        }
+        else
+        {
+            token += (char) c;
+        }
+    }
+    return !token.empty();
+}
+
+// Pixels of a P2 (ASCII) or P5 (binary) PGM file, scaled to 0 .. 255, in file order
+bool readPgm(const std::string& filename, unsigned int& width, unsigned int& height, std::vector<unsigned char>& pixels)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) { fprintf(stderr, "Cannot open '%s'\n", filename.c_str()); return false; }
+
+    std::string magic, w, h, max;
+    if (!readPgmToken(file, magic) || !readPgmToken(file, w) || !readPgmToken(file, h) || !readPgmToken(file, max)
+            || (magic != "P2" && magic != "P5"))
+    {
+        fprintf(stderr, "'%s' is not a PGM file\n", filename.c_str());
+        return false;
+    }
+
+    width = atoi(w.c_str());
+    height = atoi(h.c_str());
+    int max_value = atoi(max.c_str());
+    if (width == 0 || height == 0 || max_value <= 0 || max_value > 255)
+    {
+        fprintf(stderr, "'%s': unsupported PGM size or maximum value\n", filename.c_str());
+        return false;
+    }
+
+    pixels.resize(width * height);
+    if (magic == "P5")
+    {
+        file.read((char*) &pixels[0], pixels.size());
+    }
+    else
+    {
+        for (unsigned int i = 0; i < pixels.size() && file; ++i)
+        {
+            int value;
+            file >> value;
+            pixels[i] = (unsigned char) std::max(0, std::min(max_value, value));
+        }
+    }
+    if (!file) { fprintf(stderr, "'%s' is truncated\n", filename.c_str()); return false; }
+
+    if (max_value != 255)
+    {
+        for (unsigned int i = 0; i < pixels.size(); ++i) pixels[i] = (unsigned char) (pixels[i] * 255 / max_value);
+    }
+    return true;
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool loadCostmap(const std::string& filename, double pgm_resolution, CostmapFile& costmap)
+{
+    std::string::size_type dot = filename.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+
+    if (extension == "pgm")
+    {
+        // Costmap2D::saveMap dump: costs, first row is y = 0
+        costmap.resolution = pgm_resolution;
+        costmap.origin_x = 0;
+        costmap.origin_y = 0;
+        return readPgm(filename, costmap.width, costmap.height, costmap.data);
+    }
+
+    std::map<std::string, std::string> values;
+    if (!readYaml(filename, values)) { fprintf(stderr, "Cannot open '%s'\n", filename.c_str()); return false; }
+    if (values["image"].empty() || values["resolution"].empty())
+    {
+        fprintf(stderr, "'%s' has no image or resolution\n", filename.c_str());
+        return false;
+    }
+
+    // The image is relative to the YAML file
+    std::string image = values["image"];
+    std::string::size_type slash = filename.find_last_of('/');
+    if (image[0] != '/' && slash != std::string::npos) image = filename.substr(0, slash + 1) + image;
+
+    costmap.resolution = atof(values["resolution"].c_str());
+
+    std::string origin = values["origin"];
+    std::replace(origin.begin(), origin.end(), '[', ' ');
+    std::replace(origin.begin(), origin.end(), ']', ' ');
+    std::replace(origin.begin(), origin.end(), ',', ' ');
+    std::istringstream origin_stream(origin);
+    costmap.origin_x = 0;
+    costmap.origin_y = 0;
+    origin_stream >> costmap.origin_x >> costmap.origin_y;
+
+    bool negate = atoi(values["negate"].c_str()) != 0;
+    double occupied_thresh = values["occupied_thresh"].empty() ? 0.65 : atof(values["occupied_thresh"].c_str());
+    double free_thresh = values["free_thresh"].empty() ? 0.196 : atof(values["free_thresh"].c_str());
+    bool raw = values["mode"] == "raw";
+    if (!values["mode"].empty() && values["mode"] != "raw" && values["mode"] != "trinary")
+        fprintf(stderr, "'%s': mode '%s' is read as trinary\n", filename.c_str(), values["mode"].c_str());
+
+    std::vector<unsigned char> pixels;
+    if (!readPgm(image, costmap.width, costmap.height, pixels)) return false;
+
+    // The first row of the image is the top of the map
+    costmap.data.resize(costmap.width * costmap.height);
+    for (unsigned int y = 0; y < costmap.height; ++y)
+    {
+        const unsigned char* row = &pixels[(costmap.height - 1 - y) * costmap.width];
+        for (unsigned int x = 0; x < costmap.width; ++x)
+        {
+            unsigned char& cost = costmap.data[costmap.width * y + x];
+            if (raw)
+            {
+                cost = row[x];
+                continue;
+            }
+
+            double occupancy = negate ? row[x] / 255.0 : (255 - row[x]) / 255.0;
+            if (occupancy > occupied_thresh)
+                cost = costmap_2d::LETHAL_OBSTACLE;
+            else if (occupancy < free_thresh)
+                cost = costmap_2d::FREE_SPACE;
+            else
+                cost = costmap_2d::NO_INFORMATION;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void inflateCostmap(CostmapFile& costmap, double inscribed_radius, double inflation_radius, double cost_scaling_factor)
+{
+    if (inflation_radius <= 0 || costmap.data.empty()) return;
+
+    // Squared distances [cells] to the nearest lethal cell
+    std::vector<float> f(costmap.data.size());
+    for (unsigned int i = 0; i < f.size(); ++i) f[i] = (costmap.data[i] == costmap_2d::LETHAL_OBSTACLE) ? 0 : 1e20f;
+    cb_base_navigation::ClearanceLayer::distanceTransform(f, costmap.width, costmap.height);
+
+    for (unsigned int i = 0; i < f.size(); ++i)
+    {
+        unsigned char& cost = costmap.data[i];
+        if (cost == costmap_2d::LETHAL_OBSTACLE || cost == costmap_2d::NO_INFORMATION) continue;
+
+        double distance = sqrt(f[i]) * costmap.resolution;
+        if (distance > inflation_radius) continue;
+
+        unsigned char inflated;
+        if (distance <= inscribed_radius)
+            inflated = costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+        else
+            inflated = (unsigned char) ((costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1) * exp(-cost_scaling_factor * (distance - inscribed_radius)));
+        cost = std::max(cost, inflated);
+    }
+}
+
+}
@@ -0,0 +1,49 @@
+/*******************************
+ *                             *
+ *  Costmap files for the benchmarks (no roscore needed)
+ *                             *
+ *******************************/
+
+#ifndef cb_global_planner_COSTMAP_FILE_H_
+#define cb_global_planner_COSTMAP_FILE_H_
+
+#include <string>
+#include <vector>
+
+namespace cb_global_planner {
+
+/**
+ * @brief A recorded costmap: row-major cell values (width * y + x) like Costmap2D::getCharMap(), and its geometry
+ */
+struct CostmapFile
+{
+    unsigned int width, height;
+    double resolution;          // [m]
+    double origin_x, origin_y;  // of the corner of cell (0, 0) [m]
+    std::vector<unsigned char> data;
+
+    CostmapFile() : width(0), height(0), resolution(1), origin_x(0), origin_y(0) {}
+};
+
+/**
+ * @brief Loads a costmap from a map_server YAML file or from a Costmap2D::saveMap dump
+ *
+ *  - *.yaml: the map_server format (image, resolution, origin, negate, occupied_thresh, free_thresh). The image
+ *    is a PGM whose first row is the top of the map. With 'mode: raw' the pixel values are the costs, otherwise
+ *    the map is trinary: lethal, free and no information.
+ *  - *.pgm: a dump of Costmap2D::saveMap, the pixel values are the costs and the first row is y = 0. A dump has
+ *    no geometry, the resolution is the given one and the origin is (0, 0).
+ *
+ * @return False (with a message on stderr) if the file cannot be read
+ */
+bool loadCostmap(const std::string& filename, double pgm_resolution, CostmapFile& costmap);
+
+/**
+ * @brief Inflates the lethal cells like the costmap_2d inflation layer does (lethal, inscribed, exponential decay)
+ * @param inscribed_radius, inflation_radius [m], nothing is inflated if the inflation radius is not positive
+ */
+void inflateCostmap(CostmapFile& costmap, double inscribed_radius, double inflation_radius, double cost_scaling_factor);
+
+}
+
+#endif /* COSTMAP_FILE_H_ */
@@ -1,14 +1,18 @@
 #include "a_star_planner.h"
 
+#include <stdlib.h> // for posix_memalign
+#include <time.h>
+
 using namespace std;
 
 namespace cb_global_planner {
 
 long AStarPlanner::N_OBJECTS = 0;
 
-long AStarPlanner::CellInfo::N_OBJECTS = 0;
 
-AStarPlanner::AStarPlanner(int width, int height) : visited_map_(0) {
+AStarPlanner::AStarPlanner(int width, int height) : visited_map_(0), width_(0), height_(0), node_storage_(NODE_STORAGE_POINTER),
+	open_list_type_(OPEN_LIST_BINARY), reset_time_per_cell_(0), bidirectional_(false), set_penalty_(0),
+	landmarks_(0), landmarks_set_(0) {
 	resize(width, height);
 	++N_OBJECTS;
 }
@@ -29,60 +33,221 @@ void AStarPlanner::setCostmap(const unsigned char* char_cost_map) {
 }
 
 double AStarPlanner::getCost(int x, int y) {
-	int k = width_ * y + x;
-
-    unsigned char cost = char_cost_map_[k];
-
-    if (cost == 255)
-    //    cost = 0;
-        return DBL_MAX; // Do not plan through unknown space
-
-    double cell_pass_through_time = DBL_MAX;
-
-    if (cost != 253 && cost != 254)
-    {
-        double max_vel = (1 - (double) cost / 256) * 1.0; //max_velocity_;
-        cell_pass_through_time = 1 / max_vel; // cell_size
-    }
-
-	//printf("k = %d, cost = %f\n", k, cell_pass_through_time);
-
-    return cell_pass_through_time;
+	return cost_model_.getTraversalTime(char_cost_map_[width_ * y + x]);
 }
 
 void AStarPlanner::resize(int width, int height) {
-	if (visited_map_) {
-		deleteMap();
+	// makePlan resizes on every request, only reallocate if the dimensions actually changed
+	if ((unsigned int) width == width_ && (unsigned int) height == height_) {
+		return;
 	}
 
+	// the visited map is only used by the pointer node storage, planPointer allocates it for the new size
+	deleteMap();
+
 	width_ = width;
 	height_ = height;
 
-	visited_map_ = new double*[width_];
-	for(unsigned int i = 0; i < width_; ++i) {
-		visited_map_[i] = new double[height_];
+	setLandmarkHeuristic(landmarks_set_);
+
+	resizeFlatNodes();
+}
+
+void AStarPlanner::allocateVisitedMap() {
+	// one contiguous, cache line aligned buffer in the same row-major layout as the costmap char map
+	void* buffer = 0;
+	if (posix_memalign(&buffer, CACHE_LINE_SIZE, std::max(1u, width_ * height_) * sizeof(double)) != 0) {
+		throw std::bad_alloc();
 	}
+	visited_map_ = static_cast<double*>(buffer);
 
 	// to make sure the algorithm won't expand off the map, mark all border cells as visited
 	// todo: this limits the search space: border cells can now not be used in the solution. FIX
 	for(unsigned int x = 0; x < width_; ++x) {
-		visited_map_[x][0] = 0;
-		visited_map_[x][height_ - 1] = 0;
+		visited_map_[x] = 0;
+		visited_map_[width_ * (height_ - 1) + x] = 0;
 	}
 
 	for(unsigned int y = 0; y < height_; ++y) {
-		visited_map_[0][y] = 0;
-		visited_map_[width_ - 1][y] = 0;
+		visited_map_[width_ * y] = 0;
+		visited_map_[width_ * y + width_ - 1] = 0;
 	}
 }
 
+void AStarPlanner::setLandmarkHeuristic(const LandmarkHeuristic* landmarks) {
+	landmarks_set_ = landmarks;
+	bool matches = landmarks && landmarks->getNumLandmarks() > 0 && landmarks->getWidth() == width_ && landmarks->getHeight() == height_;
+	landmarks_ = matches ? landmarks : 0;
+}
+
 bool AStarPlanner::plan(std::vector<unsigned int> mx_start, std::vector<unsigned int> my_start, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	if (usesFlatNodes()) {
+		return planFlat(&mx_start, &my_start, 1, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+	return planPointer(mx_start, my_start, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+}
+
+bool AStarPlanner::planTiered(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier) {
+	if (!usesFlatNodes()) {
+		for (tier = 0; tier < num_sets; ++tier) {
+			if (planPointer(mx_starts[tier], my_starts[tier], mx_goal, my_goal, plan_xs, plan_ys, false)) return true;
+		}
+		return false;
+	}
+
+	if (!planFlat(mx_starts, my_starts, num_sets, mx_goal, my_goal, plan_xs, plan_ys, false)) return false;
+
+	// the plan ends in a start cell, whose g is the penalty of its set
+	tier = 0;
+	if (set_penalty_ > 0) {
+		tier = (unsigned int) (getStartCost(plan_xs.back(), plan_ys.back()) / set_penalty_ + 0.5);
+	}
+	return true;
+}
+
+bool AStarPlanner::planBatch(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_queries, unsigned int num_sets,
+		int mx_goal, int my_goal, std::vector<double>& costs, std::vector<unsigned int>& tiers,
+		std::vector<std::vector<int> >* plans_xs, std::vector<std::vector<int> >* plans_ys, std::vector<double>* lengths) {
+	static const int DX[8] = { -1, +1,  0,  0, -1, +1, -1, +1 };
+	static const int DY[8] = {  0,  0, -1, +1, -1, -1, +1, +1 };
+	static const double FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, SQRT2, SQRT2, SQRT2, SQRT2 };
+
+	costs.assign(num_queries, DBL_MAX);
+	tiers.assign(num_queries, num_sets);
+	std::vector<int> end_cells(num_queries, -1);
+
+	unsigned int n = width_ * height_;
+	if (batch_marks_.size() != n) batch_marks_.assign(n, 0);
+
+	batch_starts_.clear();
+	for (unsigned int q = 0; q < num_queries; ++q) {
+		for (unsigned int t = 0; t < num_sets; ++t) {
+			const std::vector<unsigned int>& mx_start = mx_starts[q * num_sets + t];
+			const std::vector<unsigned int>& my_start = my_starts[q * num_sets + t];
+			for (unsigned int i = 0; i < mx_start.size(); ++i) {
+				if (mx_start[i] > 0 && mx_start[i] < width_-1 && my_start[i] > 0 && my_start[i] < height_-1) {
+					int k = width_ * my_start[i] + mx_start[i];
+					batch_starts_.push_back(BatchStart(k, q, t));
+					batch_marks_[k] = 1;
+				}
+			}
+		}
+	}
+	std::sort(batch_starts_.begin(), batch_starts_.end());
+
+	// The search runs from the goal cell, so a step costs the traversal time of the cell it leaves: the
+	// reverse of the steps of planTiered, which cost the traversal time of the cell they enter
+	nodes_.reset();
+	anytime_.valid = false;
+	BinaryOpenList& open = binary_open_;
+	open.prepare(n);
+
+	if (mx_goal > 0 && mx_goal < (int) width_-1 && my_goal > 0 && my_goal < (int) height_-1) {
+		int k_goal = width_ * my_goal + mx_goal;
+		nodes_.touch(k_goal);
+		nodes_.g(k_goal) = 0;
+		open.push(k_goal, 0);
+	}
+
+	unsigned int unsettled = num_queries;
+	unsigned int cells_expanded = 0;
+	unsigned int open_list_peak = open.size();
+
+	while (!open.empty() && unsettled > 0) {
+		int k = open.top();
+		open.pop();
+
+		if (nodes_.isClosed(k)) continue;
+		nodes_.close(k);
+		++cells_expanded;
+
+		// cells are closed in order of cost: the first start cell of a set is the cheapest one of that set,
+		// and only a start cell of an earlier set improves a query afterwards
+		if (batch_marks_[k]) {
+			std::vector<BatchStart>::const_iterator it = std::lower_bound(batch_starts_.begin(), batch_starts_.end(), BatchStart(k, 0, 0));
+			for (; it != batch_starts_.end() && it->k == k; ++it) {
+				if (it->set >= tiers[it->query]) continue;
+				if (it->set == 0) --unsettled;
+				tiers[it->query] = it->set;
+				costs[it->query] = nodes_.g(k);
+				end_cells[it->query] = k;
+			}
+		}
+
+		// only start cells are entered without being traversable, they are not left
+		double traversal_time = cost_model_.getTraversalTime(char_cost_map_[k]);
+		if (traversal_time == DBL_MAX) continue;
+
+		int x = k % width_;
+		int y = k / width_;
+		for (unsigned int d = 0; d < 8; ++d) {
+			int k_child = width_ * (y + DY[d]) + x + DX[d];
+			if (!nodes_.touch(k_child) || nodes_.isClosed(k_child)) continue;
+
+			double g_child = nodes_.g(k) + traversal_time * FACTOR[d];
+			if (g_child < nodes_.g(k_child)) {
+				nodes_.g(k_child) = g_child;
+				nodes_.parent(k_child) = k;
+				open.push(k_child, g_child);
+			}
+		}
+
+		open_list_peak = std::max(open_list_peak, open.size());
+	}
+
+	for (unsigned int i = 0; i < batch_starts_.size(); ++i) batch_marks_[batch_starts_[i].k] = 0;
+
+	if (plans_xs && plans_ys) {
+		plans_xs->assign(num_queries, std::vector<int>());
+		plans_ys->assign(num_queries, std::vector<int>());
+		for (unsigned int q = 0; q < num_queries; ++q) {
+			std::vector<int>& plan_xs = (*plans_xs)[q];
+			std::vector<int>& plan_ys = (*plans_ys)[q];
+			for (int trace_cell = end_cells[q]; trace_cell >= 0; trace_cell = nodes_.parent(trace_cell)) {
+				plan_xs.push_back(trace_cell % width_);
+				plan_ys.push_back(trace_cell / width_);
+			}
+			std::reverse(plan_xs.begin(), plan_xs.end());
+			std::reverse(plan_ys.begin(), plan_ys.end());
+		}
+	}
+
+	if (lengths) {
+		// the parents, without building the plans: a step is straight if it stays in the row or the column
+		lengths->assign(num_queries, -1);
+		for (unsigned int q = 0; q < num_queries; ++q) {
+			if (end_cells[q] < 0) continue;
+
+			double length = 0;
+			for (int k = end_cells[q]; nodes_.parent(k) >= 0; k = nodes_.parent(k)) {
+				int k_parent = nodes_.parent(k);
+				length += (k % width_ == k_parent % width_ || k / width_ == k_parent / width_) ? 1.0 : SQRT2;
+			}
+			(*lengths)[q] = length;
+		}
+	}
+
+	finishStatistics(cells_expanded);
+	statistics_.open_list_peak = open_list_peak;
+
+	for (unsigned int q = 0; q < num_queries; ++q) {
+		if (end_cells[q] >= 0) return true;
+	}
+	return false;
+}
+
+bool AStarPlanner::planPointer(const std::vector<unsigned int>& mx_start, const std::vector<unsigned int>& my_start, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	if (!visited_map_) {
+		allocateVisitedMap();
+	}
+
 	// - initialize all cells in visited_map to false
 	// - determine minimum cell cost in cost map
-	double min_cell_cost = 1; //DBL_MAX;
-	for(unsigned int x = 1; x < width_ - 1; ++x) {
-		for(unsigned int y = 1; y < height_ - 1; ++y) {
-			visited_map_[x][y] = DBL_MAX;
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+	for(unsigned int y = 1; y < height_ - 1; ++y) {
+		double* row = visited_map_ + width_ * y;
+		for(unsigned int x = 1; x < width_ - 1; ++x) {
+			row[x] = DBL_MAX;
 			//min_cell_cost = min(getCost(x, y), min_cell_cost);
 		}
 	}
@@ -97,7 +262,7 @@ bool AStarPlanner::plan(std::vector<unsigned int> mx_start, std::vector<unsigned
         if (mx_start[i] > 0 && mx_start[i] < width_-1 && my_start[i] > 0 && my_start[i] < height_-1)
         {
             CellInfo* start = new CellInfo(mx_start[i], my_start[i], 0, calculateHeuristicCost(mx_start[i], my_start[i], mx_goal, my_goal, min_cell_cost));
-            visited_map_[mx_start[i]][my_start[i]] = 0;
+            visited_map_[width_ * my_start[i] + mx_start[i]] = 0;
             Q.push(start);
         }
     }
@@ -137,7 +302,8 @@ bool AStarPlanner::plan(std::vector<unsigned int> mx_start, std::vector<unsigned
 		}
 	}
 
-    // Path to goal found
+    // Path to goal found (the trace below consumes goal_cell)
+	bool found = (goal_cell != 0);
 	if (goal_cell) {
 		while(goal_cell) {
 			plan_xs.push_back(goal_cell->x_);
@@ -166,15 +332,20 @@ bool AStarPlanner::plan(std::vector<unsigned int> mx_start, std::vector<unsigned
         }
     }
 
+	// the whole visited map is reset up front in this mode
+	statistics_ = SearchStatistics();
+	statistics_.cells_touched = width_ * height_;
+	statistics_.cells_expanded = visited_cells.size();
+
 	// delete visted CellInfos
 	for(list<CellInfo*>::iterator it = visited_cells.begin(); it != visited_cells.end(); ++it) {
 		delete *it;
 	}
 
-	return (goal_cell != 0);
+	return found;
 }
 
-void AStarPlanner::expandCell(CellInfo* c, int dx, int dy, double cost_factor, double** visited_map,
+void AStarPlanner::expandCell(CellInfo* c, int dx, int dy, double cost_factor, double* visited_map,
 			int x_goal, int y_goal, double min_cell_cost,
 			priority_queue<CellInfo*, vector<CellInfo*>, compareCellInfos>& Q) {
 
@@ -182,26 +353,591 @@ void AStarPlanner::expandCell(CellInfo* c, int dx, int dy, double cost_factor, d
 	int y = c->y_ + dy;
 
 	double g_child = c->g_ + getCost(x, y) * cost_factor;
-	if (g_child < visited_map[x][y]) {
+	int k = width_ * y + x;
+	if (g_child < visited_map[k]) {
 		CellInfo* c_child = new CellInfo(x, y, g_child, calculateHeuristicCost(x, y, x_goal, y_goal, min_cell_cost));
 		c_child->visited_from_ = c;
 		Q.push(c_child);
-		visited_map_[x][y] = g_child;
+		visited_map[k] = g_child;
+	}
+}
+
+namespace {
+
+double wallTime() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+}
+
+void AStarPlanner::resizeFlatNodes() {
+	// flat node storage; allocated here once so that plan() itself does not allocate.
+	// The initial full clear is timed to estimate what the lazy reset saves per query.
+	double t_start = wallTime();
+	nodes_.resize(width_ * height_);
+	anytime_.valid = false;
+	reset_time_per_cell_ = (wallTime() - t_start) / std::max(1u, width_ * height_);
+
+	blockBorder(nodes_);
+
+	// the reverse search is only allocated by a bidirectional plan
+	if (reverse_nodes_.size() > 0) {
+		reverse_nodes_.resize(width_ * height_);
+		blockBorder(reverse_nodes_);
+	}
+}
+
+void AStarPlanner::blockBorder(SearchNodes& nodes) {
+	// same border trick as the visited map: border cells are never entered
+	for(unsigned int x = 0; x < width_; ++x) {
+		nodes.block(x);
+		nodes.block(width_ * (height_ - 1) + x);
+	}
+	for(unsigned int y = 0; y < height_; ++y) {
+		nodes.block(width_ * y);
+		nodes.block(width_ * y + width_ - 1);
+	}
+}
+
+void AStarPlanner::finishStatistics(unsigned int cells_expanded) {
+	statistics_.cells_touched = nodes_.getCellsTouched();
+	statistics_.cells_expanded = cells_expanded;
+	statistics_.cells_expanded_reverse = 0;
+	statistics_.cells_reset_skipped = width_ * height_ - statistics_.cells_touched;
+	statistics_.reset_time_saved = statistics_.cells_reset_skipped * reset_time_per_cell_;
+}
+
+void AStarPlanner::seedStarts(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets) {
+	// A penalty above any path cost makes the search lexicographic in (set, cost). Set 0 gets no
+	// penalty, so a plan from the first set is exactly the plan of a search from that set alone.
+	set_penalty_ = 0;
+	if (num_sets > 1) {
+		set_penalty_ = (cost_model_.getMaxTraversalTime() * SQRT2 + 1) * width_ * height_;
+	}
+
+	nodes_.reset();
+	anytime_.valid = false;
+	starts_.clear();
+
+	for (unsigned int t = 0; t < num_sets; ++t) {
+		const std::vector<unsigned int>& mx_start = mx_starts[t];
+		const std::vector<unsigned int>& my_start = my_starts[t];
+		for (unsigned int i = 0; i < mx_start.size(); ++i) {
+			if (mx_start[i] > 0 && mx_start[i] < width_-1 && my_start[i] > 0 && my_start[i] < height_-1) {
+				int k = width_ * my_start[i] + mx_start[i];
+				nodes_.touch(k);
+				if (nodes_.g(k) != DBL_MAX) continue; // duplicate start, the earliest set keeps it
+
+				nodes_.g(k) = t * set_penalty_;
+				starts_.push_back(k);
+			}
+		}
+	}
+}
+
+bool AStarPlanner::planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	seedStarts(mx_starts, my_starts, num_sets);
+
+	if (bidirectional_) {
+		switch (open_list_type_) {
+		case OPEN_LIST_QUATERNARY:
+			return planBidirectional(quaternary_open_, reverse_quaternary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+		case OPEN_LIST_RADIX:
+			return planBidirectional(radix_open_, reverse_radix_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+		default:
+			return planBidirectional(binary_open_, reverse_binary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+		}
+	}
+
+	switch (open_list_type_) {
+	case OPEN_LIST_QUATERNARY:
+		return planFlat(quaternary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	case OPEN_LIST_RADIX:
+		return planFlat(radix_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	default:
+		return planFlat(binary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+}
+
+template <class OpenList>
+bool AStarPlanner::planFlat(OpenList& open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+
+	open.prepare(width_ * height_);
+
+	// add start points to the open list
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		int k = starts_[i];
+		open.push(k, nodes_.g(k) + calculateHeuristicCost(k % width_, k / width_, mx_goal, my_goal, min_cell_cost));
+	}
+
+	int k_goal = width_ * my_goal + mx_goal;
+	int goal_cell = -1;
+	int best_cell = -1;
+
+	double best_score = 1e9;
+
+	unsigned int cells_expanded = 0;
+	unsigned int open_list_peak = open.size();
+
+	while(!open.empty()) {
+		int k = open.top();
+		double f = open.topKey();
+		open.pop();
+
+		// skip stale entries of cells that were already expanded via a cheaper path (lazy open lists)
+		if (nodes_.isClosed(k)) continue;
+		nodes_.close(k);
+		++cells_expanded;
+
+		if (k == k_goal) {
+			goal_cell = k;
+			break;
+		}
+
+		int x = k % width_;
+		int y = k / width_;
+
+		double h = f - nodes_.g(k);
+		if (h < best_score) {
+			best_cell = k;
+			best_score = h;
+		}
+
+		// direct adjacent expansion
+		expandFlatCell(open, k, x, y, -1, 0, 1.0, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, +1, 0, 1.0, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, 0, -1, 1.0, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, 0, +1, 1.0, mx_goal, my_goal, min_cell_cost);
+
+		// diagonal expansion
+		expandFlatCell(open, k, x, y, -1, -1, SQRT2, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, +1, -1, SQRT2, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, -1, +1, SQRT2, mx_goal, my_goal, min_cell_cost);
+		expandFlatCell(open, k, x, y, +1, +1, SQRT2, mx_goal, my_goal, min_cell_cost);
+
+		open_list_peak = std::max(open_list_peak, open.size());
+	}
+
+	int trace_cell = goal_cell;
+	if (trace_cell < 0 && best_heuristic) {
+		trace_cell = best_cell;
+	}
+
+	for(; trace_cell >= 0; trace_cell = nodes_.parent(trace_cell)) {
+		plan_xs.push_back(trace_cell % width_);
+		plan_ys.push_back(trace_cell / width_);
+	}
+
+	finishStatistics(cells_expanded);
+	statistics_.open_list_peak = open_list_peak;
+
+	return (goal_cell >= 0);
+}
+
+template <class OpenList>
+bool AStarPlanner::planBidirectional(OpenList& open, OpenList& reverse_open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	static const int DX[8] = { -1, +1,  0,  0, -1, +1, -1, +1 };
+	static const int DY[8] = {  0,  0, -1, +1, -1, -1, +1, +1 };
+	static const double FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, SQRT2, SQRT2, SQRT2, SQRT2 };
+
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+
+	if (reverse_nodes_.size() != nodes_.size()) {
+		reverse_nodes_.resize(nodes_.size());
+		blockBorder(reverse_nodes_);
+	}
+	reverse_nodes_.reset();
+
+	open.prepare(width_ * height_);
+	reverse_open.prepare(width_ * height_);
+
+	// the search from the goal aims at the bounding box of the start cells
+	int x_min = width_, x_max = -1, y_min = height_, y_max = -1;
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		x_min = std::min(x_min, (int) (starts_[i] % width_)); x_max = std::max(x_max, (int) (starts_[i] % width_));
+		y_min = std::min(y_min, (int) (starts_[i] / width_)); y_max = std::max(y_max, (int) (starts_[i] / width_));
+	}
+
+	// Both searches use the average of the two heuristics, p(v) = (h_goal(v) - h_start(v)) / 2 and -p(v).
+	// These are consistent and sum to zero on the whole map, so the searches can stop as soon as the
+	// sum of their lowest keys reaches the best plan. The offset keeps the keys non-negative.
+	double offset = 0.5 * min_cell_cost * sqrt((double) width_ * width_ + (double) height_ * height_);
+	if (landmarks_) offset = std::max(offset, 0.5 * landmarks_->getMaxDistance());
+
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		int k = starts_[i];
+		open.push(k, nodes_.g(k) + offset + calculateAveragePotential(k % width_, k / width_, mx_goal, my_goal, x_min, y_min, x_max, y_max, min_cell_cost));
+	}
+
+	// best plan found so far: cost mu through the cell meet_cell
+	double mu = DBL_MAX;
+	int meet_cell = -1;
+
+	int k_goal = width_ * my_goal + mx_goal;
+	if (!starts_.empty() && reverse_nodes_.touch(k_goal)) {
+		reverse_nodes_.g(k_goal) = 0;
+		reverse_open.push(k_goal, offset - calculateAveragePotential(mx_goal, my_goal, mx_goal, my_goal, x_min, y_min, x_max, y_max, min_cell_cost));
+		if (nodes_.peekG(k_goal) < DBL_MAX) {
+			mu = nodes_.peekG(k_goal);
+			meet_cell = k_goal;
+		}
+	}
+
+	int best_cell = -1;
+	double best_score = 1e9;
+
+	unsigned int cells_expanded = 0;
+	unsigned int cells_expanded_reverse = 0;
+	unsigned int open_list_peak = open.size() + reverse_open.size();
+
+	while(!open.empty() && !reverse_open.empty()) {
+		// A plan cheaper than mu would pass an open cell of each search whose keys sum to less than mu
+		if (mu < DBL_MAX && open.topKey() + reverse_open.topKey() >= mu + 2 * offset) break;
+
+		// expand the smaller frontier
+		if (open.size() <= reverse_open.size()) {
+			int k = open.top();
+			open.pop();
+
+			if (nodes_.isClosed(k)) continue;
+			nodes_.close(k);
+			++cells_expanded;
+
+			int x = k % width_;
+			int y = k / width_;
+
+			if (best_heuristic) {
+				double h = calculateHeuristicCost(x, y, mx_goal, my_goal, min_cell_cost);
+				if (h < best_score) {
+					best_cell = k;
+					best_score = h;
+				}
+			}
+
+			for (unsigned int d = 0; d < 8; ++d) {
+				int x_child = x + DX[d];
+				int y_child = y + DY[d];
+				int k_child = width_ * y_child + x_child;
+
+				if (!nodes_.touch(k_child) || nodes_.isClosed(k_child)) continue;
+
+				double g_child = nodes_.g(k) + cost_model_.getTraversalTime(char_cost_map_[k_child]) * FACTOR[d];
+				if (g_child < nodes_.g(k_child)) {
+					nodes_.g(k_child) = g_child;
+					nodes_.parent(k_child) = k;
+					open.push(k_child, g_child + offset + calculateAveragePotential(x_child, y_child, mx_goal, my_goal, x_min, y_min, x_max, y_max, min_cell_cost));
+
+					double g_reverse = reverse_nodes_.peekG(k_child);
+					if (g_reverse < DBL_MAX && g_child + g_reverse < mu) {
+						mu = g_child + g_reverse;
+						meet_cell = k_child;
+					}
+				}
+			}
+		} else {
+			int k = reverse_open.top();
+			reverse_open.pop();
+
+			if (reverse_nodes_.isClosed(k)) continue;
+			reverse_nodes_.close(k);
+			++cells_expanded;
+			++cells_expanded_reverse;
+
+			int x = k % width_;
+			int y = k / width_;
+
+			// a step from a neighbour onto k costs the traversal time of k
+			double traversal_time = cost_model_.getTraversalTime(char_cost_map_[k]);
+			if (traversal_time == DBL_MAX) continue;
+
+			for (unsigned int d = 0; d < 8; ++d) {
+				int x_child = x + DX[d];
+				int y_child = y + DY[d];
+				int k_child = width_ * y_child + x_child;
+
+				if (!reverse_nodes_.touch(k_child) || reverse_nodes_.isClosed(k_child)) continue;
+
+				// only start cells are left from without being traversable
+				double g_forward = nodes_.peekG(k_child);
+				if (g_forward == DBL_MAX && cost_model_.getTraversalTime(char_cost_map_[k_child]) == DBL_MAX) continue;
+
+				double g_child = reverse_nodes_.g(k) + traversal_time * FACTOR[d];
+				if (g_child < reverse_nodes_.g(k_child)) {
+					reverse_nodes_.g(k_child) = g_child;
+					reverse_nodes_.parent(k_child) = k;
+					reverse_open.push(k_child, g_child + offset - calculateAveragePotential(x_child, y_child, mx_goal, my_goal, x_min, y_min, x_max, y_max, min_cell_cost));
+
+					if (g_forward < DBL_MAX && g_child + g_forward < mu) {
+						mu = g_child + g_forward;
+						meet_cell = k_child;
+					}
+				}
+			}
+		}
+
+		open_list_peak = std::max(open_list_peak, open.size() + reverse_open.size());
+	}
+
+	if (meet_cell >= 0) {
+		// goal .. meet_cell from the search from the goal, then meet_cell .. start from the search from the start
+		unsigned int i_begin = plan_xs.size();
+		for(int trace_cell = meet_cell; trace_cell >= 0; trace_cell = reverse_nodes_.parent(trace_cell)) {
+			plan_xs.push_back(trace_cell % width_);
+			plan_ys.push_back(trace_cell / width_);
+		}
+		std::reverse(plan_xs.begin() + i_begin, plan_xs.end());
+		std::reverse(plan_ys.begin() + i_begin, plan_ys.end());
+
+		for(int trace_cell = nodes_.parent(meet_cell); trace_cell >= 0; trace_cell = nodes_.parent(trace_cell)) {
+			plan_xs.push_back(trace_cell % width_);
+			plan_ys.push_back(trace_cell / width_);
+		}
+	} else if (best_heuristic) {
+		for(int trace_cell = best_cell; trace_cell >= 0; trace_cell = nodes_.parent(trace_cell)) {
+			plan_xs.push_back(trace_cell % width_);
+			plan_ys.push_back(trace_cell / width_);
+		}
+	}
+
+	// the search from the goal has its own node state
+	finishStatistics(cells_expanded);
+	statistics_.cells_touched += reverse_nodes_.getCellsTouched();
+	statistics_.cells_reset_skipped += width_ * height_ - reverse_nodes_.getCellsTouched();
+	statistics_.reset_time_saved = statistics_.cells_reset_skipped * reset_time_per_cell_;
+	statistics_.cells_expanded_reverse = cells_expanded_reverse;
+	statistics_.open_list_peak = open_list_peak;
+
+	return (meet_cell >= 0);
+}
+
+template <class OpenList>
+inline void AStarPlanner::expandFlatCell(OpenList& open, int k, int x, int y, int dx, int dy, double cost_factor,
+			int x_goal, int y_goal, double min_cell_cost) {
+
+	int x_child = x + dx;
+	int y_child = y + dy;
+	int k_child = width_ * y_child + x_child;
+
+	if (!nodes_.touch(k_child) || nodes_.isClosed(k_child)) return;
+
+	double g_child = nodes_.g(k) + cost_model_.getTraversalTime(char_cost_map_[k_child]) * cost_factor;
+	if (g_child < nodes_.g(k_child)) {
+		nodes_.g(k_child) = g_child;
+		nodes_.parent(k_child) = k;
+		open.push(k_child, g_child + calculateHeuristicCost(x_child, y_child, x_goal, y_goal, min_cell_cost));
+	}
+}
+
+bool AStarPlanner::planAnytime(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal,
+		double epsilon_step, double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier, double& epsilon) {
+	double deadline = wallTime() + time_budget;
+
+	seedStarts(mx_starts, my_starts, num_sets);
+
+	unsigned int n = width_ * height_;
+	if (anytime_.closed.size() != n) {
+		anytime_.closed.assign(n, 0);
+		anytime_.inconsistent.assign(n, 0);
+		anytime_.stamp = 0;
+	}
+	if (++anytime_.stamp == 0) {
+		std::fill(anytime_.closed.begin(), anytime_.closed.end(), 0);
+		std::fill(anytime_.inconsistent.begin(), anytime_.inconsistent.end(), 0);
+		anytime_.stamp = 1;
+	}
+
+	anytime_.epsilon = std::max(1.0, epsilon);
+	anytime_.epsilon_step = std::max(0.0, epsilon_step);
+	anytime_.k_goal = width_ * my_goal + mx_goal;
+	anytime_.open_cells.clear();
+	anytime_.inconsistent_cells.clear();
+
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+	binary_open_.prepare(n);
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		int k = starts_[i];
+		binary_open_.push(k, nodes_.g(k) + anytime_.epsilon * calculateHeuristicCost(k % width_, k / width_, mx_goal, my_goal, min_cell_cost));
+		anytime_.open_cells.push_back(k);
+	}
+	anytime_.valid = true;
+
+	// the first plan, whatever the time it takes
+	runAnytimeSearch(DBL_MAX);
+	anytime_.search_done = true;
+	if (nodes_.peekG(anytime_.k_goal) == DBL_MAX) {
+		anytime_.valid = false;
+		return false;
+	}
+
+	traceAnytimePlan();
+
+	if (!improveAnytime(deadline - wallTime(), plan_xs, plan_ys, tier, epsilon)) {
+		plan_xs = anytime_.plan_xs;
+		plan_ys = anytime_.plan_ys;
+		tier = anytime_.plan_tier;
+		epsilon = anytime_.plan_epsilon;
+	}
+	return true;
+}
+
+bool AStarPlanner::improveAnytime(double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier, double& epsilon) {
+	double deadline = wallTime() + time_budget;
+
+	bool improved = false;
+	while (anytime_.valid && wallTime() < deadline) {
+		if (anytime_.search_done) {
+			if (anytime_.epsilon == 1.0) break;
+			anytime_.epsilon = anytime_.epsilon_step > 0 ? std::max(1.0, anytime_.epsilon - anytime_.epsilon_step) : 1.0;
+			startAnytimeSearch();
+		}
+
+		if (!runAnytimeSearch(deadline)) break;
+		anytime_.search_done = true;
+
+		traceAnytimePlan();
+		improved = true;
+	}
+
+	if (improved) {
+		plan_xs = anytime_.plan_xs;
+		plan_ys = anytime_.plan_ys;
+		tier = anytime_.plan_tier;
+		epsilon = anytime_.plan_epsilon;
 	}
+	return improved;
+}
+
+void AStarPlanner::traceAnytimePlan() {
+	anytime_.plan_xs.clear();
+	anytime_.plan_ys.clear();
+	for(int k = anytime_.k_goal; k >= 0; k = nodes_.parent(k)) {
+		anytime_.plan_xs.push_back(k % width_);
+		anytime_.plan_ys.push_back(k / width_);
+	}
+	anytime_.plan_epsilon = anytime_.epsilon;
+
+	// the plan ends in a start cell, whose g is the penalty of its set; a better plan can end in another set
+	anytime_.plan_tier = 0;
+	if (set_penalty_ > 0) {
+		int k_start = width_ * anytime_.plan_ys.back() + anytime_.plan_xs.back();
+		anytime_.plan_tier = (unsigned int) (nodes_.g(k_start) / set_penalty_ + 0.5);
+	}
+}
+
+void AStarPlanner::startAnytimeSearch() {
+	// the open cells of the last search and the cells that became inconsistent in it, once each
+	std::vector<int> cells;
+	cells.reserve(anytime_.open_cells.size() + anytime_.inconsistent_cells.size());
+	for (unsigned int i = 0; i < anytime_.open_cells.size(); ++i) {
+		if (anytime_.closed[anytime_.open_cells[i]] != anytime_.stamp) cells.push_back(anytime_.open_cells[i]);
+	}
+	cells.insert(cells.end(), anytime_.inconsistent_cells.begin(), anytime_.inconsistent_cells.end());
+	std::sort(cells.begin(), cells.end());
+	cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+	if (++anytime_.stamp == 0) {
+		std::fill(anytime_.closed.begin(), anytime_.closed.end(), 0);
+		std::fill(anytime_.inconsistent.begin(), anytime_.inconsistent.end(), 0);
+		anytime_.stamp = 1;
+	}
+	anytime_.search_done = false;
+
+	int x_goal = anytime_.k_goal % width_, y_goal = anytime_.k_goal / width_;
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+	binary_open_.prepare(width_ * height_);
+	for (unsigned int i = 0; i < cells.size(); ++i) {
+		int k = cells[i];
+		binary_open_.push(k, nodes_.g(k) + anytime_.epsilon * calculateHeuristicCost(k % width_, k / width_, x_goal, y_goal, min_cell_cost));
+	}
+	anytime_.open_cells.swap(cells);
+	anytime_.inconsistent_cells.clear();
+}
+
+bool AStarPlanner::runAnytimeSearch(double deadline) {
+	static const int DX[8] = { -1, +1,  0,  0, -1, +1, -1, +1 };
+	static const int DY[8] = {  0,  0, -1, +1, -1, -1, +1, +1 };
+	static const double FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, SQRT2, SQRT2, SQRT2, SQRT2 };
+
+	// the clock is read every CHECK_INTERVAL expansions
+	static const unsigned int CHECK_INTERVAL = 256;
+
+	BinaryOpenList& open = binary_open_;
+	int x_goal = anytime_.k_goal % width_, y_goal = anytime_.k_goal / width_;
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+	unsigned int stamp = anytime_.stamp;
+
+	unsigned int cells_expanded = 0;
+	unsigned int open_list_peak = open.size();
+	bool done = true;
+
+	while(!open.empty()) {
+		int k = open.top();
+
+		// skip stale entries of cells that were already expanded in this search
+		if (anytime_.closed[k] == stamp) { open.pop(); continue; }
+
+		// the goal cannot be improved anymore by epsilon-bounded paths
+		if (nodes_.peekG(anytime_.k_goal) <= open.topKey()) break;
+
+		if (cells_expanded % CHECK_INTERVAL == CHECK_INTERVAL - 1 && wallTime() >= deadline) {
+			done = false;
+			break;
+		}
+
+		open.pop();
+		anytime_.closed[k] = stamp;
+		++cells_expanded;
+
+		int x = k % width_;
+		int y = k / width_;
+		for (unsigned int d = 0; d < 8; ++d) {
+			int x_child = x + DX[d];
+			int y_child = y + DY[d];
+			int k_child = width_ * y_child + x_child;
+			if (!nodes_.touch(k_child)) continue;
+
+			double g_child = nodes_.g(k) + cost_model_.getTraversalTime(char_cost_map_[k_child]) * FACTOR[d];
+			if (g_child >= nodes_.g(k_child)) continue;
+
+			nodes_.g(k_child) = g_child;
+			nodes_.parent(k_child) = k;
+			if (anytime_.closed[k_child] != stamp) {
+				open.push(k_child, g_child + anytime_.epsilon * calculateHeuristicCost(x_child, y_child, x_goal, y_goal, min_cell_cost));
+				anytime_.open_cells.push_back(k_child);
+			} else if (anytime_.inconsistent[k_child] != stamp) {
+				// closed in this search already: it is opened again by the next one
+				anytime_.inconsistent[k_child] = stamp;
+				anytime_.inconsistent_cells.push_back(k_child);
+			}
+		}
+
+		open_list_peak = std::max(open_list_peak, open.size());
+	}
+
+	finishStatistics(cells_expanded);
+	statistics_.open_list_peak = open_list_peak;
+	return done;
 }
 
 double AStarPlanner::calculateHeuristicCost(int x, int y, int x_goal, int y_goal, double min_cell_cost) {
 	double dx = (double)(x_goal - x);
 	double dy = (double)(y_goal - y);
-	return sqrt(dx * dx + dy * dy) * min_cell_cost;
+	double h = sqrt(dx * dx + dy * dy) * min_cell_cost;
+	if (landmarks_) h = std::max(h, landmarks_->lowerBound(width_ * y + x, width_ * y_goal + x_goal));
+	return h;
 }
 
-void AStarPlanner::deleteMap() {
-	for(unsigned int i = 0; i < width_; ++i) {
-		delete[] visited_map_[i];
-	}
+double AStarPlanner::calculateAveragePotential(int x, int y, int x_goal, int y_goal, int x_min, int y_min, int x_max, int y_max, double min_cell_cost) {
+	double dx_box = (double)std::max(0, std::max(x_min - x, x - x_max));
+	double dy_box = (double)std::max(0, std::max(y_min - y, y - y_max));
+	return 0.5 * (calculateHeuristicCost(x, y, x_goal, y_goal, min_cell_cost) - sqrt(dx_box * dx_box + dy_box * dy_box) * min_cell_cost);
+}
 
-	delete[] visited_map_;
+void AStarPlanner::deleteMap() {
+	free(visited_map_);
 
 	visited_map_ = 0;
 }
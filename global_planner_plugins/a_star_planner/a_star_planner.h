@@ -11,11 +11,18 @@
 #include <float.h> // for DBL_MAX
 #include <math.h> // for sqrt
 
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <queue>
 #include <stdio.h>
 #include <iostream>
+#include <new> // for std::bad_alloc
+
+#include "cost_model.h"
+#include "landmark_heuristic.h"
+#include "open_list.h"
+#include "search_nodes.h"
 
 namespace cb_global_planner {
 
@@ -23,6 +30,28 @@ class AStarPlanner {
 
 public:
 
+	/**
+	 * @brief How the planner stores the state of the search nodes
+	 *  - NODE_STORAGE_POINTER: one heap allocated CellInfo per push (original implementation)
+	 *  - NODE_STORAGE_FLAT: preallocated per-cell arrays that are reused over plan() calls
+	 */
+	enum NodeStorage {
+		NODE_STORAGE_POINTER,
+		NODE_STORAGE_FLAT
+	};
+
+	/**
+	 * @brief Open list used by the flat node storage
+	 *  - OPEN_LIST_BINARY: binary heap, improved cells are pushed again (lazy decrease-key)
+	 *  - OPEN_LIST_QUATERNARY: indexed 4-ary heap with decrease-key, every cell is in the list at most once
+	 *  - OPEN_LIST_RADIX: monotone radix heap on the f-cost bits, improved cells are pushed again
+	 */
+	enum OpenListType {
+		OPEN_LIST_BINARY,
+		OPEN_LIST_QUATERNARY,
+		OPEN_LIST_RADIX
+	};
+
 	AStarPlanner(int width, int height);
 
 	virtual ~AStarPlanner();
@@ -31,9 +60,118 @@ public:
 
     void setCostmap(const unsigned char* char_cost_map);
 
+	void setCostModel(const CostModel& cost_model) { cost_model_ = cost_model; }
+
+	const CostModel& getCostModel() const { return cost_model_; }
+
 	void resize(int nx, int ny);
 
-    bool plan(std::vector<unsigned int> mx_start, std::vector<unsigned int> my_start, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic = false);
+	unsigned int getWidth() const { return width_; }
+
+	unsigned int getHeight() const { return height_; }
+
+	void setNodeStorage(NodeStorage node_storage) { node_storage_ = node_storage; }
+
+	NodeStorage getNodeStorage() const { return node_storage_; }
+
+	void setOpenListType(OpenListType open_list_type) { open_list_type_ = open_list_type; }
+
+	OpenListType getOpenListType() const { return open_list_type_; }
+
+	/**
+	 * @brief Searches from the start cells and from the goal cell at the same time (flat node storage only)
+	 *
+	 * The search from the goal aims at the bounding box of the start cells. The searches stop when the
+	 * best plan through a cell reached by both cannot be improved anymore: plans are optimal, like the
+	 * plans of the search from the start cells alone.
+	 */
+	void setBidirectional(bool bidirectional) { bidirectional_ = bidirectional; }
+
+	bool isBidirectional() const { return bidirectional_; }
+
+	/**
+	 * @brief Tightens the heuristic with landmark lower bounds (not owned, NULL: Euclidean distance only)
+	 *
+	 * The table is only used while it matches the planner dimensions; it has to stay alive until it is replaced.
+	 */
+	void setLandmarkHeuristic(const LandmarkHeuristic* landmarks);
+
+	const LandmarkHeuristic* getLandmarkHeuristic() const { return landmarks_; }
+
+	/**
+	 * @brief Counters of the last plan() call
+	 */
+	struct SearchStatistics {
+		unsigned int cells_touched;        // cells whose search state was initialized
+		unsigned int cells_expanded;       // cells popped from the open list and expanded
+		unsigned int cells_reset_skipped;  // cells that did not have to be reset up front
+		double reset_time_saved;           // estimated time [s] a full reset of the skipped cells would have cost
+		unsigned int open_list_peak;       // maximum number of entries in the open list
+		unsigned int cells_expanded_reverse; // of cells_expanded, expanded by the search from the goal (bidirectional)
+
+		SearchStatistics() : cells_touched(0), cells_expanded(0), cells_reset_skipped(0), reset_time_saved(0), open_list_peak(0),
+			cells_expanded_reverse(0) {}
+	};
+
+	const SearchStatistics& getStatistics() const { return statistics_; }
+
+    virtual bool plan(std::vector<unsigned int> mx_start, std::vector<unsigned int> my_start, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic = false);
+
+	/**
+	 * @brief Plans from several start sets, preferring earlier sets: the plan starts in set t only if no cell
+	 * of the sets before t is connected to the goal. The flat node storage does this in one search in which
+	 * the start cells of set t get a cost penalty that exceeds any path cost t times, so a set that fails is
+	 * not searched again. The pointer node storage plans the sets one after the other.
+	 * @param tier The set in which the plan starts
+	 * @return True if a plan was found
+	 */
+	bool planTiered(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier);
+
+	/**
+	 * @brief Answers several planTiered queries to the same goal cell with one Dijkstra search from the goal cell
+	 *
+	 * Query q has the start sets mx_starts[q * num_sets + t], t < num_sets, and the set preference of planTiered;
+	 * the costs are the path costs, without the t * penalty that planTiered adds for set t. The search stops once
+	 * every query found a plan from its first set, otherwise it covers every cell that is connected to the goal cell.
+	 * Uses the flat node storage whatever the node storage.
+	 * @param costs Cost of the plan per query (traversal times of the cost model), DBL_MAX if there is none
+	 * @param tiers Start set in which the plan of each query starts
+	 * @param plans_xs, plans_ys If not NULL, the plan per query from the goal cell to a start cell, empty if there is none
+	 * @param lengths If not NULL, the length of the plan per query [cells], -1 if there is none; cheaper than the plans
+	 * @return True if at least one query has a plan
+	 */
+	bool planBatch(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_queries, unsigned int num_sets,
+			int mx_goal, int my_goal, std::vector<double>& costs, std::vector<unsigned int>& tiers,
+			std::vector<std::vector<int> >* plans_xs = 0, std::vector<std::vector<int> >* plans_ys = 0, std::vector<double>* lengths = 0);
+
+	/**
+	 * @brief Anytime Repairing A* (ARA*): a first plan with the heuristic inflated by epsilon, then searches with a lower
+	 * epsilon that reuse the work of the previous ones, until epsilon is 1 (the optimal plan) or the time budget is used.
+	 * The cost of a plan is at most epsilon times the cost of the optimal plan.
+	 *
+	 * The first plan is always completed, the time budget only limits the improvements, which improveAnytime can continue
+	 * as long as no other search runs on the planner. Start sets and their preference as planTiered; always uses the flat
+	 * node storage and the plain expansion (not bidirectional, no jumps).
+	 * @param epsilon_step Decrease of epsilon per search, a step of 0 goes to 1 at once
+	 * @param time_budget [s] measured from the call
+	 * @param epsilon In: inflation of the first search (at least 1); out: bound of the cost of the plan
+	 * @return True if a plan was found
+	 */
+	bool planAnytime(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal,
+			double epsilon_step, double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier, double& epsilon);
+
+	/**
+	 * @brief Continues the searches of the last planAnytime for at most time_budget [s]
+	 * @param tier Out: start set the improved plan ends in, as planTiered
+	 * @return True if the plan improved, false if not: no search finished in time, the plan is optimal already or
+	 * another search ran on the planner since
+	 */
+	bool improveAnytime(double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier, double& epsilon);
+
+	/**
+	 * @brief Whether improveAnytime can still improve the plan of the last planAnytime
+	 */
+	bool canImproveAnytime() const { return anytime_.valid && !(anytime_.search_done && anytime_.epsilon == 1.0); }
 
 protected:
 
@@ -45,17 +183,117 @@ protected:
 
 	const unsigned char* char_cost_map_;
 
-	double** visited_map_;
+	CostModel cost_model_;
+
+	static const unsigned int CACHE_LINE_SIZE = 64;
+
+	double* visited_map_; // row-major (width_ * y + x), like Costmap2D::getCharMap(); pointer node storage only, allocated on first use
 	unsigned int width_;
 	unsigned int height_;
 
+	NodeStorage node_storage_;
+	OpenListType open_list_type_;
+
+	// Flat node storage, indexed by cell id (width_ * y + x), reset in O(1) per query
+	SearchNodes nodes_;
+
+	// Measured time [s] per cell of a full reset, used to estimate the time saved by the lazy reset
+	double reset_time_per_cell_;
+
+	SearchStatistics statistics_;
+
+	// Open lists of the flat node storage, their memory is kept over plan() calls
+	BinaryOpenList binary_open_;
+	QuaternaryOpenList quaternary_open_;
+	RadixOpenList radix_open_;
+
+	// Search from the goal of the bidirectional mode, allocated on first use
+	bool bidirectional_;
+	SearchNodes reverse_nodes_;
+	BinaryOpenList reverse_binary_open_;
+	QuaternaryOpenList reverse_quaternary_open_;
+	RadixOpenList reverse_radix_open_;
+
+	void allocateVisitedMap();
+
 	void deleteMap();
 
 	double getCost(int x, int y);
 
-	struct CellInfo {
+	bool planPointer(const std::vector<unsigned int>& mx_start, const std::vector<unsigned int>& my_start, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	virtual bool usesFlatNodes() const { return node_storage_ == NODE_STORAGE_FLAT; }
+
+	// Cost so far of a cell of the last flat search, planTiered reads the start set of a plan from it
+	virtual double getStartCost(int x, int y) { return nodes_.g(width_ * y + x); }
+
+	// Start cells of the flat search, with g set to the penalty of their start set
+	std::vector<int> starts_;
+	double set_penalty_;
+
+	// Landmark lower bounds of calculateHeuristicCost, NULL if not set or of other dimensions
+	const LandmarkHeuristic* landmarks_;
+	const LandmarkHeuristic* landmarks_set_;
+
+	// Start cells of planBatch, sorted by cell; batch_marks_ flags their cells and is cleared after every batch
+	struct BatchStart {
+		int k;
+		unsigned int query;
+		unsigned int set;
+		BatchStart(int k_, unsigned int query_, unsigned int set_) : k(k_), query(query_), set(set_) {}
+		bool operator<(const BatchStart& other) const { return k < other.k; }
+	};
+	std::vector<BatchStart> batch_starts_;
+	std::vector<unsigned char> batch_marks_;
+
+	void seedStarts(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets);
+
+	// State of the anytime search between planAnytime and improveAnytime, on nodes_ and binary_open_. A cell is closed
+	// or inconsistent in a search if it carries its stamp; the open list keys are g + epsilon * h.
+	struct AnytimeSearch {
+		bool valid;                       // false once another search used the nodes
+		double epsilon, epsilon_step;
+		int k_goal;
+		unsigned int stamp;               // of the current search
+		bool search_done;
+		std::vector<unsigned int> closed, inconsistent;
+		std::vector<int> open_cells;      // pushed in the current search, with duplicates and cells closed since
+		std::vector<int> inconsistent_cells;
+		std::vector<int> plan_xs, plan_ys;
+		double plan_epsilon;
+		unsigned int plan_tier;
+
+		AnytimeSearch() : valid(false), epsilon(1), epsilon_step(0), k_goal(-1), stamp(0), search_done(false), plan_epsilon(1), plan_tier(0) {}
+	};
+	AnytimeSearch anytime_;
+
+	// Stores the plan of the last finished search of the anytime search, with its epsilon and start set
+	void traceAnytimePlan();
+
+	// Starts the next search of the anytime search: the open and inconsistent cells with the keys of its epsilon
+	void startAnytimeSearch();
+
+	// Runs the current search of the anytime search until the goal cannot be improved (true) or the deadline (false)
+	bool runAnytimeSearch(double deadline);
+
+	virtual bool planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	template <class OpenList>
+	bool planFlat(OpenList& open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	template <class OpenList>
+	bool planBidirectional(OpenList& open, OpenList& reverse_open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	void resizeFlatNodes();
 
-		static long N_OBJECTS;
+	void blockBorder(SearchNodes& nodes);
+
+	void finishStatistics(unsigned int cells_expanded);
+
+	template <class OpenList>
+	inline void expandFlatCell(OpenList& open, int k, int x, int y, int dx, int dy, double cost_factor, int x_goal, int y_goal, double min_cell_cost);
+
+	struct CellInfo {
 
 		int x_;
 		int y_;
@@ -66,11 +304,6 @@ protected:
 
 		CellInfo(double x, double y, double g, double h) : x_(x), y_(y), g_(g), h_(h), visited_from_(0) {
 			f_ = g_ + h_;
-			++N_OBJECTS;
-		}
-
-		~CellInfo() {
-			--N_OBJECTS;
 		}
 	};
 
@@ -80,12 +313,16 @@ protected:
 	   }
 	};
 
-	void expandCell(CellInfo* c, int dx, int dy, double cost_factor, double** visited_map,
+	void expandCell(CellInfo* c, int dx, int dy, double cost_factor, double* visited_map,
 			int x_goal, int y_goal, double min_cell_cost,
 			std::priority_queue<CellInfo*, std::vector<CellInfo*>, compareCellInfos>& Q);
 
 	double calculateHeuristicCost(int x, int y, int x_goal, int y_goal, double min_cell_cost);
 
+	// half the difference of the heuristic towards the goal and the one towards the box [x_min, x_max] x [y_min, y_max]
+	// around the start cells, potential of the bidirectional search
+	double calculateAveragePotential(int x, int y, int x_goal, int y_goal, int x_min, int y_min, int x_max, int y_max, double min_cell_cost);
+
 };
 
 }
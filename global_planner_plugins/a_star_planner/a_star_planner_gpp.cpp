@@ -1,8 +1,14 @@
 #include <pluginlib/class_list_macros.h>
 #include "a_star_planner_gpp.h"
+#include "jump_point_planner.h"
+#include "search_kernel_planner.h"
 #include "costmap_2d/cost_values.h"
 
-#include <ed_msgs/SimpleQuery.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <string.h> // for memcmp
 
 namespace cb_global_planner
 {
@@ -12,40 +18,65 @@ PLUGINLIB_EXPORT_CLASS(cb_global_planner::AStarPlannerGPP, cb_global_planner::Gl
 
 // ----------------------------------------------------------------------------------------------------
 
-bool AStarPlannerGPP::queryEntityPose(const std::string& id, tf::Transform& pose)
+namespace
 {
-    if (id == "map" || id == "/map")
-    {
-        pose = tf::Transform::getIdentity();
-        return true;
-    }
 
-    ed_msgs::SimpleQuery ed_query;
-    ed_query.request.id = id;
+// Adds the wall time of its scope to a statistics field [s]
+struct StageTimer
+{
+    double& seconds;
+    ros::WallTime start;
+
+    StageTimer(double& seconds) : seconds(seconds), start(ros::WallTime::now()) {}
+    ~StageTimer() { seconds += (ros::WallTime::now() - start).toSec(); }
+};
 
-    std::cout << "[A* Planner] Querying ed for entity '" << id << "'." << std::endl;
+boost::mutex entity_pose_cache_mutex;
+boost::weak_ptr<cb_base_navigation::EntityPoseCache> entity_pose_cache;
 
-    if (!ed_client_.call(ed_query))
+boost::shared_ptr<cb_base_navigation::EntityPoseCache> getEntityPoseCache(double poll_frequency, double max_age)
+{
+    boost::mutex::scoped_lock lock(entity_pose_cache_mutex);
+
+    boost::shared_ptr<cb_base_navigation::EntityPoseCache> cache = entity_pose_cache.lock();
+    if (!cache)
     {
-        ROS_ERROR_STREAM("[A* Planner] Failed to get pose for entity '" << id << "': ED could not be queried.");
-        return false;
+        cache.reset(new cb_base_navigation::EntityPoseCache(poll_frequency, max_age));
+        entity_pose_cache = cache;
     }
+    return cache;
+}
+
+void logStatistics(const std::string& tier, const AStarPlanner::SearchStatistics& stats)
+{
+    ROS_DEBUG_STREAM("[A* Planner] Search to " << tier << " goal cells: " << stats.cells_expanded << " cells expanded ("
+                     << stats.cells_expanded - stats.cells_expanded_reverse << " from the goal cells, " << stats.cells_expanded_reverse
+                     << " from the robot), " << stats.cells_touched << " touched, " << stats.cells_reset_skipped << " not reset (saved ~"
+                     << stats.reset_time_saved * 1000 << " ms), open list peak " << stats.open_list_peak << ".");
+}
+
+}
 
-    if (ed_query.response.entities.empty())
+bool AStarPlannerGPP::queryEntityPose(const std::string& id, tf::Transform& pose)
+{
+    StageTimer timer(statistics_.entity_query);
+
+    // Planning may wait for ED, but only if the cache has no recent pose
+    if (!entity_poses_->getPose(id, pose, true))
     {
-        ROS_ERROR_STREAM("[A* Planner] Failed to get pose for entity '" << id << "': ED returns 'no such entity'.");
+        ROS_ERROR_STREAM("[A* Planner] Failed to get pose for entity '" << id << "'.");
         return false;
     }
-
-    const ed_msgs::EntityInfo& e_info = ed_query.response.entities.front();
-
-    tf::poseMsgToTF(e_info.pose, pose);
     return true;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
-AStarPlannerGPP::AStarPlannerGPP() : global_costmap_ros_(NULL),  planner_(NULL) {}
+AStarPlannerGPP::AStarPlannerGPP() : global_costmap_ros_(NULL),  planner_(NULL), goal_region_(NULL), has_goal_region_(false), constraint_threads_(1), single_tier_search_(false),
+    use_landmarks_(false), num_landmarks_(8), landmark_map_width_(0), landmark_map_height_(0), landmark_version_(0), landmark_result_version_(0),
+    landmark_building_(false), simplify_plans_(false), simplify_spacing_(0.1), simplify_max_shortcut_(5.0),
+    anytime_initial_epsilon_(3.0), anytime_epsilon_step_(0.5), anytime_valid_(false), anytime_char_map_(NULL), anytime_size_x_(0), anytime_size_y_(0),
+    anytime_origin_x_(0), anytime_origin_y_(0), anytime_version_(0) {}
 
 void AStarPlannerGPP::initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros)
 {
@@ -53,29 +84,188 @@ void AStarPlannerGPP::initialize(std::string name, tf::TransformListener* tf, co
     global_costmap_ros_ = global_costmap_ros;
     tf_ = tf;
 
+    ros::NodeHandle private_nh("~/" + name);
+
+    // Search: 'a_star' (default), 'bidirectional' (A* from the goal cells and from the robot at once, flat storage only)
+    // 'jump_point' (prunes symmetric paths in uniform cost regions, always flat storage) or 'kernel' (A* specialised on the
+    // connectivity, heuristic and cost table, on a padded grid so plans can use the border cells, always flat storage)
+    std::string search;
+    private_nh.param("search", search, std::string("a_star"));
+
     // Create AstarPlanner Object ( initialize with current costmap width and height )
-    planner_ = new AStarPlanner(global_costmap_ros->getCostmap()->getSizeInCellsX(), global_costmap_ros->getCostmap()->getSizeInCellsY());
-    initialized_ = true;
+    unsigned int width = global_costmap_ros->getCostmap()->getSizeInCellsX();
+    unsigned int height = global_costmap_ros->getCostmap()->getSizeInCellsY();
+    if (search == "jump_point") {
+        JumpPointPlanner* jump_point_planner = new JumpPointPlanner(width, height);
+        int max_jump;
+        private_nh.param("jump_point/max_jump", max_jump, 8);
+        jump_point_planner->setMaxJump(std::max(1, max_jump));
+        planner_ = jump_point_planner;
+    } else if (search == "kernel") {
+        SearchKernelPlanner* kernel_planner = new SearchKernelPlanner(width, height);
+        int connectivity;
+        private_nh.param("kernel/connectivity", connectivity, 8);
+        if (connectivity != 4 && connectivity != 8) ROS_WARN("[A* Planner] kernel/connectivity should be 4 or 8, using 8.");
+        kernel_planner->setConnectivity(connectivity == 4 ? SearchKernelPlanner::CONNECTIVITY_4 : SearchKernelPlanner::CONNECTIVITY_8);
+
+        std::string kernel_heuristic;
+        private_nh.param("kernel/heuristic", kernel_heuristic, std::string("octile"));
+        if (kernel_heuristic == "euclidean") {
+            kernel_planner->setHeuristic(SearchKernelPlanner::HEURISTIC_EUCLIDEAN);
+        } else {
+            if (kernel_heuristic != "octile") ROS_WARN_STREAM("[A* Planner] Unknown kernel/heuristic '" << kernel_heuristic << "', using 'octile'.");
+            kernel_planner->setHeuristic(SearchKernelPlanner::HEURISTIC_OCTILE);
+        }
+
+        std::string cost_table;
+        private_nh.param("kernel/cost_table", cost_table, std::string("traversal_time"));
+        if (cost_table == "uniform") {
+            kernel_planner->setCostTable(SearchKernelPlanner::COST_TABLE_UNIFORM);
+        } else {
+            if (cost_table != "traversal_time") ROS_WARN_STREAM("[A* Planner] Unknown kernel/cost_table '" << cost_table << "', using 'traversal_time'.");
+            kernel_planner->setCostTable(SearchKernelPlanner::COST_TABLE_TRAVERSAL_TIME);
+        }
+        planner_ = kernel_planner;
+    } else {
+        if (search != "a_star" && search != "bidirectional") ROS_WARN_STREAM("[A* Planner] Unknown search '" << search << "', using 'a_star'.");
+        planner_ = new AStarPlanner(width, height);
+        planner_->setBidirectional(search == "bidirectional");
+    }
+
+    // Node storage: 'pointer' (one allocation per node, default) or 'flat' (preallocated per-cell arrays)
+    std::string node_storage;
+    private_nh.param("node_storage", node_storage, std::string("pointer"));
+    if (node_storage == "flat") {
+        planner_->setNodeStorage(AStarPlanner::NODE_STORAGE_FLAT);
+    } else {
+        if (node_storage != "pointer") ROS_WARN_STREAM("[A* Planner] Unknown node_storage '" << node_storage << "', using 'pointer'.");
+        planner_->setNodeStorage(AStarPlanner::NODE_STORAGE_POINTER);
+    }
+    if (search == "bidirectional" && planner_->getNodeStorage() != AStarPlanner::NODE_STORAGE_FLAT) {
+        ROS_WARN("[A* Planner] The bidirectional search needs node_storage 'flat', searching from the goal cells only.");
+    }
+
+    // Open list of the flat node storage: 'binary' (default), 'quaternary' (indexed, decrease-key) or 'radix'
+    std::string open_list;
+    private_nh.param("open_list", open_list, std::string("binary"));
+    if (open_list == "quaternary") {
+        planner_->setOpenListType(AStarPlanner::OPEN_LIST_QUATERNARY);
+    } else if (open_list == "radix") {
+        planner_->setOpenListType(AStarPlanner::OPEN_LIST_RADIX);
+    } else {
+        if (open_list != "binary") ROS_WARN_STREAM("[A* Planner] Unknown open_list '" << open_list << "', using 'binary'.");
+        planner_->setOpenListType(AStarPlanner::OPEN_LIST_BINARY);
+    }
+
+    // Goal tiers: 'sequential' (one search per tier until one succeeds, default) or 'single' (one search over all tiers)
+    std::string goal_tier_search;
+    private_nh.param("goal_tier_search", goal_tier_search, std::string("sequential"));
+    if (goal_tier_search != "single" && goal_tier_search != "sequential") {
+        ROS_WARN_STREAM("[A* Planner] Unknown goal_tier_search '" << goal_tier_search << "', using 'sequential'.");
+    }
+    single_tier_search_ = (goal_tier_search == "single");
+
+    // Threads that rasterise a new goal constraint
+    int constraint_threads;
+    private_nh.param("constraint_threads", constraint_threads, 1);
+    constraint_threads_ = std::max(1, constraint_threads);
+
+    // Cache of rasterised constraints, to skip the rasterisation when returning to a goal
+    int cache_size, cache_memory;
+    private_nh.param("constraint_cache/size", cache_size, 8);
+    private_nh.param("constraint_cache/max_memory", cache_memory, 64);
+    constraint_cache_.setLimits(std::max(1, cache_size), std::max(0, cache_memory) * 1024 * 1024);
+
+    // Cost model, shared by the search, the goal area and checkPlan
+    double max_velocity;
+    bool inscribed_is_traversable, unknown_is_traversable;
+    int unknown_cost;
+    private_nh.param("cost_model/max_velocity", max_velocity, 1.0);
+    private_nh.param("cost_model/inscribed_is_traversable", inscribed_is_traversable, false);
+    private_nh.param("cost_model/unknown_is_traversable", unknown_is_traversable, false);
+    private_nh.param("cost_model/unknown_cost", unknown_cost, (int) costmap_2d::FREE_SPACE);
+    if (max_velocity <= 0) {
+        ROS_WARN("[A* Planner] cost_model/max_velocity should be positive, using 1.0.");
+        max_velocity = 1.0;
+    }
+    cost_model_.configure(max_velocity, inscribed_is_traversable, unknown_is_traversable, (unsigned char) std::max(0, std::min(255, unknown_cost)));
+    planner_->setCostModel(cost_model_);
+
+    // Heuristic: 'euclidean' (default) or 'landmarks' (lower bounds from distances over the static layer, these follow the walls)
+    std::string heuristic;
+    private_nh.param("heuristic", heuristic, std::string("euclidean"));
+    if (heuristic != "euclidean" && heuristic != "landmarks") ROS_WARN_STREAM("[A* Planner] Unknown heuristic '" << heuristic << "', using 'euclidean'.");
+    use_landmarks_ = (heuristic == "landmarks");
+    if (use_landmarks_ && search == "kernel") ROS_WARN("[A* Planner] The kernel search does not use the landmarks, these only speed up the other searches.");
+    int num_landmarks;
+    private_nh.param("landmarks/count", num_landmarks, 8);
+    num_landmarks_ = std::max(1, num_landmarks);
+    private_nh.param("landmarks/layer", landmark_layer_, std::string("ed_occupancy_grid"));
+
+    // Plan simplification: line of sight shortcuts that keep the clearance of the plan, resampled every spacing [m]
+    private_nh.param("simplify/enabled", simplify_plans_, false);
+    private_nh.param("simplify/spacing", simplify_spacing_, 0.1);
+    private_nh.param("simplify/max_shortcut", simplify_max_shortcut_, 5.0);
+    if (simplify_spacing_ <= 0) {
+        ROS_WARN("[A* Planner] simplify/spacing should be positive, using 0.1.");
+        simplify_spacing_ = 0.1;
+    }
+
+    // Anytime search (makePlanAnytime): the first plan with the heuristic inflated by initial_epsilon, improved in steps
+    private_nh.param("anytime/initial_epsilon", anytime_initial_epsilon_, 3.0);
+    private_nh.param("anytime/epsilon_step", anytime_epsilon_step_, 0.5);
+    if (anytime_initial_epsilon_ < 1) {
+        ROS_WARN("[A* Planner] anytime/initial_epsilon should be at least 1, using 1.");
+        anytime_initial_epsilon_ = 1;
+    }
 
-    ros::NodeHandle nh;
-    ed_client_ = nh.serviceClient<ed_msgs::SimpleQuery>("ed/simple_query");
+    // Entity poses: polled in the background, a pose older than max_age [s] is queried again before planning
+    double entity_poll_frequency, entity_max_age;
+    private_nh.param("entity_poses/poll_frequency", entity_poll_frequency, 5.0);
+    private_nh.param("entity_poses/max_age", entity_max_age, 1.0);
+    entity_poses_ = getEntityPoseCache(entity_poll_frequency, entity_max_age);
+
+    initialized_ = true;
 
     ROS_INFO("A* Global planner initialized.");
 }
 
 AStarPlannerGPP::~AStarPlannerGPP()
 {
+    if (landmark_thread_.joinable()) landmark_thread_.join();
     delete planner_;
 }
 
 bool AStarPlannerGPP::makePlan(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions)
 {
+    double epsilon;
+    return planRequest(start, position_constraint, -1, plan, goal_positions, epsilon);
+}
+
+bool AStarPlannerGPP::makePlanAnytime(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, double time_budget,
+                                      std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions, double& epsilon)
+{
+    return planRequest(start, position_constraint, std::max(0.0, time_budget), plan, goal_positions, epsilon);
+}
+
+bool AStarPlannerGPP::planRequest(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, double time_budget,
+                                  std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions, double& epsilon)
+{
+    ros::WallTime t_start = ros::WallTime::now();
+    epsilon = 1;
+    anytime_valid_ = false;
+
     if (!initialized_) { ROS_WARN("The global planner is not initialized! It's not possible to create a global plan."); return false; }
 
     // Clear the plan and goal positions
     plan.clear();
     goal_positions.clear();
 
+    statistics_ = cb_base_navigation::PlanStatistics();
+    statistics_.constraint_cache_hit = true;
+    statistics_.tier = -1;
+    has_goal_region_ = false;
+
     // If nothing specified, do nothing :)
     if (position_constraint.frame == "" && position_constraint.constraint == "") return false;
 
@@ -86,8 +276,64 @@ bool AStarPlannerGPP::makePlan(const tf::Stamped<tf::Pose>& start, const Positio
         return false;
     }
 
-    // Check whether the constraint has been changed
-    if (constraintChanged(position_constraint)) {
+    // Goal cells that meet the constraint, divided in tiers
+    std::vector<unsigned int> mx_tier[CostModel::NUM_GOAL_TIERS], my_tier[CostModel::NUM_GOAL_TIERS];
+    if (!calculateGoalTiers(position_constraint, mx_tier, my_tier, goal_positions)) return false;
+    has_goal_region_ = true;
+
+    // Initialize plan
+    std::vector<int> plan_xs, plan_ys;
+
+    //planner_->plan(mx_goal, my_goal, mx_start, my_start, plan_xs, plan_ys);
+    {
+        StageTimer timer(statistics_.search);
+        if (time_budget >= 0 && supportsAnytimeSearch()) {
+            double remaining = std::max(0.0, time_budget - (ros::WallTime::now() - t_start).toSec());
+            planToGoalCellsAnytime(mx_tier, my_tier, mx_start, my_start, remaining, plan_xs, plan_ys, epsilon);
+        } else {
+            planToGoalCells(mx_tier, my_tier, mx_start, my_start, plan_xs, plan_ys);
+        }
+    }
+
+//    if (plan_xs.empty()) {
+
+//        // Try best heuristics path from the other way around
+//        unsigned int mx_start_new = mx_goal[mx_goal.size()/2]; // middlepoint of area
+//        unsigned int my_start_new = my_goal[my_goal.size()/2]; // middlepoint of area
+
+//        mx_goal.clear(); mx_goal.push_back(mx_start);
+//        my_goal.clear(); my_goal.push_back(my_start);
+
+//        planner_->plan(mx_goal, my_goal, mx_start_new, my_start_new, plan_xs, plan_ys,true);
+
+//        // Reverse the plan
+//        std::reverse(plan_xs.begin(),plan_xs.end());
+//        std::reverse(plan_ys.begin(),plan_ys.end());
+
+//    }
+
+    // Convert plan to world coordinates
+    {
+        StageTimer timer(statistics_.plan_to_world);
+        planToWorld(plan_xs,plan_ys,plan);
+    }
+
+    // If no plan was found, return false
+    if (plan.empty()) {
+        ROS_ERROR("No connectivity to specified constraint found, sorry :(");
+    } else {
+        ROS_INFO("A* planner succesfully generated plan :)");
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool AStarPlannerGPP::calculateGoalTiers(const PositionConstraint& position_constraint, std::vector<unsigned int>* mx_tier, std::vector<unsigned int>* my_tier,
+                                         std::vector<tf::Point>& goal_positions)
+{
+    // Check whether the constraint has been changed (or failed to update the last time)
+    if (constraintChanged(position_constraint) || !goal_region_) {
         if (updateConstraintPositionsInConstraintFrame(position_constraint)) {
             position_constraint_ = position_constraint;
         } else {
@@ -111,90 +357,366 @@ bool AStarPlannerGPP::makePlan(const tf::Stamped<tf::Pose>& start, const Positio
         return false;
     }
 
-    // Divide goal area in two: with costs above and below a certain threshold
+    statistics_.goal_cells = mx_goal.size();
+
+    // Divide goal area in tiers: free, low and high costs (see CostModel::getGoalTier)
     // This prevents the planner for planning unnecessarily close to obstacles
-    std::vector<unsigned int> mx_free, my_free, mx_low, my_low, mx_high, my_high;
     for (unsigned int i = 0; i < mx_goal.size(); i++) {
+        unsigned int tier = cost_model_.getGoalTier(global_costmap_ros_->getCostmap()->getCost(mx_goal[i], my_goal[i]));
+        mx_tier[tier].push_back(mx_goal[i]);
+        my_tier[tier].push_back(my_goal[i]);
+    }
 
-        // Check cost
-        double cost = global_costmap_ros_->getCostmap()->getCost(mx_goal[i], my_goal[i]);
-        // ToDo: divided by four is magic number
-        // ToDo: more levels?
-        if (cost == costmap_2d::FREE_SPACE) {
-            mx_free.push_back(mx_goal[i]);
-            my_free.push_back(my_goal[i]);
-        } else if (cost < costmap_2d::INSCRIBED_INFLATED_OBSTACLE/4) {
-            mx_low.push_back(mx_goal[i]);
-            my_low.push_back(my_goal[i]);
-        } else {
-            mx_high.push_back(mx_goal[i]);
-            my_high.push_back(my_goal[i]);
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool AStarPlannerGPP::makePlans(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                                std::vector<std::vector<geometry_msgs::PoseStamped> >& plans, std::vector<double>& costs, std::vector<unsigned char>& failed)
+{
+    std::vector<std::vector<int> > plans_xs, plans_ys;
+    if (!planToConstraints(start, position_constraints, costs, failed, &plans_xs, &plans_ys, NULL)) return false;
+
+    plans.assign(position_constraints.size(), std::vector<geometry_msgs::PoseStamped>());
+    for (unsigned int i = 0; i < position_constraints.size(); ++i) {
+        if (costs[i] >= 0) planToWorld(plans_xs[i], plans_ys[i], plans[i]);
+    }
+    return true;
+}
+
+bool AStarPlannerGPP::getPlanCosts(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                                   std::vector<double>& costs, std::vector<double>& lengths, std::vector<unsigned char>& failed)
+{
+    if (!planToConstraints(start, position_constraints, costs, failed, NULL, NULL, &lengths)) return false;
+
+    double resolution = global_costmap_ros_->getCostmap()->getResolution();
+    for (unsigned int i = 0; i < lengths.size(); ++i) {
+        if (lengths[i] >= 0) lengths[i] *= resolution;
+    }
+    return true;
+}
+
+bool AStarPlannerGPP::planToConstraints(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints, std::vector<double>& costs,
+                                        std::vector<unsigned char>& failed, std::vector<std::vector<int> >* plans_xs, std::vector<std::vector<int> >* plans_ys, std::vector<double>* lengths)
+{
+    if (!initialized_) { ROS_WARN("The global planner is not initialized! It's not possible to create a global plan."); return false; }
+
+    unsigned int num_constraints = position_constraints.size();
+    costs.assign(num_constraints, -1);
+    failed.assign(num_constraints, 0);
+    if (plans_xs) plans_xs->assign(num_constraints, std::vector<int>());
+    if (plans_ys) plans_ys->assign(num_constraints, std::vector<int>());
+    if (lengths) lengths->assign(num_constraints, -1);
+    if (num_constraints == 0) return true;
+
+    unsigned int mx_start, my_start;
+    if(!global_costmap_ros_->getCostmap()->worldToMap(start.getOrigin().getX(), start.getOrigin().getY(), mx_start, my_start)) {
+        ROS_WARN("The robot's start position is off the global costmap. Planning will always fail, are you sure the robot has been properly localized?");
+        return false;
+    }
+
+    // Goal tiers of constraint i are mx_tiers[i * NUM_GOAL_TIERS + tier], a constraint without goal cells is never reached
+    std::vector<std::vector<unsigned int> > mx_tiers(num_constraints * CostModel::NUM_GOAL_TIERS), my_tiers(num_constraints * CostModel::NUM_GOAL_TIERS);
+    unsigned int num_failed = 0;
+    for (unsigned int i = 0; i < num_constraints; ++i) {
+        std::vector<tf::Point> goal_positions;
+        if ((position_constraints[i].frame == "" && position_constraints[i].constraint == "")
+                || !calculateGoalTiers(position_constraints[i], &mx_tiers[i * CostModel::NUM_GOAL_TIERS], &my_tiers[i * CostModel::NUM_GOAL_TIERS], goal_positions)) {
+            ROS_WARN("[A* Planner] Constraint %u of %u has no goal cells, it is reported as failed.", i, num_constraints);
+            failed[i] = 1;
+            ++num_failed;
         }
     }
 
-    // Initialize plan
-    std::vector<int> plan_xs, plan_ys;
+    // One search from the robot answers all constraints
+    prepareSearch();
+
+    std::vector<double> plan_costs;
+    std::vector<unsigned int> tiers;
+    planner_->planBatch(&mx_tiers[0], &my_tiers[0], num_constraints, CostModel::NUM_GOAL_TIERS, mx_start, my_start, plan_costs, tiers, plans_xs, plans_ys, lengths);
+    logStatistics("all", planner_->getStatistics());
+
+    unsigned int num_plans = 0;
+    for (unsigned int i = 0; i < num_constraints; ++i) {
+        if (plan_costs[i] == DBL_MAX) continue;
+        costs[i] = plan_costs[i];
+        ++num_plans;
+    }
+
+    ROS_INFO("A* planner reaches %u of %u constraints, %u failed.", num_plans, num_constraints, num_failed);
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
 
+bool AStarPlannerGPP::planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                      std::vector<int>& plan_xs, std::vector<int>& plan_ys)
+{
     // Resize to current costmap dimensions and set costmap and do some path finding :)
+    prepareSearch();
+
+    // Try to find a plan with the endgoal in free space, if no plan, retry with low costs
+    // and if still no plan, retry with the remaining goal poses
+    const char* tier_names[CostModel::NUM_GOAL_TIERS] = { "free", "low cost", "high cost" };
+    if (single_tier_search_) {
+        unsigned int tier;
+        statistics_.tier_searches.push_back(0);
+        bool found;
+        {
+            StageTimer timer(statistics_.tier_searches.back());
+            found = planner_->planTiered(mx_tier, my_tier, CostModel::NUM_GOAL_TIERS, mx_start, my_start, plan_xs, plan_ys, tier);
+        }
+        logStatistics(found ? tier_names[tier] : "all", planner_->getStatistics());
+        addSearchStatistics(planner_->getStatistics());
+        if (found) statistics_.tier = tier;
+    } else {
+        for (unsigned int tier = 0; tier < CostModel::NUM_GOAL_TIERS && plan_xs.empty(); ++tier) {
+            statistics_.tier_searches.push_back(0);
+            {
+                StageTimer timer(statistics_.tier_searches.back());
+                planner_->plan(mx_tier[tier], my_tier[tier], mx_start, my_start, plan_xs, plan_ys);
+            }
+            logStatistics(tier_names[tier], planner_->getStatistics());
+            addSearchStatistics(planner_->getStatistics());
+            if (!plan_xs.empty()) statistics_.tier = tier;
+        }
+    }
+
+    return !plan_xs.empty();
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool AStarPlannerGPP::planToGoalCellsAnytime(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                             double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, double& epsilon)
+{
+    prepareSearch();
+
+    // All tiers in one search, like the single tier search
+    const char* tier_names[CostModel::NUM_GOAL_TIERS] = { "free", "low cost", "high cost" };
+    unsigned int tier;
+    statistics_.tier_searches.push_back(0);
+    bool found;
+    {
+        StageTimer timer(statistics_.tier_searches.back());
+        epsilon = anytime_initial_epsilon_;
+        found = planner_->planAnytime(mx_tier, my_tier, CostModel::NUM_GOAL_TIERS, mx_start, my_start, anytime_epsilon_step_, time_budget,
+                                      plan_xs, plan_ys, tier, epsilon);
+    }
+    logStatistics(found ? tier_names[tier] : "all", planner_->getStatistics());
+    addSearchStatistics(planner_->getStatistics());
+    if (!found) return false;
+
+    statistics_.tier = tier;
+    ROS_DEBUG("[A* Planner] Anytime plan with epsilon %.2f.", epsilon);
+
+    // The costmap the search continues on
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    anytime_valid_ = true;
+    anytime_char_map_ = costmap->getCharMap();
+    anytime_size_x_ = costmap->getSizeInCellsX();
+    anytime_size_y_ = costmap->getSizeInCellsY();
+    anytime_origin_x_ = costmap->getOriginX();
+    anytime_origin_y_ = costmap->getOriginY();
+    const UpdatedBoundsLayer* layer = findUpdatedBoundsLayer();
+    anytime_version_ = layer ? layer->getVersion() : 0;
+    return true;
+}
+
+bool AStarPlannerGPP::improvePlan(double time_budget, std::vector<geometry_msgs::PoseStamped>& plan, double& epsilon)
+{
+    if (!canImprovePlan()) return false;
+
+    std::vector<int> plan_xs, plan_ys;
+    unsigned int tier;
+    if (!planner_->improveAnytime(time_budget, plan_xs, plan_ys, tier, epsilon)) return false;
+
+    statistics_.tier = tier;
+    ROS_DEBUG("[A* Planner] Anytime plan improved to epsilon %.2f.", epsilon);
+    planToWorld(plan_xs, plan_ys, plan);
+    return true;
+}
+
+bool AStarPlannerGPP::canImprovePlan() const
+{
+    return anytime_valid_ && planner_->canImproveAnytime() && anytimeCostmapUnchanged();
+}
+
+bool AStarPlannerGPP::anytimeCostmapUnchanged() const
+{
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    if (costmap->getCharMap() != anytime_char_map_ || costmap->getSizeInCellsX() != anytime_size_x_ || costmap->getSizeInCellsY() != anytime_size_y_
+            || costmap->getOriginX() != anytime_origin_x_ || costmap->getOriginY() != anytime_origin_y_) return false;
+
+    // without the layer changed cells are not seen, so the g-values of the search can not be trusted
+    const UpdatedBoundsLayer* layer = findUpdatedBoundsLayer();
+    if (!layer) return false;
+
+    double min_x, min_y, max_x, max_y;
+    return layer->getChangedBounds(anytime_version_, min_x, min_y, max_x, max_y) && min_x > max_x;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void AStarPlannerGPP::addSearchStatistics(const AStarPlanner::SearchStatistics& stats)
+{
+    statistics_.cells_expanded += stats.cells_expanded;
+    statistics_.open_list_peak = std::max(statistics_.open_list_peak, stats.open_list_peak);
+}
+
+void AStarPlannerGPP::getStatistics(cb_base_navigation::PlanStatistics& statistics) const
+{
+    statistics.entity_query = statistics_.entity_query;
+    statistics.constraint = statistics_.constraint;
+    statistics.search = statistics_.search;
+    statistics.tier_searches = statistics_.tier_searches;
+    statistics.plan_to_world = statistics_.plan_to_world;
+    statistics.constraint_cache_hit = statistics_.constraint_cache_hit;
+    statistics.goal_cells = statistics_.goal_cells;
+    statistics.tier = statistics_.tier;
+    statistics.cells_expanded = statistics_.cells_expanded;
+    statistics.open_list_peak = statistics_.open_list_peak;
+}
+
+bool AStarPlannerGPP::getConstraintFramePose(tf::Transform& pose) const
+{
+    if (!has_goal_region_ || !goal_region_) return false;
+    pose = goal_region_->world_to_constraint;
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void AStarPlannerGPP::prepareSearch()
+{
     planner_->resize(global_costmap_ros_->getCostmap()->getSizeInCellsX(), global_costmap_ros_->getCostmap()->getSizeInCellsY());
     planner_->setCostmap(global_costmap_ros_->getCostmap()->getCharMap());
 
-    //planner_->plan(mx_goal, my_goal, mx_start, my_start, plan_xs, plan_ys);
-    // Try to find a plan with the endgoal in free space
-    planner_->plan(mx_free, my_free, mx_start, my_start, plan_xs, plan_ys);
-    
-    // If no plan, retry with low costs
-    if (plan_xs.empty()) {
-        planner_->plan(mx_low, my_low, mx_start, my_start, plan_xs, plan_ys);
+    if (use_landmarks_) updateLandmarkHeuristic();
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void AStarPlannerGPP::updateLandmarkHeuristic()
+{
+    // The static layer is a costmap of the size of the master costmap; plugin names are prefixed with the costmap name
+    costmap_2d::Costmap2D* static_map = NULL;
+    std::vector<boost::shared_ptr<costmap_2d::Layer> >* layers = global_costmap_ros_->getLayeredCostmap()->getPlugins();
+    for (std::vector<boost::shared_ptr<costmap_2d::Layer> >::iterator it = layers->begin(); it != layers->end(); ++it) {
+        std::string name = (*it)->getName();
+        std::string suffix = "/" + landmark_layer_;
+        if (name == landmark_layer_ || (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)) {
+            static_map = dynamic_cast<costmap_2d::Costmap2D*>(it->get());
+            break;
+        }
     }
 
-    // If still no plan, retry with the remaining goal poses
-    if (plan_xs.empty()) {
-        planner_->plan(mx_high, my_high, mx_start, my_start, plan_xs, plan_ys);
+    unsigned int width = static_map ? static_map->getSizeInCellsX() : 0, height = static_map ? static_map->getSizeInCellsY() : 0;
+    if (width * height == 0) {
+        ROS_WARN_STREAM_THROTTLE(10, "[A* Planner] No costmap layer '" << landmark_layer_ << "', using the Euclidean heuristic.");
+        planner_->setLandmarkHeuristic(NULL);
+        return;
     }
 
-//    if (plan_xs.empty()) {
+    // Only a changed static layer is rebuilt; until then the old bounds may overestimate, so they are dropped
+    const unsigned char* map = static_map->getCharMap();
+    if (width != landmark_map_width_ || height != landmark_map_height_ || memcmp(map, &landmark_map_[0], width * height) != 0) {
+        landmark_map_.assign(map, map + width * height);
+        landmark_map_width_ = width;
+        landmark_map_height_ = height;
+        ++landmark_version_;
+        landmarks_.reset();
+    }
 
-//        // Try best heuristics path from the other way around
-//        unsigned int mx_start_new = mx_goal[mx_goal.size()/2]; // middlepoint of area
-//        unsigned int my_start_new = my_goal[my_goal.size()/2]; // middlepoint of area
+    bool start_build = false;
+    {
+        boost::lock_guard<boost::mutex> lock(landmark_mutex_);
+        if (landmark_result_ && landmark_result_version_ == landmark_version_) landmarks_ = landmark_result_;
+        landmark_result_.reset();
 
-//        mx_goal.clear(); mx_goal.push_back(mx_start);
-//        my_goal.clear(); my_goal.push_back(my_start);
+        // a build of an older version is left to finish, the next call starts the current one
+        start_build = !landmarks_ && !landmark_building_;
+        landmark_building_ |= start_build;
+    }
 
-//        planner_->plan(mx_goal, my_goal, mx_start_new, my_start_new, plan_xs, plan_ys,true);
+    if (start_build) {
+        if (landmark_thread_.joinable()) landmark_thread_.join(); // done, landmark_building_ was false
+        landmark_thread_ = boost::thread(boost::bind(&AStarPlannerGPP::buildLandmarkHeuristic, this, landmark_map_, width, height, cost_model_, landmark_version_));
+    }
 
-//        // Reverse the plan
-//        std::reverse(plan_xs.begin(),plan_xs.end());
-//        std::reverse(plan_ys.begin(),plan_ys.end());
+    planner_->setLandmarkHeuristic(landmarks_.get());
+}
 
-//    }
+void AStarPlannerGPP::buildLandmarkHeuristic(std::vector<unsigned char> map, unsigned int width, unsigned int height, CostModel cost_model, unsigned int version)
+{
+    ros::WallTime t_start = ros::WallTime::now();
+    boost::shared_ptr<LandmarkHeuristic> landmarks(new LandmarkHeuristic);
+    landmarks->build(&map[0], width, height, cost_model, num_landmarks_);
+    ROS_INFO_STREAM("[A* Planner] Built the landmark heuristic: " << landmarks->getNumLandmarks() << " landmarks, "
+                    << landmarks->getMemoryUsage() / (1024 * 1024) << " MB, " << (ros::WallTime::now() - t_start).toSec() << " s.");
+
+    boost::lock_guard<boost::mutex> lock(landmark_mutex_);
+    landmark_result_ = landmarks;
+    landmark_result_version_ = version;
+    landmark_building_ = false;
+}
 
-    // Convert plan to world coordinates
-    planToWorld(plan_xs,plan_ys,plan);
+namespace
+{
 
-    // If no plan was found, return false
-    if (plan.empty()) {
-        ROS_ERROR("No connectivity to specified constraint found, sorry :(");
-    } else {
-        ROS_INFO("A* planner succesfully generated plan :)");
+// Rasterises a constraint into rows of a GoalMask, tile by tile
+struct RowRasteriser
+{
+    static const unsigned int TILE_ROWS = 32;
+
+    GoalMask* mask;
+    tf::Transform constraint_to_world_tf;
+    unsigned int x_begin, x_end, y_begin, y_end;
+    unsigned int tile_step;
+
+    // Rows of the tiles first_tile, first_tile + tile_step, ...
+    void rasterise(ConstraintEvaluator* ce, unsigned int first_tile)
+    {
+        // The cell centers of a row are equally spaced in the constraint frame as well, so a row is evaluated as one line
+        double res = mask->getResolution();
+        tf::Vector3 step = constraint_to_world_tf.getBasis() * tf::Vector3(res, 0, 0);
+        std::vector<unsigned char> row(x_end - x_begin + 1);
+
+        for (unsigned int tile_y = y_begin + first_tile * TILE_ROWS; tile_y < y_end; tile_y += tile_step * TILE_ROWS) {
+            for (unsigned int j = tile_y; j < std::min(tile_y + TILE_ROWS, y_end); ++j) {
+                tf::Point pw(mask->getOriginX() + (x_begin + 0.5) * res, mask->getOriginY() + (j + 0.5) * res, 0);
+                tf::Point pc = constraint_to_world_tf*pw;
+
+                ce->evaluateLine(pc.x(), pc.y(), step.x(), step.y(), x_end - x_begin, &row[0]);
+                mask->setRow(j, x_begin, x_end - x_begin, &row[0]);
+            }
+        }
     }
-    return true;
+};
+
 }
 
 bool AStarPlannerGPP::updateConstraintPositionsInConstraintFrame(PositionConstraint position_constraint)
 {
     ROS_INFO("Position constraint has been changed, updating positions in constraint frame.");
 
-    // Clear the constraint positions in constraint world
-    goal_positions_in_constraint_frame_.clear();
+    // Goals we have been to before are not rasterised again, unless the costmap has changed its geometry
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    goal_region_ = constraint_cache_.find(position_constraint);
+    if (goal_region_ && goal_region_->mask.hasGeometry(costmap->getSizeInCellsX(), costmap->getSizeInCellsY(),
+                                                       costmap->getOriginX(), costmap->getOriginY(), costmap->getResolution())) {
+        ROS_DEBUG_STREAM("[A* Planner] Constraint cache hit (" << constraint_cache_.getHits() << " hits, " << constraint_cache_.getMisses()
+                         << " misses, " << constraint_cache_.size() << " entries, " << constraint_cache_.getMemoryUsage() / 1024 << " kB).");
+        return true;
+    }
 
     // Request the constraint frame transform from map
     tf::Transform world_to_constraint_tf;
-    if (!queryEntityPose(position_constraint.frame, world_to_constraint_tf))
+    if (!queryEntityPose(position_constraint.frame, world_to_constraint_tf)) {
+        goal_region_ = NULL;
         return false;
-
-    tf::Transform constraint_to_world_tf = world_to_constraint_tf.inverse();
+    }
 
 //    try {
 //        tf_->lookupTransform(position_constraint.frame, global_costmap_ros_->getGlobalFrameID(), ros::Time(0), constraint_to_world_tf);
@@ -203,31 +725,183 @@ bool AStarPlannerGPP::updateConstraintPositionsInConstraintFrame(PositionConstra
 //        return false;
 //    }
 
-    ConstraintEvaluator ce;
+    boost::shared_ptr<ConstraintEvaluator> ce;
+    if (goal_region_) {
+        ce = goal_region_->evaluator;
+    } else {
+        ce.reset(new ConstraintEvaluator);
+        if (!ce->init(position_constraint.constraint)) {
+            ROS_ERROR("Could not setup goal constraints...");
+            goal_region_ = NULL;
+            return false;
+        }
+        goal_region_ = constraint_cache_.insert(position_constraint);
+        goal_region_->evaluator = ce;
+    }
 
-    if (!ce.init(position_constraint.constraint)) {
-        ROS_ERROR("Could not setup goal constraints...");
+    statistics_.constraint_cache_hit = false;
+    bool rasterised;
+    {
+        StageTimer timer(statistics_.constraint);
+        rasterised = rasteriseConstraint(*ce, world_to_constraint_tf, *goal_region_);
+    }
+    if (!rasterised) {
+        constraint_cache_.erase(position_constraint);
+        goal_region_ = NULL;
         return false;
     }
+    constraint_cache_.enforceLimits();
 
-    // Iterate over all costmap cells and evaluate the constraint in the constraint frame
-    for (unsigned int i = 0; i < global_costmap_ros_->getCostmap()->getSizeInCellsX(); ++i) {
-        for (unsigned int j = 0; j < global_costmap_ros_->getCostmap()->getSizeInCellsY(); ++j) {
-
-            double wx,wy;
-            global_costmap_ros_->getCostmap()->mapToWorld(i,j,wx,wy);
-            tf::Point pw(wx,wy,0);
-            tf::Point pc = constraint_to_world_tf*pw;
+    return true;
+}
 
-            if(ce.evaluate(pc.x(),pc.y())) {
-                //ROS_INFO_STREAM("Pushing back in constraint frame point: " << pc.x() << " - " << pc.y());
-                goal_positions_in_constraint_frame_.push_back(pc);
-            }
+bool AStarPlannerGPP::rasteriseConstraint(ConstraintEvaluator& ce, const tf::Transform& world_to_constraint_tf, ConstraintGoalRegion& region)
+{
+    // Rasterise the constraint into a bit mask over the costmap
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    unsigned int size_x = costmap->getSizeInCellsX(), size_y = costmap->getSizeInCellsY();
+    region.mask.reset(size_x, size_y, costmap->getOriginX(), costmap->getOriginY(), costmap->getResolution());
+    region.world_to_constraint = world_to_constraint_tf;
+
+    unsigned int x_begin = 0, x_end = size_x, y_begin = 0, y_end = size_y;
+    getConstraintCellRange(ce, world_to_constraint_tf, x_begin, x_end, y_begin, y_end);
+
+    RowRasteriser rasteriser;
+    rasteriser.mask = &region.mask;
+    rasteriser.constraint_to_world_tf = world_to_constraint_tf.inverse();
+    rasteriser.x_begin = x_begin; rasteriser.x_end = x_end;
+    rasteriser.y_begin = y_begin; rasteriser.y_end = y_end;
+
+    // Row tiles are handed out round robin, every worker thread gets its own copy of the evaluator
+    unsigned int num_tiles = (y_end - y_begin + RowRasteriser::TILE_ROWS - 1) / RowRasteriser::TILE_ROWS;
+    unsigned int num_threads = std::max(1u, std::min(constraint_threads_, num_tiles));
+    rasteriser.tile_step = num_threads;
+
+    std::vector<ConstraintEvaluator> evaluators(num_threads - 1);
+    for (unsigned int t = 0; t < evaluators.size(); ++t) {
+        if (!evaluators[t].initCopy(ce)) {
+            ROS_ERROR("Could not setup goal constraints...");
+            return false;
         }
     }
+
+    boost::thread_group workers;
+    for (unsigned int t = 1; t < num_threads; ++t) {
+        workers.create_thread(boost::bind(&RowRasteriser::rasterise, &rasteriser, &evaluators[t - 1], t));
+    }
+    rasteriser.rasterise(&ce, 0);
+    workers.join_all();
+
+    ROS_DEBUG_STREAM("[A* Planner] Rasterised constraint '" << ce.getConstraint() << "' "
+                     << (ce.isBatched() ? "in batches" : "with exprtk") << " over " << (x_end - x_begin) << " x " << (y_end - y_begin)
+                     << " cells: " << region.mask.count() << " goal cells.");
     return true;
 }
 
+void AStarPlannerGPP::getConstraintCellRange(const ConstraintEvaluator& ce, const tf::Transform& world_to_constraint_tf,
+                                             unsigned int& x_begin, unsigned int& x_end, unsigned int& y_begin, unsigned int& y_end)
+{
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    double res = costmap->getResolution();
+    tf::Transform constraint_to_world_tf = world_to_constraint_tf.inverse();
+
+    // Domain: the costmap in the constraint frame
+    double wx[2] = { costmap->getOriginX(), costmap->getOriginX() + x_end * res };
+    double wy[2] = { costmap->getOriginY(), costmap->getOriginY() + y_end * res };
+    double min_x = DBL_MAX, min_y = DBL_MAX, max_x = -DBL_MAX, max_y = -DBL_MAX;
+    for (unsigned int i = 0; i < 4; ++i) {
+        tf::Point pc = constraint_to_world_tf * tf::Point(wx[i % 2], wy[i / 2], 0);
+        min_x = std::min(min_x, pc.x()); max_x = std::max(max_x, pc.x());
+        min_y = std::min(min_y, pc.y()); max_y = std::max(max_y, pc.y());
+    }
+
+    double bb_min_x, bb_min_y, bb_max_x, bb_max_y;
+    if (!ce.getBoundingBox(min_x, min_y, max_x, max_y, 4 * res, bb_min_x, bb_min_y, bb_max_x, bb_max_y)) return;
+
+    if (bb_min_x > bb_max_x) {
+        // nothing meets the constraint
+        x_end = x_begin;
+        y_end = y_begin;
+        return;
+    }
+
+    // The bounding box in the world frame, plus a cell margin
+    double bx[2] = { bb_min_x, bb_max_x }, by[2] = { bb_min_y, bb_max_y };
+    double w_min_x = DBL_MAX, w_min_y = DBL_MAX, w_max_x = -DBL_MAX, w_max_y = -DBL_MAX;
+    for (unsigned int i = 0; i < 4; ++i) {
+        tf::Point pw = world_to_constraint_tf * tf::Point(bx[i % 2], by[i / 2], 0);
+        w_min_x = std::min(w_min_x, pw.x()); w_max_x = std::max(w_max_x, pw.x());
+        w_min_y = std::min(w_min_y, pw.y()); w_max_y = std::max(w_max_y, pw.y());
+    }
+
+    int cell_min_x = (int) floor((w_min_x - costmap->getOriginX()) / res) - 1;
+    int cell_max_x = (int) floor((w_max_x - costmap->getOriginX()) / res) + 1;
+    int cell_min_y = (int) floor((w_min_y - costmap->getOriginY()) / res) - 1;
+    int cell_max_y = (int) floor((w_max_y - costmap->getOriginY()) / res) + 1;
+
+    x_begin = std::max(0, std::min((int) x_end, cell_min_x));
+    x_end = std::max((int) x_begin, std::min((int) x_end, cell_max_x + 1));
+    y_begin = std::max(0, std::min((int) y_end, cell_min_y));
+    y_end = std::max((int) y_begin, std::min((int) y_end, cell_max_y + 1));
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+// Collects the goal cells of a GoalMask that is rasterised for the current costmap and frame pose
+struct GoalCellCollector
+{
+    costmap_2d::Costmap2D* costmap;
+    const CostModel* cost_model;
+    std::vector<unsigned int>* mx;
+    std::vector<unsigned int>* my;
+    std::vector<tf::Point>* goal_positions;
+
+    void operator()(unsigned int x, unsigned int y)
+    {
+        // Check whether this point is blocked by an obstacle
+        if (cost_model->isBlocked(costmap->getCost(x, y))) return;
+
+        double wx,wy;
+        costmap->mapToWorld(x,y,wx,wy);
+        goal_positions->push_back(tf::Point(wx,wy,0));
+        mx->push_back(x); my->push_back(y);
+    }
+};
+
+// Moves the goal cells of a GoalMask along with its constraint frame into the current costmap
+struct MovedGoalCellCollector : public GoalCellCollector
+{
+    const GoalMask* mask;
+    tf::Transform delta;  // world positions at rasterisation time to current world positions
+
+    void operator()(unsigned int x, unsigned int y)
+    {
+        double res = mask->getResolution();
+        tf::Point pw = delta * tf::Point(mask->getOriginX() + (x + 0.5) * res, mask->getOriginY() + (y + 0.5) * res, 0);
+
+        unsigned int mx_cell, my_cell;
+        if (costmap->worldToMap(pw.x(),pw.y(),mx_cell,my_cell)) {
+            if (cost_model->isBlocked(costmap->getCost(mx_cell, my_cell))) return;
+
+            goal_positions->push_back(pw);
+            mx->push_back(mx_cell); my->push_back(my_cell);
+        }
+    }
+};
+
+bool isIdentity(const tf::Transform& t)
+{
+    static const double EPSILON = 1e-9;
+    if (t.getOrigin().length2() > EPSILON) return false;
+    tf::Quaternion q = t.getRotation();
+    return (1.0 - fabs(q.w())) < EPSILON;
+}
+
+}
+
 bool AStarPlannerGPP::calculateMapConstraintArea(std::vector<unsigned int>& mx, std::vector<unsigned int>& my, std::vector<tf::Point>& goal_positions)
 {
     ROS_INFO("Calculating map constraint area ...");
@@ -244,24 +918,28 @@ bool AStarPlannerGPP::calculateMapConstraintArea(std::vector<unsigned int>& mx,
 //        return false;
 //    }
 
-    // Loop over the positions in the constraint frame and convert these to map points
-    std::vector<tf::Point>::const_iterator it = goal_positions_in_constraint_frame_.begin();
-    for (; it != goal_positions_in_constraint_frame_.end(); ++it) {
-        tf::Point pw = world_to_constraint_tf * *it;
-        //ROS_INFO_STREAM("Pushing back in world frame point: " << pw.x() << " - " << pw.y());
-        unsigned int x,y;
-        if (global_costmap_ros_->getCostmap()->worldToMap(pw.x(),pw.y(),x,y)) { // This should guarantee that we do not go off map, however the a* crashes sometimes
-
-            // Check whether this point is blocked by an obstacle
-            unsigned char goal_cell_cost = global_costmap_ros_->getCostmap()->getCost(x, y);
-            if (goal_cell_cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE || goal_cell_cost == costmap_2d::LETHAL_OBSTACLE) {
-                continue;
-            }
-
-            goal_positions.push_back(pw);
-            mx.push_back(x); my.push_back(y);
-            //ROS_INFO_STREAM("Pushing back in map point: " << x << ";" << y);
-        }
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    const GoalMask& goal_mask = goal_region_->mask;
+    tf::Transform delta = world_to_constraint_tf * goal_region_->world_to_constraint.inverse();
+
+    // Mostly neither the constraint frame nor the costmap has moved since the mask was rasterised
+    if (isIdentity(delta) && goal_mask.hasGeometry(costmap->getSizeInCellsX(), costmap->getSizeInCellsY(),
+                                                    costmap->getOriginX(), costmap->getOriginY(), costmap->getResolution())) {
+        GoalCellCollector collector;
+        collector.costmap = costmap;
+        collector.cost_model = &cost_model_;
+        collector.mx = &mx; collector.my = &my;
+        collector.goal_positions = &goal_positions;
+        goal_mask.forEach(collector);
+    } else {
+        MovedGoalCellCollector collector;
+        collector.costmap = costmap;
+        collector.cost_model = &cost_model_;
+        collector.mx = &mx; collector.my = &my;
+        collector.goal_positions = &goal_positions;
+        collector.mask = &goal_mask;
+        collector.delta = delta;
+        goal_mask.forEach(collector);
     }
 
     return true;
@@ -269,6 +947,11 @@ bool AStarPlannerGPP::calculateMapConstraintArea(std::vector<unsigned int>& mx,
 
 void AStarPlannerGPP::planToWorld(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<geometry_msgs::PoseStamped>& plan)
 {
+    if (simplify_plans_ && plan_xs.size() > 2) {
+        simplifiedPlanToWorld(plan_xs, plan_ys, plan);
+        return;
+    }
+
     ros::Time plan_time = ros::Time::now();
     std::string global_frame = global_costmap_ros_->getGlobalFrameID();
 
@@ -298,22 +981,68 @@ void AStarPlannerGPP::planToWorld(const std::vector<int>& plan_xs, const std::ve
     }
 }
 
+void AStarPlannerGPP::simplifiedPlanToWorld(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+    double resolution = costmap->getResolution();
+    path_simplifier_.setSpacing(simplify_spacing_ / resolution);
+    path_simplifier_.setMaxShortcut(simplify_max_shortcut_ / resolution);
+
+    std::vector<double> xs, ys;
+    path_simplifier_.simplify(costmap->getCharMap(), costmap->getSizeInCellsX(), costmap->getSizeInCellsY(), cost_model_, plan_xs, plan_ys, xs, ys);
+
+    ros::Time plan_time = ros::Time::now();
+    std::string global_frame = global_costmap_ros_->getGlobalFrameID();
+
+    // The points are on straight segments: every pose looks at the next one, the last one keeps the direction
+    plan.resize(xs.size());
+    for(unsigned int i = 0; i < xs.size(); ++i) {
+        plan[i].header.stamp = plan_time;
+        plan[i].header.frame_id = global_frame;
+        plan[i].pose.position.x = costmap->getOriginX() + xs[i] * resolution;
+        plan[i].pose.position.y = costmap->getOriginY() + ys[i] * resolution;
+        plan[i].pose.position.z = 0;
+    }
+    for(unsigned int i = 0; i + 1 < plan.size(); ++i) {
+        double yaw = atan2(ys[i+1] - ys[i], xs[i+1] - xs[i]);
+        plan[i].pose.orientation = tf::createQuaternionMsgFromYaw(yaw);
+    }
+    if (plan.size() > 1) plan.back().pose.orientation = plan[plan.size() - 2].pose.orientation;
+
+    ROS_DEBUG("[A* Planner] Simplified the plan from %u to %u poses.", (unsigned int) plan_xs.size(), (unsigned int) plan.size());
+}
+
 bool AStarPlannerGPP::checkPlan(const std::vector<geometry_msgs::PoseStamped>& plan)
 {
-    unsigned int mx,my;
-    unsigned char cost;
-    std::vector<geometry_msgs::PoseStamped>::const_iterator it = plan.begin();
-    for(; it != plan.end(); ++it) {
-        geometry_msgs::PoseStamped p;
-        if (global_costmap_ros_->getCostmap()->worldToMap(it->pose.position.x,it->pose.position.y,mx,my)) {
-            cost = global_costmap_ros_->getCostmap()->getCost(mx, my);
+    return findFirstBlockedPose(plan) < 0;
+}
 
-            if (cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE || cost == costmap_2d::LETHAL_OBSTACLE) { // This also has to be removed and replaced by a proper implementation
-                return false;
-            }
-        }
+int AStarPlannerGPP::findFirstBlockedPose(const std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    // Without the layer at the end of the costmap every check is a full one
+    const UpdatedBoundsLayer* layer = findUpdatedBoundsLayer();
+
+    // With a clearance layer the footprint is checked instead of the cost of the cell of a pose
+    const cb_base_navigation::ClearanceLayer* clearance = cb_base_navigation::ClearanceLayer::find(global_costmap_ros_->getLayeredCostmap());
+    cb_base_navigation::FootprintCover footprint;
+    if (clearance) footprint = cb_base_navigation::FootprintCover(global_costmap_ros_->getRobotFootprint(), global_costmap_ros_->getCostmap()->getResolution());
+
+    int blocked = plan_validity_.findFirstBlockedPose(*global_costmap_ros_->getCostmap(), cost_model_, layer, clearance, footprint, plan);
+    ROS_DEBUG("[A* Planner] Plan check: %u of %u poses checked, first blocked pose %d.", plan_validity_.getPosesChecked(), (unsigned int) plan.size(), blocked);
+    return blocked;
+}
+
+const UpdatedBoundsLayer* AStarPlannerGPP::findUpdatedBoundsLayer() const
+{
+    std::vector<boost::shared_ptr<costmap_2d::Layer> >* layers = global_costmap_ros_->getLayeredCostmap()->getPlugins();
+    for (std::vector<boost::shared_ptr<costmap_2d::Layer> >::iterator it = layers->begin(); it != layers->end(); ++it) {
+        const UpdatedBoundsLayer* layer = dynamic_cast<const UpdatedBoundsLayer*>(it->get());
+        if (!layer) continue;
+        if (layer->isLast()) return layer;
+        ROS_WARN_THROTTLE(10, "[A* Planner] The UpdatedBoundsLayer is not the last costmap layer, plans are checked completely.");
+        return NULL;
     }
-    return true;
+    return NULL;
 }
 
 } // end namespace
@@ -11,8 +11,14 @@
 #include <ros/ros.h>
 
 #include "a_star_planner.h"
+#include "cost_model.h"
+#include "constraint_cache.h"
+#include "landmark_heuristic.h"
+#include "path_simplifier.h"
+#include "plan_validity_tracker.h"
 #include "cb_base_navigation/global_planner/global_planner_plugin.h"
 #include "cb_base_navigation/global_planner/constraint_evaluator.h"
+#include "cb_base_navigation/entity_pose_cache.h"
 
 #include <costmap_2d/costmap_2d_ros.h>
 #include <geometry_msgs/PoseStamped.h>
@@ -20,6 +26,9 @@
 
 #include <tf/transform_datatypes.h>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
 #include <std_msgs/ColorRGBA.h>
 #include <visualization_msgs/Marker.h>
 
@@ -57,6 +66,21 @@ public:
      */
     bool makePlan(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions);
 
+    /**
+     * @brief makePlan with the anytime search (AStarPlanner::planAnytime) from anytime/initial_epsilon down in steps
+     *        of anytime/epsilon_step; the constraint time counts to the budget
+     */
+    bool makePlanAnytime(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, double time_budget,
+                         std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions, double& epsilon);
+
+    /**
+     * @brief Continues the anytime search as long as the costmap did not change since; needs an UpdatedBoundsLayer in
+     *        the costmap to see changes of the cells, without it the first plan is not improved
+     */
+    bool improvePlan(double time_budget, std::vector<geometry_msgs::PoseStamped>& plan, double& epsilon);
+
+    bool canImprovePlan() const;
+
     /**
      * @brief  Initialization function for the BaseGlobalPlanner
      * @param  name The name of this planner
@@ -65,25 +89,181 @@ public:
      */
     bool checkPlan(const std::vector<geometry_msgs::PoseStamped>& plan);
 
-private:
+    /**
+     * @brief First blocked pose of the plan; checking the same plan again only re-checks the parts the costmap changed
+     *        since, if the costmap has an UpdatedBoundsLayer as its last layer. With a ClearanceLayer the robot
+     *        footprint is checked instead of the cell of a pose.
+     */
+    int findFirstBlockedPose(const std::vector<geometry_msgs::PoseStamped>& plan);
+
+    void getStatistics(cb_base_navigation::PlanStatistics& statistics) const;
+
+    bool getConstraintFramePose(tf::Transform& pose) const;
+
+    /**
+     * @brief Plans to several goal constraints with one search from the robot (see AStarPlanner::planBatch)
+     * @param costs Plan costs in planner cost units (the traversal times of the cost model along the plan, without a
+     *        penalty for the goal tier), -1 if a constraint cannot be reached
+     * @param failed Per constraint 1 if no goal cells could be computed for it (as makePlan, a warning is logged)
+     */
+    bool makePlans(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                   std::vector<std::vector<geometry_msgs::PoseStamped> >& plans, std::vector<double>& costs, std::vector<unsigned char>& failed);
+
+    /**
+     * @brief Costs and lengths of the plans of makePlans, from the same search, without the plans
+     */
+    bool getPlanCosts(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                      std::vector<double>& costs, std::vector<double>& lengths, std::vector<unsigned char>& failed);
+
+    /**
+     * @brief Instances only read the costmap and keep their search state to themselves
+     */
+    bool supportsConcurrentRequests() const { return true; }
+
+protected:
 
     costmap_2d::Costmap2DROS* global_costmap_ros_;
+    CostModel cost_model_;
+
+    /**
+     * @brief Plans from the goal cells, divided in tiers (see CostModel::getGoalTier), to the robot cell
+     * @param plan_xs, plan_ys The plan from the robot cell to a goal cell, empty if there is none
+     * @return True if a plan was found
+     */
+    virtual bool planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                 std::vector<int>& plan_xs, std::vector<int>& plan_ys);
+
+    //! Stages and counters of the last makePlan; planToGoalCells adds its search runs (tier_searches, tier, counters)
+    cb_base_navigation::PlanStatistics statistics_;
+
+    void addSearchStatistics(const AStarPlanner::SearchStatistics& stats);
+
+    /**
+     * @brief Whether makePlanAnytime uses the anytime search of the A* planner; planners that replace planToGoalCells
+     *        return false, their makePlanAnytime plans with planToGoalCells
+     */
+    virtual bool supportsAnytimeSearch() const { return true; }
+
+private:
+
 	AStarPlanner* planner_;
     tf::TransformListener* tf_;
     bool initialized_;
 
+    /**
+     * @brief makePlan and makePlanAnytime, a negative time budget plans with planToGoalCells
+     */
+    bool planRequest(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, double time_budget,
+                     std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions, double& epsilon);
+
     bool constraintChanged(PositionConstraint c) { return (position_constraint_.constraint != c.constraint || position_constraint_.frame != c.frame); }
 
     bool updateConstraintPositionsInConstraintFrame(PositionConstraint position_constraint);
+
+    /**
+     * @brief Goal cells that meet a constraint, divided in the CostModel::NUM_GOAL_TIERS tiers
+     */
+    bool calculateGoalTiers(const PositionConstraint& position_constraint, std::vector<unsigned int>* mx_tier, std::vector<unsigned int>* my_tier,
+                            std::vector<tf::Point>& goal_positions);
+
+    /**
+     * @brief Hands the planner the current costmap (and landmark heuristic)
+     */
+    void prepareSearch();
+
+    /**
+     * @brief One search from the robot to all constraints, costs -1 and the other outputs empty for the constraints it does not reach
+     * @param failed Per constraint 1 if no goal cells could be computed for it, see makePlans
+     * @param plans_xs, plans_ys, lengths Optional (NULL), see AStarPlanner::planBatch
+     */
+    bool planToConstraints(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints, std::vector<double>& costs,
+                           std::vector<unsigned char>& failed, std::vector<std::vector<int> >* plans_xs, std::vector<std::vector<int> >* plans_ys, std::vector<double>* lengths);
+
+    /**
+     * @brief Rasterises a constraint over the current costmap into region (mask and frame pose)
+     */
+    bool rasteriseConstraint(ConstraintEvaluator& ce, const tf::Transform& world_to_constraint_tf, ConstraintGoalRegion& region);
+
+    /**
+     * @brief Narrows the cell range [x_begin, x_end) x [y_begin, y_end) to the cells that may meet the constraint
+     */
+    void getConstraintCellRange(const ConstraintEvaluator& ce, const tf::Transform& world_to_constraint_tf,
+                                unsigned int& x_begin, unsigned int& x_end, unsigned int& y_begin, unsigned int& y_end);
     bool evaluateConstraint(const tf::Point& p);
     bool calculateMapConstraintArea(std::vector<unsigned int>& mx, std::vector<unsigned int>& my, std::vector<tf::Point>& goal_positions);
     void planToWorld(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<geometry_msgs::PoseStamped>& plan);
 
     PositionConstraint position_constraint_;
-    std::vector<tf::Point> goal_positions_in_constraint_frame_;
 
-    //! World model client
-    ros::ServiceClient ed_client_;
+    //! Recently used constraints, goal_region_ is the entry of position_constraint_
+    ConstraintCache constraint_cache_;
+    ConstraintGoalRegion* goal_region_;
+
+    //! Whether the last makePlan got a goal region, so its goal_region_ is the one it used
+    bool has_goal_region_;
+
+    //! Number of threads that rasterise a new constraint
+    unsigned int constraint_threads_;
+
+    //! Search all goal tiers at once instead of one search per tier
+    bool single_tier_search_;
+
+    //! Landmark heuristic over the static layer (heuristic: landmarks), rebuilt in the background when that layer changes
+    bool use_landmarks_;
+    std::string landmark_layer_;
+    unsigned int num_landmarks_;
+    std::vector<unsigned char> landmark_map_;            // static layer of the latest build
+    unsigned int landmark_map_width_, landmark_map_height_;
+    unsigned int landmark_version_;                      // incremented when the static layer changes
+    boost::shared_ptr<const LandmarkHeuristic> landmarks_;  // used by the planner, of landmark_version_
+
+    boost::thread landmark_thread_;
+    boost::mutex landmark_mutex_;                        // guards the build result below
+    boost::shared_ptr<const LandmarkHeuristic> landmark_result_;
+    unsigned int landmark_result_version_;
+    bool landmark_building_;
+
+    /**
+     * @brief Hands the planner the landmark heuristic of the current static layer, starts a rebuild if the layer changed
+     */
+    void updateLandmarkHeuristic();
+
+    void buildLandmarkHeuristic(std::vector<unsigned char> map, unsigned int width, unsigned int height, CostModel cost_model, unsigned int version);
+
+    //! Plan simplification (simplify/enabled): shortcuts and resampling before the plan is converted to poses
+    bool simplify_plans_;
+    double simplify_spacing_;       // [m]
+    double simplify_max_shortcut_;  // [m]
+    PathSimplifier path_simplifier_;
+
+    void simplifiedPlanToWorld(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<geometry_msgs::PoseStamped>& plan);
+
+    //! Anytime search (anytime/initial_epsilon, anytime/epsilon_step) and the costmap of the search improvePlan continues
+    double anytime_initial_epsilon_, anytime_epsilon_step_;
+    bool anytime_valid_;
+    const unsigned char* anytime_char_map_;
+    unsigned int anytime_size_x_, anytime_size_y_;
+    double anytime_origin_x_, anytime_origin_y_;
+    unsigned int anytime_version_;      // of the UpdatedBoundsLayer, if there is one
+
+    bool planToGoalCellsAnytime(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                double time_budget, std::vector<int>& plan_xs, std::vector<int>& plan_ys, double& epsilon);
+
+    /**
+     * @brief Whether the costmap is still the one of the anytime search
+     */
+    bool anytimeCostmapUnchanged() const;
+
+    /**
+     * @brief The UpdatedBoundsLayer of the costmap if it is its last layer, NULL otherwise
+     */
+    const UpdatedBoundsLayer* findUpdatedBoundsLayer() const;
+
+    //! Validity of the last checked plan
+    PlanValidityTracker plan_validity_;
+
+    //! World model entity poses, one cache for all planner instances in the process
+    boost::shared_ptr<cb_base_navigation::EntityPoseCache> entity_poses_;
 
     bool queryEntityPose(const std::string& id, tf::Transform& pose);
 
@@ -0,0 +1,67 @@
+#include "constraint_cache.h"
+
+#include <algorithm>
+
+namespace cb_global_planner {
+
+ConstraintCache::ConstraintCache() : max_entries_(8), max_memory_(64 * 1024 * 1024), hits_(0), misses_(0), evictions_(0) {}
+
+void ConstraintCache::setLimits(unsigned int max_entries, unsigned int max_memory)
+{
+    max_entries_ = std::max(1u, max_entries);
+    max_memory_ = max_memory;
+    enforceLimits();
+}
+
+ConstraintGoalRegion* ConstraintCache::find(const cb_planner_msgs_srvs::PositionConstraint& constraint)
+{
+    std::map<Key, EntryList::iterator>::iterator it = index_.find(key(constraint));
+    if (it == index_.end()) {
+        ++misses_;
+        return NULL;
+    }
+
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+}
+
+ConstraintGoalRegion* ConstraintCache::insert(const cb_planner_msgs_srvs::PositionConstraint& constraint)
+{
+    erase(constraint);
+
+    entries_.push_front(std::make_pair(key(constraint), ConstraintGoalRegion()));
+    index_[entries_.front().first] = entries_.begin();
+    return &entries_.front().second;
+}
+
+void ConstraintCache::erase(const cb_planner_msgs_srvs::PositionConstraint& constraint)
+{
+    std::map<Key, EntryList::iterator>::iterator it = index_.find(key(constraint));
+    if (it == index_.end()) return;
+
+    entries_.erase(it->second);
+    index_.erase(it);
+}
+
+void ConstraintCache::enforceLimits()
+{
+    unsigned int memory = getMemoryUsage();
+    while (entries_.size() > 1 && (entries_.size() > max_entries_ || memory > max_memory_)) {
+        memory -= entries_.back().second.mask.getMemoryUsage();
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+unsigned int ConstraintCache::getMemoryUsage() const
+{
+    unsigned int memory = 0;
+    for (EntryList::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+        memory += it->second.mask.getMemoryUsage();
+    }
+    return memory;
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef cb_global_planner_CONSTRAINT_CACHE_H_
+#define cb_global_planner_CONSTRAINT_CACHE_H_
+
+#include "goal_mask.h"
+#include "cb_base_navigation/global_planner/constraint_evaluator.h"
+
+#include <cb_planner_msgs_srvs/PositionConstraint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <tf/transform_datatypes.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace cb_global_planner {
+
+/**
+ * @brief A compiled position constraint and the cells that meet it
+ */
+struct ConstraintGoalRegion
+{
+    boost::shared_ptr<ConstraintEvaluator> evaluator;
+
+    //! Goal cells, rasterised with the constraint frame at world_to_constraint
+    GoalMask mask;
+    tf::Transform world_to_constraint;
+};
+
+/**
+ * @class ConstraintCache
+ * @brief Least recently used cache of goal regions keyed by (frame, constraint)
+ *
+ * Bounded in the number of entries and in the memory of the goal masks. The most recently
+ * used entry is never evicted, so a pointer returned by find or insert stays valid until
+ * another constraint is looked up or inserted.
+ */
+class ConstraintCache
+{
+
+public:
+
+    ConstraintCache();
+
+    /**
+     * @brief Sets the limits and evicts entries that do not fit anymore
+     * @param max_entries Maximum number of cached constraints (at least 1)
+     * @param max_memory Maximum memory of the goal masks [bytes]
+     */
+    void setLimits(unsigned int max_entries, unsigned int max_memory);
+
+    /**
+     * @brief Returns the cached region of a constraint and marks it most recently used, NULL if it is not cached
+     */
+    ConstraintGoalRegion* find(const cb_planner_msgs_srvs::PositionConstraint& constraint);
+
+    /**
+     * @brief Adds an empty region for a constraint (replaces a cached one) and marks it most recently used
+     */
+    ConstraintGoalRegion* insert(const cb_planner_msgs_srvs::PositionConstraint& constraint);
+
+    /**
+     * @brief Removes a constraint, e.g. after it failed to rasterise
+     */
+    void erase(const cb_planner_msgs_srvs::PositionConstraint& constraint);
+
+    /**
+     * @brief Evicts least recently used entries until the limits hold (call after filling an inserted region)
+     */
+    void enforceLimits();
+
+    unsigned int size() const { return entries_.size(); }
+    unsigned int getMemoryUsage() const;
+
+    unsigned int getHits() const { return hits_; }
+    unsigned int getMisses() const { return misses_; }
+    unsigned int getEvictions() const { return evictions_; }
+
+private:
+
+    typedef std::pair<std::string, std::string> Key;  // (frame, constraint)
+    typedef std::list<std::pair<Key, ConstraintGoalRegion> > EntryList;
+
+    EntryList entries_;                         // most recently used first
+    std::map<Key, EntryList::iterator> index_;
+
+    unsigned int max_entries_;
+    unsigned int max_memory_;
+
+    unsigned int hits_, misses_, evictions_;
+
+    static Key key(const cb_planner_msgs_srvs::PositionConstraint& constraint) { return Key(constraint.frame, constraint.constraint); }
+
+};
+
+}
+
+#endif /* CONSTRAINT_CACHE_H_ */
@@ -0,0 +1,52 @@
+#include "cost_model.h"
+
+#include <costmap_2d/cost_values.h>
+
+#include <float.h> // for DBL_MAX
+
+namespace cb_global_planner {
+
+CostModel::CostModel() {
+	configure(1.0, false, false, costmap_2d::FREE_SPACE);
+}
+
+void CostModel::configure(double max_velocity, bool inscribed_is_traversable, bool unknown_is_traversable, unsigned char unknown_cost) {
+	for (unsigned int cost = 0; cost < 256; ++cost) {
+		double max_vel = (1 - (double) cost / 256) * max_velocity;
+		traversal_time_[cost] = 1 / max_vel; // cell_size
+
+		blocked_[cost] = false;
+
+		// ToDo: divided by four is magic number
+		if (cost == costmap_2d::FREE_SPACE) {
+			goal_tier_[cost] = 0;
+		} else if (cost < costmap_2d::INSCRIBED_INFLATED_OBSTACLE / 4) {
+			goal_tier_[cost] = 1;
+		} else {
+			goal_tier_[cost] = 2;
+		}
+	}
+
+	traversal_time_[costmap_2d::LETHAL_OBSTACLE] = DBL_MAX;
+	blocked_[costmap_2d::LETHAL_OBSTACLE] = true;
+
+	if (!inscribed_is_traversable) {
+		traversal_time_[costmap_2d::INSCRIBED_INFLATED_OBSTACLE] = DBL_MAX;
+		blocked_[costmap_2d::INSCRIBED_INFLATED_OBSTACLE] = true;
+	}
+
+	if (unknown_is_traversable) {
+		traversal_time_[costmap_2d::NO_INFORMATION] = traversal_time_[unknown_cost];
+	} else {
+		traversal_time_[costmap_2d::NO_INFORMATION] = DBL_MAX; // Do not plan through unknown space
+	}
+
+	min_traversal_time_ = DBL_MAX;
+	max_traversal_time_ = 0;
+	for (unsigned int cost = 0; cost < 256; ++cost) {
+		if (traversal_time_[cost] < min_traversal_time_) min_traversal_time_ = traversal_time_[cost];
+		if (traversal_time_[cost] < DBL_MAX && traversal_time_[cost] > max_traversal_time_) max_traversal_time_ = traversal_time_[cost];
+	}
+}
+
+}
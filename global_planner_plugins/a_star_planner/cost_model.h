@@ -0,0 +1,76 @@
+#ifndef cb_global_planner_COST_MODEL_H_
+#define cb_global_planner_COST_MODEL_H_
+
+namespace cb_global_planner {
+
+/**
+ * @class CostModel
+ * @brief Maps costmap cell values (0-255) to traversal times with a precomputed lookup table.
+ *
+ * One place for everything the A* plugin derives from a cell value: the time it takes to
+ * pass a cell (planning), whether a plan may contain the cell (goal area, checkPlan) and
+ * the goal tier (free / low / high cost) that is used to prefer goals away from obstacles.
+ */
+class CostModel {
+
+public:
+
+	static const unsigned int NUM_GOAL_TIERS = 3;
+
+	/**
+	 * @brief Constructs the default cost model: max velocity 1, inscribed, lethal and unknown cells are not traversable
+	 */
+	CostModel();
+
+	/**
+	 * @brief Recomputes the lookup tables
+	 * @param max_velocity Velocity in a free cell [cells/s], scales down linearly with the cell cost
+	 * @param inscribed_is_traversable Whether cells with INSCRIBED_INFLATED_OBSTACLE may be planned through
+	 * @param unknown_is_traversable Whether cells with NO_INFORMATION may be planned through
+	 * @param unknown_cost Cell value that is used for NO_INFORMATION cells if they are traversable
+	 */
+	void configure(double max_velocity, bool inscribed_is_traversable, bool unknown_is_traversable, unsigned char unknown_cost);
+
+	/**
+	 * @brief Time it takes to pass a cell with this value, DBL_MAX if it is not traversable
+	 */
+	inline double getTraversalTime(unsigned char cost) const { return traversal_time_[cost]; }
+
+	/**
+	 * @brief Lowest traversal time over all cell values (lower bound for the heuristic)
+	 */
+	inline double getMinTraversalTime() const { return min_traversal_time_; }
+
+	/**
+	 * @brief Highest finite traversal time over all cell values (upper bound for path costs)
+	 */
+	inline double getMaxTraversalTime() const { return max_traversal_time_; }
+
+	/**
+	 * @brief Whether a goal position or plan pose on a cell with this value is in collision
+	 */
+	inline bool isBlocked(unsigned char cost) const { return blocked_[cost]; }
+
+	/**
+	 * @brief Goal tier of a cell value: 0 (free), 1 (low cost) or 2 (high cost)
+	 */
+	inline unsigned int getGoalTier(unsigned char cost) const { return goal_tier_[cost]; }
+
+	/**
+	 * @brief The full traversal time table, indexed by cell value
+	 */
+	inline const double* getTraversalTimeTable() const { return traversal_time_; }
+
+private:
+
+	double traversal_time_[256];
+	bool blocked_[256];
+	unsigned char goal_tier_[256];
+	double min_traversal_time_;
+	double max_traversal_time_;
+
+};
+
+}
+
+#endif /* COST_MODEL_H_ */
@@ -0,0 +1,110 @@
+#ifndef cb_global_planner_GOAL_MASK_H_
+#define cb_global_planner_GOAL_MASK_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace cb_global_planner {
+
+/**
+ * @class GoalMask
+ * @brief One bit per costmap cell that tells whether the cell satisfies the goal constraint.
+ *
+ * Rows are padded to whole 64 bit words so a row can be filled and scanned a word at a time.
+ * The mask also remembers the costmap geometry (origin, resolution) it was rasterised for.
+ * Different rows never share a word, so rows can be set from different threads.
+ */
+class GoalMask {
+
+public:
+
+	GoalMask() : width_(0), height_(0), words_per_row_(0), origin_x_(0), origin_y_(0), resolution_(0) {}
+
+	/**
+	 * @brief Clears the mask and sets its geometry
+	 */
+	void reset(unsigned int width, unsigned int height, double origin_x, double origin_y, double resolution) {
+		width_ = width;
+		height_ = height;
+		words_per_row_ = (width + 63) / 64;
+		origin_x_ = origin_x;
+		origin_y_ = origin_y;
+		resolution_ = resolution;
+		bits_.assign(words_per_row_ * height, 0);
+	}
+
+	/**
+	 * @brief Sets row y from one byte per cell (non-zero: goal cell) for cells x_begin .. x_begin + n - 1
+	 */
+	void setRow(unsigned int y, unsigned int x_begin, unsigned int n, const unsigned char* cells) {
+		uint64_t* row = &bits_[words_per_row_ * y];
+		for (unsigned int i = 0; i < n; ++i) {
+			if (cells[i]) {
+				unsigned int x = x_begin + i;
+				row[x >> 6] |= (uint64_t) 1 << (x & 63);
+			}
+		}
+	}
+
+	inline bool test(unsigned int x, unsigned int y) const {
+		return (bits_[words_per_row_ * y + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	/**
+	 * @brief Calls f(x, y) for every goal cell, row by row, skipping empty words
+	 */
+	template <class F>
+	void forEach(F& f) const {
+		for (unsigned int y = 0; y < height_; ++y) {
+			const uint64_t* row = &bits_[words_per_row_ * y];
+			for (unsigned int w = 0; w < words_per_row_; ++w) {
+				uint64_t word = row[w];
+				while (word) {
+					f(64 * w + __builtin_ctzll(word), y);
+					word &= word - 1;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Returns true if the mask was rasterised for this costmap geometry
+	 */
+	bool hasGeometry(unsigned int width, unsigned int height, double origin_x, double origin_y, double resolution) const {
+		return width_ == width && height_ == height && origin_x_ == origin_x && origin_y_ == origin_y && resolution_ == resolution;
+	}
+
+	unsigned int getWidth() const { return width_; }
+	unsigned int getHeight() const { return height_; }
+	double getOriginX() const { return origin_x_; }
+	double getOriginY() const { return origin_y_; }
+	double getResolution() const { return resolution_; }
+
+	/**
+	 * @brief Number of goal cells
+	 */
+	unsigned int count() const {
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < bits_.size(); ++i) n += __builtin_popcountll(bits_[i]);
+		return n;
+	}
+
+	/**
+	 * @brief Memory used by the bits [bytes]
+	 */
+	unsigned int getMemoryUsage() const { return bits_.size() * sizeof(uint64_t); }
+
+private:
+
+	unsigned int width_, height_;
+	unsigned int words_per_row_;
+	double origin_x_, origin_y_, resolution_;
+
+	std::vector<uint64_t> bits_;
+
+};
+
+}
+
+#endif /* GOAL_MASK_H_ */
@@ -0,0 +1,199 @@
+#include "jump_point_planner.h"
+
+namespace cb_global_planner {
+
+namespace {
+
+inline int sign(int v) { return (v > 0) - (v < 0); }
+
+}
+
+JumpPointPlanner::JumpPointPlanner(int width, int height) : AStarPlanner(width, height), uniform_time_(DBL_MAX), max_jump_(8) {
+}
+
+JumpPointPlanner::~JumpPointPlanner() {
+}
+
+bool JumpPointPlanner::planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	uniform_time_ = cost_model_.getMinTraversalTime();
+	seedStarts(mx_starts, my_starts, num_sets);
+
+	switch (open_list_type_) {
+	case OPEN_LIST_QUATERNARY:
+		return planJumpPoint(quaternary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	case OPEN_LIST_RADIX:
+		return planJumpPoint(radix_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	default:
+		return planJumpPoint(binary_open_, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+}
+
+bool JumpPointPlanner::isInterior(int k) const {
+	// cells next to the border are never interior: the border cells are blocked
+	int w = width_;
+	return isUniform(k) &&
+			isUniform(k - 1) && isUniform(k + 1) &&
+			isUniform(k - w - 1) && isUniform(k - w) && isUniform(k - w + 1) &&
+			isUniform(k + w - 1) && isUniform(k + w) && isUniform(k + w + 1);
+}
+
+int JumpPointPlanner::jump(int k, int dx, int dy, int k_goal, unsigned int& steps) const {
+	int w = width_;
+	int offset = dy * w + dx;
+
+	// A diagonal jump stops where one of its straight components finds something. Every
+	// straight walk over interior cells ends at a non-interior cell (at the latest next to
+	// the border), so that is always the case after one step.
+	if (dx != 0 && dy != 0) {
+		steps = 1;
+		return k + offset;
+	}
+
+	// Straight walk. k is interior, so every step lands on a traversable cell that is not on the
+	// border, and a step keeps the next cell interior if the three cells ahead of it are uniform.
+	// Stopping early at max_jump_ only adds an extra node on the line; the result is the same.
+	int side = (dx != 0) ? w : 1;
+	int n = k;
+	for (steps = 1; ; ++steps) {
+		n += offset;
+		if (n == k_goal || steps == max_jump_) return n;
+
+		int ahead = n + offset;
+		if (!isUniform(ahead) || !isUniform(ahead - side) || !isUniform(ahead + side)) return n;
+	}
+	return -1;
+}
+
+template <class OpenList>
+void JumpPointPlanner::pushSuccessor(OpenList& open, int k, int k_child, double g_child, int x_goal, int y_goal, double min_cell_cost) {
+	if (!nodes_.touch(k_child) || nodes_.isClosed(k_child)) return;
+
+	if (g_child < nodes_.g(k_child)) {
+		nodes_.g(k_child) = g_child;
+		nodes_.parent(k_child) = k;
+		open.push(k_child, g_child + calculateHeuristicCost(k_child % width_, k_child / width_, x_goal, y_goal, min_cell_cost));
+	}
+}
+
+template <class OpenList>
+void JumpPointPlanner::jumpAndPush(OpenList& open, int k, int dx, int dy, int k_goal, int x_goal, int y_goal, double min_cell_cost) {
+	unsigned int steps;
+	int k_jump = jump(k, dx, dy, k_goal, steps);
+	if (k_jump < 0) return;
+
+	// all cells before the jump point are uniform
+	double cost_factor = (dx != 0 && dy != 0) ? SQRT2 : 1.0;
+	double g_jump = nodes_.g(k) + ((steps - 1) * uniform_time_ + cost_model_.getTraversalTime(char_cost_map_[k_jump])) * cost_factor;
+	pushSuccessor(open, k, k_jump, g_jump, x_goal, y_goal, min_cell_cost);
+}
+
+template <class OpenList>
+bool JumpPointPlanner::planJumpPoint(OpenList& open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	static const int DX[8] = { -1, +1,  0,  0, -1, +1, -1, +1 };
+	static const int DY[8] = {  0,  0, -1, +1, -1, -1, +1, +1 };
+
+	double min_cell_cost = cost_model_.getMinTraversalTime();
+
+	open.prepare(width_ * height_);
+
+	// add start points to the open list
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		int k = starts_[i];
+		open.push(k, nodes_.g(k) + calculateHeuristicCost(k % width_, k / width_, mx_goal, my_goal, min_cell_cost));
+	}
+
+	int k_goal = width_ * my_goal + mx_goal;
+	int goal_cell = -1;
+	int best_cell = -1;
+
+	double best_score = 1e9;
+
+	unsigned int cells_expanded = 0;
+	unsigned int open_list_peak = open.size();
+
+	while(!open.empty()) {
+		int k = open.top();
+		double f = open.topKey();
+		open.pop();
+
+		if (nodes_.isClosed(k)) continue;
+		nodes_.close(k);
+		++cells_expanded;
+
+		if (k == k_goal) {
+			goal_cell = k;
+			break;
+		}
+
+		double h = f - nodes_.g(k);
+		if (h < best_score) {
+			best_cell = k;
+			best_score = h;
+		}
+
+		int k_parent = nodes_.parent(k);
+
+		if (!isInterior(k)) {
+			// regular expansion to all neighbours
+			for (unsigned int i = 0; i < 8; ++i) {
+				int k_child = k + DY[i] * (int) width_ + DX[i];
+				double cost_factor = (i < 4) ? 1.0 : SQRT2;
+				pushSuccessor(open, k, k_child, nodes_.g(k) + cost_model_.getTraversalTime(char_cost_map_[k_child]) * cost_factor,
+						mx_goal, my_goal, min_cell_cost);
+			}
+		} else if (k_parent < 0) {
+			// interior start cell: jump in all directions
+			for (unsigned int i = 0; i < 8; ++i) {
+				jumpAndPush(open, k, DX[i], DY[i], k_goal, mx_goal, my_goal, min_cell_cost);
+			}
+		} else {
+			// interior cell: only the natural neighbours in the direction of travel
+			int dx = sign((int) (k % width_) - (int) (k_parent % width_));
+			int dy = sign((int) (k / width_) - (int) (k_parent / width_));
+
+			if (dx != 0 && dy != 0) {
+				jumpAndPush(open, k, dx, 0, k_goal, mx_goal, my_goal, min_cell_cost);
+				jumpAndPush(open, k, 0, dy, k_goal, mx_goal, my_goal, min_cell_cost);
+			}
+			jumpAndPush(open, k, dx, dy, k_goal, mx_goal, my_goal, min_cell_cost);
+		}
+
+		open_list_peak = std::max(open_list_peak, open.size());
+	}
+
+	int trace_cell = goal_cell;
+	if (trace_cell < 0 && best_heuristic) {
+		trace_cell = best_cell;
+	}
+
+	// fill in the cells between consecutive jump points (straight or diagonal lines)
+	while (trace_cell >= 0) {
+		int x = trace_cell % width_;
+		int y = trace_cell / width_;
+
+		int k_parent = nodes_.parent(trace_cell);
+		if (k_parent < 0) {
+			plan_xs.push_back(x);
+			plan_ys.push_back(y);
+			break;
+		}
+
+		int x_parent = k_parent % width_;
+		int y_parent = k_parent / width_;
+		int dx = sign(x_parent - x);
+		int dy = sign(y_parent - y);
+		for (; x != x_parent || y != y_parent; x += dx, y += dy) {
+			plan_xs.push_back(x);
+			plan_ys.push_back(y);
+		}
+
+		trace_cell = k_parent;
+	}
+
+	finishStatistics(cells_expanded);
+	statistics_.open_list_peak = open_list_peak;
+
+	return (goal_cell >= 0);
+}
+
+}
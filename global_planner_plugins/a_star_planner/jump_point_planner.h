@@ -0,0 +1,74 @@
+#ifndef cb_global_planner_JUMPPOINTPLANNER_H_
+#define cb_global_planner_JUMPPOINTPLANNER_H_
+
+#include "a_star_planner.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class JumpPointPlanner
+ * @brief Jump Point Search variant of the AStarPlanner for costmaps with large uniform cost regions.
+ *
+ * A cell is 'interior' if it and its eight neighbours all have the lowest traversal time of
+ * the cost model (typically FREE_SPACE). Inside interior regions the search prunes symmetric
+ * paths and jumps along straight and diagonal lines, only generating nodes where the line
+ * reaches a non-interior cell (or the goal). Non-interior cells, e.g. near inflated obstacles,
+ * are expanded to all eight neighbours like the regular A* search, so plans have the same cost.
+ *
+ * Always uses the flat node storage; the open list type of the AStarPlanner is respected.
+ */
+class JumpPointPlanner : public AStarPlanner {
+
+public:
+
+	JumpPointPlanner(int width, int height);
+
+	virtual ~JumpPointPlanner();
+
+	/**
+	 * @brief Sets the maximum number of cells a straight jump may cover before a node is generated
+	 *
+	 * Unbounded jumps scan whole rows and columns, also away from the goal; a bound keeps that
+	 * work proportional to the nodes that are actually pushed.
+	 */
+	void setMaxJump(unsigned int max_jump) { max_jump_ = std::max(max_jump, 1u); }
+
+	unsigned int getMaxJump() const { return max_jump_; }
+
+protected:
+
+	virtual bool usesFlatNodes() const { return true; }
+
+	virtual bool planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	template <class OpenList>
+	bool planJumpPoint(OpenList& open, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	// traversal time of a cell in a uniform region
+	double uniform_time_;
+
+	// cells a straight jump covers at most
+	unsigned int max_jump_;
+
+	inline bool isUniform(int k) const { return !nodes_.isBlocked(k) && cost_model_.getTraversalTime(char_cost_map_[k]) == uniform_time_; }
+
+	bool isInterior(int k) const;
+
+	/**
+	 * @brief Walks from cell k in direction (dx, dy) over interior cells
+	 * @return The first cell that is the goal or not interior (and traversable), -1 if none
+	 * @param steps Number of steps taken to the returned cell
+	 */
+	int jump(int k, int dx, int dy, int k_goal, unsigned int& steps) const;
+
+	template <class OpenList>
+	void pushSuccessor(OpenList& open, int k, int k_child, double g_child, int x_goal, int y_goal, double min_cell_cost);
+
+	template <class OpenList>
+	void jumpAndPush(OpenList& open, int k, int dx, int dy, int k_goal, int x_goal, int y_goal, double min_cell_cost);
+
+};
+
+}
+
+#endif /* JUMPPOINTPLANNER_H_ */
@@ -0,0 +1,153 @@
+#include "landmark_heuristic.h"
+#include "open_list.h"
+
+#include <float.h> // for DBL_MAX
+
+namespace cb_global_planner {
+
+namespace {
+
+// the NO_INFORMATION cell value of costmap_2d
+const unsigned char NO_INFORMATION = 255;
+
+// the 8 neighbours, straight ones first
+const int NEIGHBOUR_DX[8] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+const int NEIGHBOUR_DY[8] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+const double NEIGHBOUR_FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, 1.414213562, 1.414213562, 1.414213562, 1.414213562 };
+
+}
+
+const float LandmarkHeuristic::UNREACHABLE;
+
+void LandmarkHeuristic::build(const unsigned char* map, unsigned int width, unsigned int height, const CostModel& cost_model, unsigned int num_landmarks) {
+	width_ = width;
+	height_ = height;
+	num_landmarks_ = 0;
+	max_distance_ = 0;
+	margin_ = 0;
+
+	unsigned int n = width_ * height_;
+	distances_.assign(n * num_landmarks, UNREACHABLE);
+	if (n == 0) return;
+
+	// static traversal times, the border cells are never used by the planner
+	std::vector<double> traversal_time(n, DBL_MAX);
+	for (unsigned int y = 1; y + 1 < height_; ++y) {
+		for (unsigned int x = 1; x + 1 < width_; ++x) {
+			int k = width_ * y + x;
+			traversal_time[k] = (map[k] == NO_INFORMATION) ? cost_model.getMinTraversalTime() : cost_model.getTraversalTime(map[k]);
+		}
+	}
+
+	// The landmarks are spread over the largest connected region, the one the robot drives in; the bound
+	// is 0 for the cells of other regions
+	int k_first = findLargestRegion(traversal_time);
+	if (k_first < 0) return;
+
+	// Farthest point selection: every landmark is the cell farthest from the landmarks so far. The first
+	// search only finds a far cell.
+	std::vector<double> distances, min_distance(n, DBL_MAX);
+	computeDistances(traversal_time, k_first, distances);
+	std::vector<unsigned char> in_region(n, 0);
+	for (unsigned int k = 0; k < n; ++k) in_region[k] = (distances[k] < DBL_MAX);
+
+	while (num_landmarks_ < num_landmarks) {
+		int k_landmark = -1;
+		double farthest = 0;
+		for (unsigned int k = 0; k < n; ++k) {
+			if (!in_region[k]) continue;
+			double d = (num_landmarks_ == 0) ? distances[k] : min_distance[k];
+			if (d > farthest) {
+				farthest = d;
+				k_landmark = k;
+			}
+		}
+		if (k_landmark < 0) break; // every cell is a landmark
+
+		computeDistances(traversal_time, k_landmark, distances);
+		for (unsigned int k = 0; k < n; ++k) {
+			if (distances[k] == DBL_MAX) continue;
+			distances_[k * num_landmarks + num_landmarks_] = distances[k];
+			min_distance[k] = std::min(min_distance[k], distances[k]);
+			max_distance_ = std::max(max_distance_, distances[k]);
+		}
+		++num_landmarks_;
+	}
+
+	// fewer landmarks than requested (e.g. a tiny map): keep the table dense
+	if (num_landmarks_ < num_landmarks) {
+		for (unsigned int k = 0; k < n; ++k) {
+			for (unsigned int l = 0; l < num_landmarks_; ++l) distances_[k * num_landmarks_ + l] = distances_[k * num_landmarks + l];
+		}
+		distances_.resize(n * num_landmarks_);
+	}
+
+	// a float keeps 24 bits, a difference of two rounded distances is off by at most two units in the last place
+	margin_ = max_distance_ * 4 * FLT_EPSILON;
+}
+
+int LandmarkHeuristic::findLargestRegion(const std::vector<double>& traversal_time) const {
+	std::vector<unsigned char> visited(traversal_time.size(), 0);
+	std::vector<int> stack;
+
+	int k_largest = -1;
+	unsigned int largest = 0;
+	for (unsigned int k_seed = 0; k_seed < traversal_time.size(); ++k_seed) {
+		if (visited[k_seed] || traversal_time[k_seed] == DBL_MAX) continue;
+
+		unsigned int size = 0;
+		visited[k_seed] = 1;
+		stack.push_back(k_seed);
+		while (!stack.empty()) {
+			int k = stack.back();
+			stack.pop_back();
+			++size;
+
+			unsigned int x = k % width_, y = k / width_;
+			for (unsigned int i = 0; i < 8; ++i) {
+				int k_next = width_ * (y + NEIGHBOUR_DY[i]) + x + NEIGHBOUR_DX[i];
+				if (visited[k_next] || traversal_time[k_next] == DBL_MAX) continue;
+				visited[k_next] = 1;
+				stack.push_back(k_next);
+			}
+		}
+
+		if (size > largest) {
+			largest = size;
+			k_largest = k_seed;
+		}
+	}
+	return k_largest;
+}
+
+void LandmarkHeuristic::computeDistances(const std::vector<double>& traversal_time, int k_source, std::vector<double>& distances) const {
+	distances.assign(traversal_time.size(), DBL_MAX);
+	distances[k_source] = 0;
+
+	BinaryOpenList open;
+	open.prepare(traversal_time.size());
+	open.push(k_source, 0);
+
+	while (!open.empty()) {
+		int k = open.top();
+		double d = open.topKey();
+		open.pop();
+
+		if (d > distances[k]) continue; // stale entry
+
+		unsigned int x = k % width_, y = k / width_;
+		for (unsigned int i = 0; i < 8; ++i) {
+			int k_next = width_ * (y + NEIGHBOUR_DY[i]) + x + NEIGHBOUR_DX[i];
+			if (traversal_time[k_next] == DBL_MAX) continue;
+
+			// never more than the step costs on the live costmap in either direction
+			double d_next = d + std::min(traversal_time[k], traversal_time[k_next]) * NEIGHBOUR_FACTOR[i];
+			if (d_next < distances[k_next]) {
+				distances[k_next] = d_next;
+				open.push(k_next, d_next);
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef cb_global_planner_LANDMARK_HEURISTIC_H_
+#define cb_global_planner_LANDMARK_HEURISTIC_H_
+
+#include <float.h> // for FLT_MAX
+#include <math.h> // for fabsf
+
+#include <algorithm>
+#include <vector>
+
+#include "cost_model.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class LandmarkHeuristic
+ * @brief Landmark (ALT) lower bounds on plan costs, precomputed over a static map.
+ *
+ * For a few landmark cells the table holds the distance from the landmark to every cell. By the triangle
+ * inequality |d(L, target) - d(L, k)| is a lower bound on the distance between k and the target, and unlike
+ * the Euclidean distance it accounts for the walls of the static map.
+ *
+ * The distances are those of a symmetric cost that never exceeds the cost the planner pays on the live
+ * costmap: a step between two cells costs the lower of the two traversal times, cells that are lethal in
+ * the static map are never entered and unknown cells are taken as free. The bound holds as long as the live
+ * costmap cells cost at least as much as the static ones (the layered costmap takes the maximum over its
+ * layers); the resulting heuristic is consistent.
+ *
+ * Distances are stored as floats, interleaved per cell, so a lookup reads one cache line per cell.
+ */
+class LandmarkHeuristic {
+
+public:
+
+	LandmarkHeuristic() : width_(0), height_(0), num_landmarks_(0), max_distance_(0), margin_(0) {}
+
+	/**
+	 * @brief Selects the landmarks (farthest first, in the largest connected region) and computes their distances
+	 * @param map Row-major static map of width x height cells (costmap cell values)
+	 * @param num_landmarks Number of landmarks, memory is 4 * num_landmarks bytes per cell
+	 */
+	void build(const unsigned char* map, unsigned int width, unsigned int height, const CostModel& cost_model, unsigned int num_landmarks);
+
+	unsigned int getWidth() const { return width_; }
+
+	unsigned int getHeight() const { return height_; }
+
+	unsigned int getNumLandmarks() const { return num_landmarks_; }
+
+	/**
+	 * @brief Highest lower bound the table can return
+	 */
+	double getMaxDistance() const { return max_distance_; }
+
+	/**
+	 * @brief Lower bound on the cost of the cheapest plan between two cells (either direction), 0 if unknown
+	 */
+	inline double lowerBound(int k, int k_target) const {
+		const float* d = &distances_[k * num_landmarks_];
+		const float* d_target = &distances_[k_target * num_landmarks_];
+
+		float bound = 0;
+		for (unsigned int l = 0; l < num_landmarks_; ++l) {
+			if (d[l] != UNREACHABLE && d_target[l] != UNREACHABLE) bound = std::max(bound, fabsf(d_target[l] - d[l]));
+		}
+		return std::max(0.0, bound - margin_);
+	}
+
+	/**
+	 * @brief Memory used by the table [bytes]
+	 */
+	unsigned int getMemoryUsage() const { return distances_.size() * sizeof(float); }
+
+private:
+
+	static const float UNREACHABLE = FLT_MAX;
+
+	unsigned int width_, height_;
+	unsigned int num_landmarks_;
+
+	std::vector<float> distances_;  // distances_[k * num_landmarks_ + l]: distance from landmark l to cell k
+
+	double max_distance_;
+
+	// subtracted from every bound, covers the float rounding of the stored distances
+	double margin_;
+
+	// Returns a cell of the largest 8-connected region of traversable cells, -1 if there are none
+	int findLargestRegion(const std::vector<double>& traversal_time) const;
+
+	// Dijkstra over the symmetric cost from cell k_source, DBL_MAX for cells that are not reached
+	void computeDistances(const std::vector<double>& traversal_time, int k_source, std::vector<double>& distances) const;
+
+};
+
+}
+
+#endif /* LANDMARK_HEURISTIC_H_ */
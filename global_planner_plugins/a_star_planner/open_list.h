@@ -0,0 +1,288 @@
+#ifndef cb_global_planner_OPEN_LIST_H_
+#define cb_global_planner_OPEN_LIST_H_
+
+#include <string.h> // for memcpy
+
+#include <algorithm>
+#include <vector>
+
+namespace cb_global_planner {
+
+/*
+ * Open list implementations for the flat A* search. They share the same interface:
+ *
+ *   prepare(n)   make sure cells 0 .. n-1 can be stored, empties the list
+ *   push(k, f)   insert cell k with key f, or lower its key if it is already in the list
+ *   empty()      true if no cells are left
+ *   top()        cell with the lowest key
+ *   topKey()     lowest key
+ *   pop()        removes top()
+ *   size()       number of entries (including stale ones for the lazy lists)
+ *
+ * The lazy lists (BinaryOpenList, RadixOpenList) do not support decrease-key: lowering
+ * a key pushes a duplicate entry, so the search has to skip cells that are already closed.
+ */
+
+// ----------------------------------------------------------------------------------------------------
+
+/**
+ * @class BinaryOpenList
+ * @brief Binary heap on f with duplicate entries (lazy decrease-key)
+ */
+class BinaryOpenList {
+
+public:
+
+	void prepare(unsigned int n) {
+		heap_.clear();
+		heap_.reserve(std::min(n, 4096u));
+	}
+
+	void push(int k, double f) {
+		heap_.push_back(Entry(f, k));
+		std::push_heap(heap_.begin(), heap_.end(), Compare());
+	}
+
+	bool empty() const { return heap_.empty(); }
+	int top() const { return heap_.front().k_; }
+	double topKey() const { return heap_.front().f_; }
+	unsigned int size() const { return heap_.size(); }
+
+	void pop() {
+		std::pop_heap(heap_.begin(), heap_.end(), Compare());
+		heap_.pop_back();
+	}
+
+private:
+
+	struct Entry {
+		double f_;   // f = g + h
+		int k_;      // cell id
+		Entry(double f, int k) : f_(f), k_(k) {}
+	};
+
+	struct Compare {
+		bool operator()(const Entry& e1, const Entry& e2) const {
+			return e1.f_ > e2.f_;
+		}
+	};
+
+	std::vector<Entry> heap_;  // capacity is kept over queries
+
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+/**
+ * @class IndexedDaryHeap
+ * @brief D-ary min heap with a position index per cell, supports decrease-key so every cell is in the list at most once
+ */
+template <class Key, unsigned int D = 4>
+class IndexedDaryHeap {
+
+public:
+
+	void prepare(unsigned int n) {
+		// only the cells left in the heap have to be unindexed, O(heap size)
+		if (pos_.size() != n) {
+			pos_.assign(n, -1);
+		} else {
+			for (unsigned int i = 0; i < heap_.size(); ++i) pos_[heap_[i].k_] = -1;
+		}
+		heap_.clear();
+	}
+
+	void push(int k, const Key& key) {
+		int i = pos_[k];
+		if (i < 0) {
+			i = heap_.size();
+			heap_.push_back(Entry(key, k));
+			pos_[k] = i;
+			siftUp(i);
+		} else if (key < heap_[i].key_) {
+			heap_[i].key_ = key;
+			siftUp(i);
+		} else if (heap_[i].key_ < key) {
+			heap_[i].key_ = key;
+			siftDown(i);
+		}
+	}
+
+	bool contains(int k) const { return pos_[k] >= 0; }
+
+	void remove(int k) {
+		int i = pos_[k];
+		if (i < 0) return;
+		pos_[k] = -1;
+		Entry last = heap_.back();
+		heap_.pop_back();
+		if (i < (int) heap_.size()) {
+			heap_[i] = last;
+			pos_[last.k_] = i;
+			siftUp(i);
+			siftDown(pos_[last.k_]);
+		}
+	}
+
+	bool empty() const { return heap_.empty(); }
+	int top() const { return heap_.front().k_; }
+	const Key& topKey() const { return heap_.front().key_; }
+	unsigned int size() const { return heap_.size(); }
+
+	void pop() { remove(heap_.front().k_); }
+
+private:
+
+	struct Entry {
+		Key key_;
+		int k_;
+		Entry(const Key& key, int k) : key_(key), k_(k) {}
+	};
+
+	std::vector<Entry> heap_;
+	std::vector<int> pos_;   // index in heap_ per cell, -1 if not in the heap
+
+	void siftUp(int i) {
+		Entry e = heap_[i];
+		while (i > 0) {
+			int parent = (i - 1) / D;
+			if (!(e.key_ < heap_[parent].key_)) break;
+			heap_[i] = heap_[parent];
+			pos_[heap_[i].k_] = i;
+			i = parent;
+		}
+		heap_[i] = e;
+		pos_[e.k_] = i;
+	}
+
+	void siftDown(int i) {
+		Entry e = heap_[i];
+		int n = heap_.size();
+		while (true) {
+			int first = D * i + 1;
+			if (first >= n) break;
+			int last = std::min(first + (int) D, n);
+			int best = first;
+			for (int c = first + 1; c < last; ++c) {
+				if (heap_[c].key_ < heap_[best].key_) best = c;
+			}
+			if (!(heap_[best].key_ < e.key_)) break;
+			heap_[i] = heap_[best];
+			pos_[heap_[i].k_] = i;
+			i = best;
+		}
+		heap_[i] = e;
+		pos_[e.k_] = i;
+	}
+
+};
+
+typedef IndexedDaryHeap<double, 4> QuaternaryOpenList;
+
+// ----------------------------------------------------------------------------------------------------
+
+/**
+ * @class RadixOpenList
+ * @brief Monotone radix heap on f with duplicate entries (lazy decrease-key)
+ *
+ * Requires that pushed keys are never lower than the last popped key, which holds for A*
+ * with a consistent heuristic. Keys are non-negative doubles; their IEEE bit patterns are
+ * ordered like the values, so the buckets are formed on the 64 bit integer representation.
+ * Keys that are slightly below the last popped key due to rounding are clamped to it.
+ */
+class RadixOpenList {
+
+public:
+
+	RadixOpenList() : last_(0), size_(0) {}
+
+	void prepare(unsigned int n) {
+		for (unsigned int b = 0; b < NUM_BUCKETS; ++b) buckets_[b].clear();
+		last_ = 0;
+		size_ = 0;
+	}
+
+	void push(int k, double f) {
+		unsigned long long key = toBits(f);
+		if (key < last_) key = last_;
+		buckets_[bucketIndex(key)].push_back(Entry(key, k));
+		++size_;
+	}
+
+	bool empty() const { return size_ == 0; }
+
+	int top() {
+		refill();
+		return buckets_[0].back().k_;
+	}
+
+	double topKey() {
+		refill();
+		return fromBits(buckets_[0].back().key_);
+	}
+
+	unsigned int size() const { return size_; }
+
+	void pop() {
+		refill();
+		buckets_[0].pop_back();
+		--size_;
+	}
+
+private:
+
+	static const unsigned int NUM_BUCKETS = 65;
+
+	struct Entry {
+		unsigned long long key_;
+		int k_;
+		Entry(unsigned long long key, int k) : key_(key), k_(k) {}
+	};
+
+	std::vector<Entry> buckets_[NUM_BUCKETS];  // bucket b holds keys that differ from last_ in bit b-1 as highest bit
+	unsigned long long last_;
+	unsigned int size_;
+
+	static unsigned long long toBits(double f) {
+		if (!(f > 0)) return 0;
+		unsigned long long bits;
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+
+	static double fromBits(unsigned long long bits) {
+		double f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	unsigned int bucketIndex(unsigned long long key) const {
+		unsigned long long diff = key ^ last_;
+		return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+	}
+
+	// Makes sure bucket 0 contains the minimum, redistributes the first non-empty bucket
+	void refill() {
+		if (!buckets_[0].empty()) return;
+
+		unsigned int b = 1;
+		while (buckets_[b].empty()) ++b;
+
+		std::vector<Entry>& bucket = buckets_[b];
+		unsigned long long min_key = bucket[0].key_;
+		for (unsigned int i = 1; i < bucket.size(); ++i) {
+			min_key = std::min(min_key, bucket[i].key_);
+		}
+
+		last_ = min_key;
+		for (unsigned int i = 0; i < bucket.size(); ++i) {
+			buckets_[bucketIndex(bucket[i].key_)].push_back(bucket[i]);
+		}
+		bucket.clear();
+	}
+
+};
+
+}
+
+#endif /* OPEN_LIST_H_ */
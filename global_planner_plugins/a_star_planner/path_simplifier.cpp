@@ -0,0 +1,83 @@
+#include "path_simplifier.h"
+
+#include <float.h> // for DBL_MAX
+
+#include <algorithm>
+
+namespace cb_global_planner {
+
+namespace {
+
+struct ClearanceCheck {
+	const unsigned char* costmap;
+	unsigned int width, height;
+	const CostModel* cost_model;
+	unsigned char max_cost;
+
+	bool operator()(int x, int y) const {
+		// shortcuts stay off the border cells, only plans of the search kernel can use these
+		if (x <= 0 || y <= 0 || x >= (int) width - 1 || y >= (int) height - 1) return false;
+
+		unsigned char cost = costmap[width * y + x];
+		return cost <= max_cost && cost_model->getTraversalTime(cost) != DBL_MAX;
+	}
+};
+
+}
+
+const double PathSimplifier::CORNER_TOLERANCE;
+
+void PathSimplifier::simplify(const unsigned char* costmap, unsigned int width, unsigned int height, const CostModel& cost_model,
+		const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<double>& xs, std::vector<double>& ys) const {
+	xs.clear();
+	ys.clear();
+	if (plan_xs.empty()) return;
+
+	// Greedy shortcuts: from every waypoint the farthest plan cell in line of sight is the next waypoint
+	std::vector<unsigned int> waypoints(1, 0);
+	unsigned int i = 0;
+	while (i + 1 < plan_xs.size()) {
+		unsigned int i_next = i + 1;
+		unsigned char max_cost = std::max(costmap[width * plan_ys[i] + plan_xs[i]], costmap[width * plan_ys[i_next] + plan_xs[i_next]]);
+		double max_distance2 = max_shortcut_ * max_shortcut_;
+
+		for (unsigned int j = i + 2; j < plan_xs.size(); ++j) {
+			double dx = plan_xs[j] - plan_xs[i], dy = plan_ys[j] - plan_ys[i];
+			if (dx * dx + dy * dy > max_distance2) break;
+
+			max_cost = std::max(max_cost, costmap[width * plan_ys[j] + plan_xs[j]]);
+			if (!isClear(costmap, width, height, cost_model, plan_xs[i], plan_ys[i], plan_xs[j], plan_ys[j], max_cost)) break;
+			i_next = j;
+		}
+
+		waypoints.push_back(i_next);
+		i = i_next;
+	}
+
+	// Resampling: every segment gets the points that keep them at most spacing_ apart
+	for (unsigned int w = 0; w + 1 < waypoints.size(); ++w) {
+		double x0 = plan_xs[waypoints[w]] + 0.5, y0 = plan_ys[waypoints[w]] + 0.5;
+		double x1 = plan_xs[waypoints[w + 1]] + 0.5, y1 = plan_ys[waypoints[w + 1]] + 0.5;
+
+		unsigned int n = std::max(1, (int) ceil(sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)) / spacing_ - 1e-9));
+		for (unsigned int k = 0; k < n; ++k) {
+			xs.push_back(x0 + (x1 - x0) * k / n);
+			ys.push_back(y0 + (y1 - y0) * k / n);
+		}
+	}
+	xs.push_back(plan_xs[waypoints.back()] + 0.5);
+	ys.push_back(plan_ys[waypoints.back()] + 0.5);
+}
+
+bool PathSimplifier::isClear(const unsigned char* costmap, unsigned int width, unsigned int height, const CostModel& cost_model,
+		int x0, int y0, int x1, int y1, unsigned char max_cost) const {
+	ClearanceCheck check;
+	check.costmap = costmap;
+	check.width = width;
+	check.height = height;
+	check.cost_model = &cost_model;
+	check.max_cost = max_cost;
+	return traverse(x0 + 0.5, y0 + 0.5, x1 + 0.5, y1 + 0.5, check);
+}
+
+}
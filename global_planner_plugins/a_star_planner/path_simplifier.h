@@ -0,0 +1,101 @@
+#ifndef cb_global_planner_PATH_SIMPLIFIER_H_
+#define cb_global_planner_PATH_SIMPLIFIER_H_
+
+#include <math.h> // for floor
+
+#include <cstdlib>
+#include <vector>
+
+#include "cost_model.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class PathSimplifier
+ * @brief Shrinks a plan of neighbouring cells to straight shortcuts, resampled at a fixed spacing.
+ *
+ * A shortcut replaces a stretch of the plan only if every cell the straight line passes is traversable,
+ * is not a border cell and has a cell value no higher than the highest value on the stretch it replaces:
+ * the simplified plan never gets closer to obstacles than the original one. Where the line passes exactly
+ * through a cell corner both cells next to the corner are checked.
+ *
+ * Coordinates are continuous cell coordinates: cell (x, y) covers [x, x + 1) x [y, y + 1).
+ */
+class PathSimplifier {
+
+public:
+
+	PathSimplifier() : spacing_(1.0), max_shortcut_(100.0) {}
+
+	/**
+	 * @brief Distance between the points of the simplified plan [cells], at most (the last segment may be shorter)
+	 */
+	void setSpacing(double spacing) { spacing_ = spacing > 0 ? spacing : 1.0; }
+
+	double getSpacing() const { return spacing_; }
+
+	/**
+	 * @brief Longest shortcut [cells], bounds the line checks per point of the plan
+	 */
+	void setMaxShortcut(double max_shortcut) { max_shortcut_ = max_shortcut; }
+
+	double getMaxShortcut() const { return max_shortcut_; }
+
+	/**
+	 * @brief Simplifies a plan of neighbouring cells
+	 * @param costmap Row-major costmap of width x height cells (Costmap2D::getCharMap())
+	 * @param xs, ys The simplified plan through the cell centres of plan_xs.front() and plan_xs.back()
+	 */
+	void simplify(const unsigned char* costmap, unsigned int width, unsigned int height, const CostModel& cost_model,
+			const std::vector<int>& plan_xs, const std::vector<int>& plan_ys, std::vector<double>& xs, std::vector<double>& ys) const;
+
+	/**
+	 * @brief Visits the cells that the segment (x0, y0) - (x1, y1) passes, in order, both cells where it passes a corner
+	 * @param visit bool visit(int x, int y), the traversal stops when it returns false
+	 * @return False if visit returned false
+	 */
+	template <class Visitor>
+	static bool traverse(double x0, double y0, double x1, double y1, Visitor& visit) {
+		int x = (int) floor(x0), y = (int) floor(y0);
+		int steps_x = abs((int) floor(x1) - x), steps_y = abs((int) floor(y1) - y);
+
+		double dx = x1 - x0, dy = y1 - y0;
+		int step_x = dx > 0 ? 1 : -1, step_y = dy > 0 ? 1 : -1;
+
+		// parameter along the segment at which it crosses the next column / row border
+		double t_delta_x = steps_x > 0 ? fabs(1.0 / dx) : 0, t_delta_y = steps_y > 0 ? fabs(1.0 / dy) : 0;
+		double t_x = steps_x > 0 ? (dx > 0 ? x + 1 - x0 : x0 - x) * t_delta_x : 0;
+		double t_y = steps_y > 0 ? (dy > 0 ? y + 1 - y0 : y0 - y) * t_delta_y : 0;
+
+		if (!visit(x, y)) return false;
+		while (steps_x > 0 || steps_y > 0) {
+			if (steps_x > 0 && steps_y > 0 && fabs(t_x - t_y) < CORNER_TOLERANCE) {
+				if (!visit(x + step_x, y) || !visit(x, y + step_y)) return false;
+				x += step_x; --steps_x; t_x += t_delta_x;
+				y += step_y; --steps_y; t_y += t_delta_y;
+			} else if (steps_y == 0 || (steps_x > 0 && t_x < t_y)) {
+				x += step_x; --steps_x; t_x += t_delta_x;
+			} else {
+				y += step_y; --steps_y; t_y += t_delta_y;
+			}
+			if (!visit(x, y)) return false;
+		}
+		return true;
+	}
+
+private:
+
+	static const double CORNER_TOLERANCE = 1e-9;
+
+	double spacing_;
+	double max_shortcut_;
+
+	// Whether the line between the centres of two cells only passes traversable cells with values up to max_cost
+	bool isClear(const unsigned char* costmap, unsigned int width, unsigned int height, const CostModel& cost_model,
+			int x0, int y0, int x1, int y1, unsigned char max_cost) const;
+
+};
+
+}
+
+#endif /* PATH_SIMPLIFIER_H_ */
@@ -0,0 +1,161 @@
+#include "plan_validity_tracker.h"
+#include "path_simplifier.h"
+
+#include <tf/transform_datatypes.h>
+
+#include <algorithm>
+
+namespace cb_global_planner
+{
+
+namespace
+{
+
+// Visitor of PathSimplifier::traverse, fails on a blocked cell
+struct BlockedCellCheck
+{
+    const costmap_2d::Costmap2D* costmap;
+    const CostModel* cost_model;
+
+    bool operator()(int x, int y) const
+    {
+        return !cost_model->isBlocked(costmap->getCost(x, y));
+    }
+};
+
+}
+
+const unsigned int PlanValidityTracker::CHUNK_SIZE;
+const int PlanValidityTracker::UNKNOWN;
+
+int PlanValidityTracker::findFirstBlockedPose(const costmap_2d::Costmap2D& costmap, const CostModel& cost_model, const UpdatedBoundsLayer* layer,
+                                              const cb_base_navigation::ClearanceLayer* clearance, const cb_base_navigation::FootprintCover& footprint,
+                                              const std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    poses_checked_ = 0;
+
+    // The update of the current version may still be writing its cells: it is taken as changed again next time
+    unsigned int version = layer ? layer->getVersion() : 0;
+
+    bool same_geometry = costmap.getResolution() == resolution_ && costmap.getOriginX() == origin_x_ && costmap.getOriginY() == origin_y_
+            && costmap.getSizeInCellsX() == size_x_ && costmap.getSizeInCellsY() == size_y_;
+    double footprint_radius = clearance ? footprint.getRadius() : -1;
+
+    double min_x, min_y, max_x, max_y;
+    if (!same_geometry || footprint_radius != footprint_radius_ || !isTracked(plan)) {
+        track(plan);
+        resolution_ = costmap.getResolution();
+        origin_x_ = costmap.getOriginX();
+        origin_y_ = costmap.getOriginY();
+        size_x_ = costmap.getSizeInCellsX();
+        size_y_ = costmap.getSizeInCellsY();
+        footprint_radius_ = footprint_radius;
+    } else if (layer && layer->getChangedBounds(version_, min_x, min_y, max_x, max_y)) {
+        // A pose is rounded to the cell it is in: one cell of margin, plus the footprint that is checked around it
+        double margin = resolution_ + std::max(0.0, footprint_radius_);
+        for (std::vector<Chunk>::iterator it = chunks_.begin(); it != chunks_.end(); ++it) {
+            if (it->min_x - margin <= max_x && it->max_x + margin >= min_x && it->min_y - margin <= max_y && it->max_y + margin >= min_y)
+                it->blocked = UNKNOWN;
+        }
+    } else {
+        for (std::vector<Chunk>::iterator it = chunks_.begin(); it != chunks_.end(); ++it) it->blocked = UNKNOWN;
+    }
+    version_ = version > 0 ? version - 1 : 0;
+
+    // Chunks after the first blocked one may stay unknown
+    for (std::vector<Chunk>::iterator it = chunks_.begin(); it != chunks_.end(); ++it) {
+        if (it->blocked == UNKNOWN) it->blocked = clearance ? checkChunkFootprint(*clearance, footprint, *it) : checkChunk(costmap, cost_model, *it);
+        if (it->blocked >= 0) return it->blocked;
+    }
+    return -1;
+}
+
+void PlanValidityTracker::track(const std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    xs_.resize(plan.size());
+    ys_.resize(plan.size());
+    yaws_.resize(plan.size());
+    for (unsigned int i = 0; i < plan.size(); ++i) {
+        xs_[i] = plan[i].pose.position.x;
+        ys_[i] = plan[i].pose.position.y;
+        yaws_[i] = tf::getYaw(plan[i].pose.orientation);
+    }
+
+    chunks_.clear();
+    for (unsigned int begin = 0; begin < plan.size(); begin += CHUNK_SIZE) {
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = std::min(begin + CHUNK_SIZE, (unsigned int) plan.size());
+        chunk.blocked = UNKNOWN;
+
+        // the segment from the pose before the chunk belongs to the chunk
+        unsigned int first = begin > 0 ? begin - 1 : 0;
+        chunk.min_x = *std::min_element(xs_.begin() + first, xs_.begin() + chunk.end);
+        chunk.max_x = *std::max_element(xs_.begin() + first, xs_.begin() + chunk.end);
+        chunk.min_y = *std::min_element(ys_.begin() + first, ys_.begin() + chunk.end);
+        chunk.max_y = *std::max_element(ys_.begin() + first, ys_.begin() + chunk.end);
+        chunks_.push_back(chunk);
+    }
+}
+
+bool PlanValidityTracker::isTracked(const std::vector<geometry_msgs::PoseStamped>& plan) const
+{
+    if (plan.size() != xs_.size()) return false;
+    for (unsigned int i = 0; i < plan.size(); ++i) {
+        if (plan[i].pose.position.x != xs_[i] || plan[i].pose.position.y != ys_[i] || tf::getYaw(plan[i].pose.orientation) != yaws_[i]) return false;
+    }
+    return true;
+}
+
+int PlanValidityTracker::checkChunk(const costmap_2d::Costmap2D& costmap, const CostModel& cost_model, const Chunk& chunk)
+{
+    BlockedCellCheck check;
+    check.costmap = &costmap;
+    check.cost_model = &cost_model;
+
+    unsigned int mx, my;
+    unsigned int mx_prev = 0, my_prev = 0;
+    bool prev_on_map = chunk.begin > 0 && costmap.worldToMap(xs_[chunk.begin - 1], ys_[chunk.begin - 1], mx_prev, my_prev);
+    for (unsigned int i = chunk.begin; i < chunk.end; ++i) {
+        ++poses_checked_;
+
+        bool on_map = costmap.worldToMap(xs_[i], ys_[i], mx, my);
+        if (on_map) {
+            if (cost_model.isBlocked(costmap.getCost(mx, my))) return i;
+
+            // Poses of a simplified plan are more than a cell apart: check the cells in between as well
+            if (prev_on_map && (abs((int) mx - (int) mx_prev) > 1 || abs((int) my - (int) my_prev) > 1)) {
+                if (!PathSimplifier::traverse((xs_[i-1] - origin_x_) / resolution_, (ys_[i-1] - origin_y_) / resolution_,
+                                              (xs_[i] - origin_x_) / resolution_, (ys_[i] - origin_y_) / resolution_, check)) {
+                    return i;
+                }
+            }
+        }
+        mx_prev = mx; my_prev = my;
+        prev_on_map = on_map;
+    }
+    return -1;
+}
+
+int PlanValidityTracker::checkChunkFootprint(const cb_base_navigation::ClearanceLayer& clearance, const cb_base_navigation::FootprintCover& footprint,
+                                             const Chunk& chunk)
+{
+    for (unsigned int i = chunk.begin; i < chunk.end; ++i) {
+        ++poses_checked_;
+
+        if (!clearance.isFootprintFree(footprint, xs_[i], ys_[i], yaws_[i])) return i;
+
+        // Poses of a simplified plan are more than a cell apart: the footprint is checked every cell in between, facing along the segment
+        if (i > 0) {
+            double dx = xs_[i] - xs_[i-1], dy = ys_[i] - ys_[i-1];
+            unsigned int n = (unsigned int) (sqrt(dx * dx + dy * dy) / resolution_);
+            double yaw = atan2(dy, dx);
+            for (unsigned int k = 1; k < n; ++k) {
+                if (!clearance.isFootprintFree(footprint, xs_[i-1] + dx * k / n, ys_[i-1] + dy * k / n, yaw)) return i;
+            }
+        }
+    }
+    return -1;
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef cb_global_planner_PLAN_VALIDITY_TRACKER_H_
+#define cb_global_planner_PLAN_VALIDITY_TRACKER_H_
+
+#include <costmap_2d/costmap_2d.h>
+#include <geometry_msgs/PoseStamped.h>
+
+#include <vector>
+
+#include "cost_model.h"
+#include "updated_bounds_layer.h"
+#include "cb_base_navigation/costmap_layers/clearance_layer.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class PlanValidityTracker
+ * @brief Finds the first blocked pose of a plan, re-checking only the parts of the plan the costmap changed since the last check.
+ *
+ * The plan is split in chunks of consecutive poses with their world bounding boxes. As long as the same plan is
+ * checked again, only the chunks that overlap the bounds changed since then are checked again; the changed bounds
+ * come from an UpdatedBoundsLayer. Without one, or when its history does not reach back to the last check, the
+ * whole plan is checked.
+ *
+ * With a ClearanceLayer the robot footprint is checked at every pose (and every cell between poses that are farther
+ * apart), instead of the cost of the cell of the pose.
+ */
+class PlanValidityTracker {
+
+public:
+
+    PlanValidityTracker() : version_(0), resolution_(0), origin_x_(0), origin_y_(0), size_x_(0), size_y_(0), footprint_radius_(-1), poses_checked_(0) {}
+
+    /**
+     * @brief Index of the first pose that is blocked, or that passes a blocked cell coming from the previous pose
+     * @param layer Updated bounds of the costmap, NULL if there are none
+     * @param clearance Clearance of the costmap for footprint checks, NULL for checks of the cell costs
+     * @return -1 if no pose is blocked
+     */
+    int findFirstBlockedPose(const costmap_2d::Costmap2D& costmap, const CostModel& cost_model, const UpdatedBoundsLayer* layer,
+                             const cb_base_navigation::ClearanceLayer* clearance, const cb_base_navigation::FootprintCover& footprint,
+                             const std::vector<geometry_msgs::PoseStamped>& plan);
+
+    /**
+     * @brief Number of poses the last call checked on the costmap
+     */
+    unsigned int getPosesChecked() const { return poses_checked_; }
+
+private:
+
+    static const unsigned int CHUNK_SIZE = 32;
+
+    // A chunk that is not known yet, unknown chunks are checked
+    static const int UNKNOWN = -2;
+
+    struct Chunk {
+        unsigned int begin, end;
+        double min_x, min_y, max_x, max_y; // of the poses begin - 1 .. end - 1
+        int blocked;                       // first blocked pose, -1 if none, or UNKNOWN
+    };
+
+    // The tracked plan, its chunks and the costmap version and geometry they were checked on
+    std::vector<double> xs_, ys_, yaws_;
+    std::vector<Chunk> chunks_;
+    unsigned int version_;
+    double resolution_, origin_x_, origin_y_;
+    unsigned int size_x_, size_y_;
+    double footprint_radius_;   // of the footprint checks, -1 for checks of the cell costs
+
+    unsigned int poses_checked_;
+
+    // Tracks a new plan; all chunks are unknown
+    void track(const std::vector<geometry_msgs::PoseStamped>& plan);
+
+    bool isTracked(const std::vector<geometry_msgs::PoseStamped>& plan) const;
+
+    int checkChunk(const costmap_2d::Costmap2D& costmap, const CostModel& cost_model, const Chunk& chunk);
+
+    int checkChunkFootprint(const cb_base_navigation::ClearanceLayer& clearance, const cb_base_navigation::FootprintCover& footprint, const Chunk& chunk);
+
+};
+
+}
+
+#endif /* PLAN_VALIDITY_TRACKER_H_ */
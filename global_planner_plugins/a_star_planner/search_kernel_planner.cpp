@@ -0,0 +1,199 @@
+#include "search_kernel_planner.h"
+
+namespace cb_global_planner {
+
+namespace {
+
+// Neighbours: four straight steps, then four diagonal ones, so a 4-connected kernel uses the first four
+const int DX[8] = { -1, +1,  0,  0, -1, +1, -1, +1 };
+const int DY[8] = {  0,  0, -1, +1, -1, -1, +1, +1 };
+const double FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, 1.414213562, 1.414213562, 1.414213562, 1.414213562 };
+
+}
+
+SearchKernelPlanner::SearchKernelPlanner(int width, int height) : AStarPlanner(width, height),
+	connectivity_(CONNECTIVITY_8), heuristic_(HEURISTIC_OCTILE), cost_table_(COST_TABLE_TRAVERSAL_TIME), padded_width_(0) {
+	for (unsigned int d = 0; d < 8; ++d) {
+		offsets_[d] = 0;
+		cost_offsets_[d] = 0;
+	}
+}
+
+SearchKernelPlanner::~SearchKernelPlanner() {
+}
+
+bool SearchKernelPlanner::planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	// the padded grid follows the costmap dimensions, its padding ring is blocked once
+	unsigned int padded_size = (width_ + 2) * (height_ + 2);
+	if (padded_nodes_.size() != padded_size || padded_width_ != width_ + 2) {
+		padded_width_ = width_ + 2;
+		padded_nodes_.resize(padded_size);
+		for (unsigned int x = 0; x < padded_width_; ++x) {
+			padded_nodes_.block(x);
+			padded_nodes_.block(padded_size - padded_width_ + x);
+		}
+		for (unsigned int y = 0; y < height_ + 2; ++y) {
+			padded_nodes_.block(padded_width_ * y);
+			padded_nodes_.block(padded_width_ * y + padded_width_ - 1);
+		}
+	}
+	for (unsigned int d = 0; d < 8; ++d) {
+		offsets_[d] = DY[d] * (int) padded_width_ + DX[d];
+		cost_offsets_[d] = DY[d] * (int) width_ + DX[d];
+	}
+
+	// the open lists are shared with the searches of the AStarPlanner
+	anytime_.valid = false;
+
+	// start sets and their penalties like seedStarts, the border cells included
+	set_penalty_ = 0;
+	if (num_sets > 1) {
+		set_penalty_ = (cost_model_.getMaxTraversalTime() * SQRT2 + 1) * width_ * height_;
+	}
+
+	padded_nodes_.reset();
+	starts_.clear();
+	for (unsigned int t = 0; t < num_sets; ++t) {
+		const std::vector<unsigned int>& mx_start = mx_starts[t];
+		const std::vector<unsigned int>& my_start = my_starts[t];
+		for (unsigned int i = 0; i < mx_start.size(); ++i) {
+			if (mx_start[i] < width_ && my_start[i] < height_) {
+				int k = paddedCell(mx_start[i], my_start[i]);
+				padded_nodes_.touch(k);
+				if (padded_nodes_.g(k) != DBL_MAX) continue; // duplicate start, the earliest set keeps it
+
+				padded_nodes_.g(k) = t * set_penalty_;
+				starts_.push_back(k);
+			}
+		}
+	}
+
+	if (connectivity_ == CONNECTIVITY_4) {
+		return planHeuristic<4>(mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+	return planHeuristic<8>(mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+}
+
+double SearchKernelPlanner::getStartCost(int x, int y) {
+	return padded_nodes_.g(paddedCell(x, y));
+}
+
+template <unsigned int CONNECTIVITY>
+bool SearchKernelPlanner::planHeuristic(int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	if (heuristic_ == HEURISTIC_EUCLIDEAN) {
+		return planCostTable<CONNECTIVITY, EuclideanHeuristic>(mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+	return planCostTable<CONNECTIVITY, OctileHeuristic>(mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+}
+
+template <unsigned int CONNECTIVITY, class HeuristicT>
+bool SearchKernelPlanner::planCostTable(int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	if (cost_table_ == COST_TABLE_UNIFORM) {
+		UniformCostTable table(cost_model_);
+		return planOpenList<CONNECTIVITY, HeuristicT>(table, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+	TraversalTimeTable table(cost_model_);
+	return planOpenList<CONNECTIVITY, HeuristicT>(table, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+}
+
+template <unsigned int CONNECTIVITY, class HeuristicT, class CostTableT>
+bool SearchKernelPlanner::planOpenList(const CostTableT& table, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	switch (open_list_type_) {
+	case OPEN_LIST_QUATERNARY:
+		return planKernel<CONNECTIVITY, HeuristicT>(quaternary_open_, table, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	case OPEN_LIST_RADIX:
+		return planKernel<CONNECTIVITY, HeuristicT>(radix_open_, table, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	default:
+		return planKernel<CONNECTIVITY, HeuristicT>(binary_open_, table, mx_goal, my_goal, plan_xs, plan_ys, best_heuristic);
+	}
+}
+
+template <unsigned int CONNECTIVITY, class HeuristicT, class CostTableT, class OpenList>
+bool SearchKernelPlanner::planKernel(OpenList& open, const CostTableT& table, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic) {
+	const int pw = padded_width_;
+	const double min_cell_cost = table.min_time;
+	SearchNodes& nodes = padded_nodes_;
+
+	open.prepare(nodes.size());
+
+	for (unsigned int i = 0; i < starts_.size(); ++i) {
+		int k = starts_[i];
+		int x = k % pw - 1, y = k / pw - 1;
+		open.push(k, nodes.g(k) + HeuristicT::distance(mx_goal - x, my_goal - y) * min_cell_cost);
+	}
+
+	int k_goal = (mx_goal >= 0 && mx_goal < (int) width_ && my_goal >= 0 && my_goal < (int) height_) ? paddedCell(mx_goal, my_goal) : -1;
+	int goal_cell = -1;
+	int best_cell = -1;
+	double best_score = 1e9;
+
+	unsigned int cells_expanded = 0;
+	unsigned int open_list_peak = open.size();
+
+	while(!open.empty()) {
+		int k = open.top();
+		double f = open.topKey();
+		open.pop();
+
+		if (nodes.isClosed(k)) continue;
+		nodes.close(k);
+		++cells_expanded;
+
+		if (k == k_goal) {
+			goal_cell = k;
+			break;
+		}
+
+		double g = nodes.g(k);
+		double h = f - g;
+		if (h < best_score) {
+			best_cell = k;
+			best_score = h;
+		}
+
+		// the padding ring stops the search at the map border, so every neighbour of a cell is a valid index
+		int x = k % pw - 1;
+		int y = k / pw - 1;
+		int k_cost = width_ * y + x;
+		for (unsigned int d = 0; d < CONNECTIVITY; ++d) {
+			int k_child = k + offsets_[d];
+			if (!nodes.touch(k_child) || nodes.isClosed(k_child)) continue;
+
+			double g_child = g + table(char_cost_map_[k_cost + cost_offsets_[d]]) * FACTOR[d];
+			if (g_child < nodes.g(k_child)) {
+				nodes.g(k_child) = g_child;
+				nodes.parent(k_child) = k;
+				open.push(k_child, g_child + HeuristicT::distance(mx_goal - x - DX[d], my_goal - y - DY[d]) * min_cell_cost);
+			}
+		}
+
+		open_list_peak = std::max(open_list_peak, open.size());
+	}
+
+	int trace_cell = goal_cell;
+	if (trace_cell < 0 && best_heuristic) {
+		trace_cell = best_cell;
+	}
+
+	// the plan is sized once, then filled from the goal cell
+	unsigned int n = 0;
+	for (int c = trace_cell; c >= 0; c = nodes.parent(c)) ++n;
+	unsigned int offset = plan_xs.size();
+	plan_xs.resize(offset + n);
+	plan_ys.resize(offset + n);
+	for (unsigned int i = offset; trace_cell >= 0; trace_cell = nodes.parent(trace_cell), ++i) {
+		plan_xs[i] = trace_cell % pw - 1;
+		plan_ys[i] = trace_cell / pw - 1;
+	}
+
+	statistics_.cells_touched = nodes.getCellsTouched();
+	statistics_.cells_expanded = cells_expanded;
+	statistics_.cells_expanded_reverse = 0;
+	statistics_.cells_reset_skipped = width_ * height_ - std::min(width_ * height_, statistics_.cells_touched);
+	statistics_.reset_time_saved = statistics_.cells_reset_skipped * reset_time_per_cell_;
+	statistics_.open_list_peak = open_list_peak;
+
+	return (goal_cell >= 0);
+}
+
+}
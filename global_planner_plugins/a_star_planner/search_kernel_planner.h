@@ -0,0 +1,139 @@
+#ifndef cb_global_planner_SEARCHKERNELPLANNER_H_
+#define cb_global_planner_SEARCHKERNELPLANNER_H_
+
+#include <stdlib.h> // for abs
+
+#include "a_star_planner.h"
+
+namespace cb_global_planner {
+
+/**
+ * @brief Heuristics of the search kernel: the distance [cells] of a cell to the goal for a step of (dx, dy)
+ *  - EuclideanHeuristic: straight line distance, the heuristic of the AStarPlanner
+ *  - OctileHeuristic: length of the shortest 8-connected path without obstacles, tighter and without sqrt
+ */
+struct EuclideanHeuristic {
+	static inline double distance(int dx, int dy) { return sqrt((double) (dx * dx + dy * dy)); }
+};
+
+struct OctileHeuristic {
+	static inline double distance(int dx, int dy) {
+		dx = abs(dx);
+		dy = abs(dy);
+		return std::max(dx, dy) + (1.414213562 - 1.0) * std::min(dx, dy);
+	}
+};
+
+/**
+ * @brief Cost tables of the search kernel: the time to pass a cell by its cell value, DBL_MAX if it is not traversable
+ *  - TraversalTimeTable: the traversal times of the cost model
+ *  - UniformCostTable: every traversable cell takes the lowest traversal time of the cost model, so plans are the
+ *    shortest paths over the traversable cells whatever their costs
+ */
+struct TraversalTimeTable {
+	const double* times;
+	double min_time;
+
+	explicit TraversalTimeTable(const CostModel& cost_model) : times(cost_model.getTraversalTimeTable()), min_time(cost_model.getMinTraversalTime()) {}
+	inline double operator()(unsigned char cost) const { return times[cost]; }
+};
+
+struct UniformCostTable {
+	double times[256];
+	double min_time;
+
+	explicit UniformCostTable(const CostModel& cost_model) : min_time(cost_model.getMinTraversalTime()) {
+		for (unsigned int c = 0; c < 256; ++c) times[c] = (cost_model.getTraversalTime(c) == DBL_MAX) ? DBL_MAX : min_time;
+	}
+	inline double operator()(unsigned char cost) const { return times[cost]; }
+};
+
+/**
+ * @class SearchKernelPlanner
+ * @brief A* search kernels that are specialised at compile time on the connectivity, the heuristic and the cost table.
+ *
+ * The kernel searches a grid with a blocked ring of padding cells around the costmap, so the neighbours of every cell
+ * are fixed index offsets and no expansion checks the bounds of the map: unlike the AStarPlanner, the border cells of
+ * the costmap can be in a plan. With 8-connectivity and the cost model's traversal times the plans have the costs of
+ * the AStarPlanner (except that these can use the border); the landmark heuristic is not used.
+ *
+ * plan and planTiered use the kernel, the other searches (planBatch, planAnytime) are those of the AStarPlanner.
+ * Always uses the flat node storage; the open list type of the AStarPlanner is respected.
+ */
+class SearchKernelPlanner : public AStarPlanner {
+
+public:
+
+	enum Connectivity {
+		CONNECTIVITY_4 = 4,
+		CONNECTIVITY_8 = 8
+	};
+
+	enum Heuristic {
+		HEURISTIC_EUCLIDEAN,
+		HEURISTIC_OCTILE
+	};
+
+	enum CostTable {
+		COST_TABLE_TRAVERSAL_TIME,
+		COST_TABLE_UNIFORM
+	};
+
+	SearchKernelPlanner(int width, int height);
+
+	virtual ~SearchKernelPlanner();
+
+	void setConnectivity(Connectivity connectivity) { connectivity_ = connectivity; }
+
+	Connectivity getConnectivity() const { return connectivity_; }
+
+	void setHeuristic(Heuristic heuristic) { heuristic_ = heuristic; }
+
+	Heuristic getHeuristic() const { return heuristic_; }
+
+	void setCostTable(CostTable cost_table) { cost_table_ = cost_table; }
+
+	CostTable getCostTable() const { return cost_table_; }
+
+protected:
+
+	virtual bool usesFlatNodes() const { return true; }
+
+	virtual bool planFlat(const std::vector<unsigned int>* mx_starts, const std::vector<unsigned int>* my_starts, unsigned int num_sets, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	virtual double getStartCost(int x, int y);
+
+	Connectivity connectivity_;
+	Heuristic heuristic_;
+	CostTable cost_table_;
+
+	// Search state on the padded grid of (width_ + 2) x (height_ + 2) cells, the padding ring is blocked
+	SearchNodes padded_nodes_;
+	unsigned int padded_width_;
+
+	// Per neighbour: the index offset on the padded grid and on the costmap
+	int offsets_[8];
+	int cost_offsets_[8];
+
+	inline int paddedCell(int x, int y) const { return (y + 1) * padded_width_ + x + 1; }
+
+	template <unsigned int CONNECTIVITY>
+	bool planHeuristic(int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	template <unsigned int CONNECTIVITY, class HeuristicT>
+	bool planCostTable(int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	template <unsigned int CONNECTIVITY, class HeuristicT, class CostTableT>
+	bool planOpenList(const CostTableT& table, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+	/**
+	 * @brief The search kernel
+	 */
+	template <unsigned int CONNECTIVITY, class HeuristicT, class CostTableT, class OpenList>
+	bool planKernel(OpenList& open, const CostTableT& table, int mx_goal, int my_goal, std::vector<int>& plan_xs, std::vector<int>& plan_ys, bool best_heuristic);
+
+};
+
+}
+
+#endif /* SEARCHKERNELPLANNER_H_ */
@@ -0,0 +1,119 @@
+#ifndef cb_global_planner_SEARCH_NODES_H_
+#define cb_global_planner_SEARCH_NODES_H_
+
+#include <float.h> // for DBL_MAX
+
+#include <algorithm>
+#include <vector>
+
+namespace cb_global_planner {
+
+/**
+ * @class SearchNodes
+ * @brief Per-cell search state (g-cost, parent, closed flag) that can be reset in O(1).
+ *
+ * Every cell carries the generation in which it was last touched. Starting a new query
+ * only increments the current generation; a cell whose stamp differs from it is lazily
+ * re-initialized on first access. Blocked cells (e.g. the map border) carry a stamp that
+ * never matches and are reported as closed.
+ */
+class SearchNodes {
+
+public:
+
+	SearchNodes() : generation_(0), cells_touched_(0) {}
+
+	/**
+	 * @brief Reallocates the state for a number of cells, all cells are unblocked and fresh
+	 */
+	void resize(unsigned int size) {
+		g_.assign(size, DBL_MAX);
+		parent_.assign(size, -1);
+		closed_.assign(size, 0);
+		stamp_.assign(size, 0);
+		generation_ = 0;
+		reset();
+	}
+
+	unsigned int size() const { return stamp_.size(); }
+
+	/**
+	 * @brief Starts a new generation, all unblocked cells become fresh
+	 */
+	void reset() {
+		if (++generation_ == BLOCKED) {
+			// stamps wrapped around, clear them once
+			for (unsigned int k = 0; k < stamp_.size(); ++k) {
+				if (stamp_[k] != BLOCKED) stamp_[k] = 0;
+			}
+			generation_ = 1;
+		}
+		cells_touched_ = 0;
+	}
+
+	/**
+	 * @brief Marks a cell as blocked, it is closed in every generation
+	 */
+	void block(int k) { stamp_[k] = BLOCKED; }
+
+	/**
+	 * @brief Makes sure the state of a cell belongs to the current generation
+	 * @return False if the cell is blocked
+	 */
+	inline bool touch(int k) {
+		if (stamp_[k] != generation_) {
+			if (stamp_[k] == BLOCKED) return false;
+			stamp_[k] = generation_;
+			g_[k] = DBL_MAX;
+			parent_[k] = -1;
+			closed_[k] = 0;
+			++cells_touched_;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Returns true if the cell is blocked
+	 */
+	inline bool isBlocked(int k) const { return stamp_[k] == BLOCKED; }
+
+	/**
+	 * @brief Returns true if the cell is expanded in this generation or blocked (no touch needed)
+	 */
+	inline bool isClosed(int k) const {
+		return stamp_[k] == BLOCKED || (stamp_[k] == generation_ && closed_[k]);
+	}
+
+	/**
+	 * @brief Returns the cost so far without touching the cell, DBL_MAX if it is fresh or blocked
+	 */
+	inline double peekG(int k) const { return stamp_[k] == generation_ ? g_[k] : DBL_MAX; }
+
+	// The accessors below require touch(k) in the current generation
+
+	inline double& g(int k) { return g_[k]; }
+	inline int& parent(int k) { return parent_[k]; }
+	inline void close(int k) { closed_[k] = 1; }
+
+	/**
+	 * @brief Number of cells that have been initialized in the current generation
+	 */
+	unsigned int getCellsTouched() const { return cells_touched_; }
+
+private:
+
+	static const unsigned int BLOCKED = 0xFFFFFFFF;
+
+	std::vector<double> g_;              // cost so far
+	std::vector<int> parent_;            // cell from which this cell is visited, -1 if none
+	std::vector<unsigned char> closed_;  // 1 if the cell has been expanded
+	std::vector<unsigned int> stamp_;    // generation in which the cell was last touched
+
+	unsigned int generation_;
+	unsigned int cells_touched_;
+
+};
+
+}
+
+#endif /* SEARCH_NODES_H_ */
@@ -0,0 +1,73 @@
+#include <pluginlib/class_list_macros.h>
+#include "updated_bounds_layer.h"
+
+#include <algorithm>
+
+PLUGINLIB_EXPORT_CLASS(cb_global_planner::UpdatedBoundsLayer, costmap_2d::Layer)
+
+namespace cb_global_planner
+{
+
+const unsigned int UpdatedBoundsLayer::HISTORY_SIZE;
+
+void UpdatedBoundsLayer::onInitialize()
+{
+    current_ = true;
+}
+
+void UpdatedBoundsLayer::updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x, double* max_y)
+{
+    boost::mutex::scoped_lock lock(mutex_);
+
+    // Also disabled the layer keeps track, it changes no cells anyway
+    Bounds bounds;
+    bounds.min_x = *min_x;
+    bounds.min_y = *min_y;
+    bounds.max_x = *max_x;
+    bounds.max_y = *max_y;
+    history_.push_back(bounds);
+    if (history_.size() > HISTORY_SIZE) history_.pop_front();
+    ++version_;
+}
+
+void UpdatedBoundsLayer::matchSize()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+
+    // Resizing resets the cells, all of them may have changed
+    history_.clear();
+    reset_version_ = ++version_;
+}
+
+bool UpdatedBoundsLayer::isLast() const
+{
+    std::vector<boost::shared_ptr<costmap_2d::Layer> >* layers = layered_costmap_->getPlugins();
+    return !layers->empty() && layers->back().get() == this;
+}
+
+unsigned int UpdatedBoundsLayer::getVersion() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return version_;
+}
+
+bool UpdatedBoundsLayer::getChangedBounds(unsigned int version, double& min_x, double& min_y, double& max_x, double& max_y) const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+
+    if (version < reset_version_ || version_ - version > history_.size()) return false;
+
+    min_x = min_y = 1e30;
+    max_x = max_y = -1e30;
+    for (unsigned int i = history_.size() - (version_ - version); i < history_.size(); ++i) {
+        const Bounds& b = history_[i];
+        if (b.min_x > b.max_x || b.min_y > b.max_y) continue; // nothing changed in this update
+        min_x = std::min(min_x, b.min_x);
+        min_y = std::min(min_y, b.min_y);
+        max_x = std::max(max_x, b.max_x);
+        max_y = std::max(max_y, b.max_y);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,70 @@
+#ifndef cb_global_planner_UPDATED_BOUNDS_LAYER_H_
+#define cb_global_planner_UPDATED_BOUNDS_LAYER_H_
+
+#include <costmap_2d/layer.h>
+#include <costmap_2d/layered_costmap.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+
+namespace cb_global_planner {
+
+/**
+ * @class UpdatedBoundsLayer
+ * @brief Costmap layer that changes no cells, but remembers the bounds of the areas the costmap updates changed.
+ *
+ * The layered costmap passes the bounds of the layers before a layer to its updateBounds, so the layer has to
+ * be the last one of the costmap to see every change. Every update gets a version; the union of the bounds
+ * since a version is known for the last HISTORY_SIZE updates.
+ */
+class UpdatedBoundsLayer : public costmap_2d::Layer {
+
+public:
+
+    UpdatedBoundsLayer() : version_(0), reset_version_(0) {}
+
+    void updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x, double* max_y);
+
+    void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j) {}
+
+    void matchSize();
+
+    /**
+     * @brief Whether the layer is the last one of the costmap, only then it sees all changes
+     */
+    bool isLast() const;
+
+    /**
+     * @brief Version of the last costmap update
+     */
+    unsigned int getVersion() const;
+
+    /**
+     * @brief World bounds of the area that the updates after version changed, min > max if nothing changed
+     * @return False if they are not known (too old, or the costmap was resized), anything may have changed
+     */
+    bool getChangedBounds(unsigned int version, double& min_x, double& min_y, double& max_x, double& max_y) const;
+
+protected:
+
+    void onInitialize();
+
+private:
+
+    static const unsigned int HISTORY_SIZE = 64;
+
+    struct Bounds {
+        double min_x, min_y, max_x, max_y;
+    };
+
+    mutable boost::mutex mutex_; // the costmap updates in its own thread
+    unsigned int version_;
+    unsigned int reset_version_; // the bounds are not known up to this version
+    std::deque<Bounds> history_; // bounds of the last updates, the newest at the back
+
+};
+
+}
+
+#endif /* UPDATED_BOUNDS_LAYER_H_ */
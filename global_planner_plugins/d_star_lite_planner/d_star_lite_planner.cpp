@@ -0,0 +1,286 @@
+#include "d_star_lite_planner.h"
+
+#include <math.h> // for sqrt
+#include <string.h> // for memcmp
+
+namespace cb_global_planner {
+
+namespace {
+
+// relative margin on the key comparison with the robot
+const double KEY_TOLERANCE = 1e-9;
+
+const double NEIGHBOUR_FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, 1.414213562, 1.414213562, 1.414213562, 1.414213562 };
+
+}
+
+const unsigned char DStarLitePlanner::NO_GOAL;
+
+DStarLitePlanner::DStarLitePlanner() : max_changed_fraction_(0.1), initialized_(false), width_(0), height_(0),
+	tier_penalty_(0), min_cell_cost_(0), k_robot_(0), km_(0) {
+}
+
+bool DStarLitePlanner::plan(const unsigned char* costmap, unsigned int width, unsigned int height,
+		const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers,
+		unsigned int mx_robot, unsigned int my_robot, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier) {
+
+	statistics_ = Statistics();
+
+	if (mx_robot >= width || my_robot >= height) return false;
+
+	// a tree is only valid for the goal cells and the costmap size it was built for
+	bool restart = !initialized_ || width != width_ || height != height_ || num_tiers != mx_goals_.size();
+	for (unsigned int t = 0; !restart && t < num_tiers; ++t) {
+		restart = (mx_goals[t] != mx_goals_[t] || my_goals[t] != my_goals_[t]);
+	}
+
+	width_ = width;
+	height_ = height;
+	int k_robot = width_ * my_robot + mx_robot;
+
+	if (!restart && !findChangedCells(costmap, (unsigned int) (max_changed_fraction_ * width_ * height_))) {
+		restart = true;
+	}
+
+	if (restart) {
+		k_robot_ = k_robot;
+		initialize(costmap, mx_goals, my_goals, num_tiers);
+		statistics_.restarted = true;
+	} else {
+		// the keys in the queue stay lower bounds if the heuristic of the distance the robot moved is added
+		km_ += heuristic(k_robot_, k_robot);
+		k_robot_ = k_robot;
+
+		// a cell value only changes the cost of leaving that cell, so only its rhs changes
+		for (unsigned int i = 0; i < changed_cells_.size(); ++i) {
+			costmap_[changed_cells_[i]] = costmap[changed_cells_[i]];
+		}
+		for (unsigned int i = 0; i < changed_cells_.size(); ++i) {
+			int k = changed_cells_[i];
+			if (isBorder(k)) continue;
+			rhs_[k] = calculateRhs(k);
+			updateVertex(k);
+		}
+		statistics_.cells_changed = changed_cells_.size();
+	}
+
+	if (isBorder(k_robot_)) return false;
+
+	computeShortestPath();
+
+	// the lazy queue keeps stale entries, drop them once they dominate
+	if (queue_.size() > 2 * g_.size()) {
+		std::vector<Entry> valid;
+		for (unsigned int i = 0; i < queue_.size(); ++i) {
+			if (queue_[i].stamp == stamp_[queue_[i].k]) valid.push_back(queue_[i]);
+		}
+		queue_.swap(valid);
+		std::make_heap(queue_.begin(), queue_.end());
+	}
+
+	return extractPlan(plan_xs, plan_ys, tier);
+}
+
+void DStarLitePlanner::initialize(const unsigned char* costmap, const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers) {
+	unsigned int n = width_ * height_;
+
+	costmap_.assign(costmap, costmap + n);
+	g_.assign(n, DBL_MAX);
+	rhs_.assign(n, DBL_MAX);
+	goal_tier_.assign(n, NO_GOAL);
+	stamp_.assign(n, 0);
+	queue_.clear();
+	km_ = 0;
+
+	int w = width_;
+	int offsets[8] = { -1, +1, -w, +w, -w - 1, -w + 1, w - 1, w + 1 };
+	std::copy(offsets, offsets + 8, neighbour_offset_);
+
+	// same tier penalty as AStarPlanner::planTiered: above any plan cost
+	min_cell_cost_ = cost_model_.getMinTraversalTime();
+	tier_penalty_ = (cost_model_.getMaxTraversalTime() * SQRT2 + 1) * n;
+
+	mx_goals_.assign(mx_goals, mx_goals + num_tiers);
+	my_goals_.assign(my_goals, my_goals + num_tiers);
+
+	for (unsigned int t = 0; t < num_tiers; ++t) {
+		for (unsigned int i = 0; i < mx_goals[t].size(); ++i) {
+			unsigned int x = mx_goals[t][i], y = my_goals[t][i];
+			if (x == 0 || y == 0 || x >= width_ - 1 || y >= height_ - 1) continue;
+
+			int k = width_ * y + x;
+			if (goal_tier_[k] != NO_GOAL) continue; // duplicate, the lowest tier keeps it
+
+			goal_tier_[k] = t;
+			rhs_[k] = t * tier_penalty_;
+			push(k);
+		}
+	}
+
+	initialized_ = true;
+}
+
+bool DStarLitePlanner::findChangedCells(const unsigned char* costmap, unsigned int max_changed) {
+	static const unsigned int BLOCK = 256;
+
+	changed_cells_.clear();
+	unsigned int n = costmap_.size();
+	for (unsigned int begin = 0; begin < n; begin += BLOCK) {
+		unsigned int end = std::min(begin + BLOCK, n);
+		if (memcmp(&costmap_[begin], costmap + begin, end - begin) == 0) continue;
+
+		for (unsigned int k = begin; k < end; ++k) {
+			if (costmap_[k] != costmap[k]) changed_cells_.push_back(k);
+		}
+		if (changed_cells_.size() > max_changed) return false;
+	}
+	return true;
+}
+
+double DStarLitePlanner::heuristic(int k1, int k2) const {
+	double dx = (double) ((k1 % (int) width_) - (k2 % (int) width_));
+	double dy = (double) ((k1 / (int) width_) - (k2 / (int) width_));
+	return sqrt(dx * dx + dy * dy) * min_cell_cost_;
+}
+
+double DStarLitePlanner::calculateRhs(int k) const {
+	double rhs = (goal_tier_[k] != NO_GOAL) ? goal_tier_[k] * tier_penalty_ : DBL_MAX;
+
+	double traversal_time = traversalTime(k);
+	if (traversal_time == DBL_MAX) return rhs;
+
+	for (unsigned int d = 0; d < 8; ++d) {
+		double g = g_[k + neighbour_offset_[d]];
+		if (g == DBL_MAX) continue;
+		rhs = std::min(rhs, traversal_time * NEIGHBOUR_FACTOR[d] + g);
+	}
+	return rhs;
+}
+
+void DStarLitePlanner::updateVertex(int k) {
+	if (g_[k] != rhs_[k]) {
+		push(k);
+	} else {
+		++stamp_[k]; // drops a queued entry
+	}
+}
+
+bool DStarLitePlanner::top(Entry& entry) {
+	while (!queue_.empty()) {
+		if (queue_.front().stamp == stamp_[queue_.front().k]) {
+			entry = queue_.front();
+			return true;
+		}
+		pop();
+	}
+	return false;
+}
+
+void DStarLitePlanner::pop() {
+	std::pop_heap(queue_.begin(), queue_.end());
+	queue_.pop_back();
+}
+
+void DStarLitePlanner::push(int k) {
+	queue_.push_back(Entry(calculateKey(k), k, ++stamp_[k]));
+	std::push_heap(queue_.begin(), queue_.end());
+}
+
+void DStarLitePlanner::computeShortestPath() {
+	Entry entry(Key(), 0, 0);
+	while (top(entry)) {
+		// Keys that tie with the robot key are processed too, up to rounding: in free space the heuristic
+		// equals the step cost, so cells next to the plan often have the key of the robot.
+		Key robot_key = calculateKey(k_robot_);
+		if (entry.key.k1 > robot_key.k1 * (1 + KEY_TOLERANCE) && rhs_[k_robot_] <= g_[k_robot_]) break;
+
+		pop();
+		int u = entry.k;
+
+		// the key was computed with an older km
+		if (entry.key < calculateKey(u)) {
+			push(u);
+			continue;
+		}
+
+		++statistics_.cells_expanded;
+
+		if (g_[u] > rhs_[u]) {
+			// overconsistent: settle u and offer it to the cells that can step onto it
+			g_[u] = rhs_[u];
+			for (unsigned int d = 0; d < 8; ++d) {
+				int s = u + neighbour_offset_[d];
+				if (isBorder(s)) continue;
+
+				double traversal_time = traversalTime(s);
+				if (traversal_time == DBL_MAX) continue;
+
+				double rhs = traversal_time * NEIGHBOUR_FACTOR[d] + g_[u];
+				if (rhs < rhs_[s]) {
+					rhs_[s] = rhs;
+					updateVertex(s);
+				}
+			}
+		} else {
+			// underconsistent: u got more expensive, repair the cells whose best step was onto u
+			double g_old = g_[u];
+			g_[u] = DBL_MAX;
+			updateVertex(u);
+			for (unsigned int d = 0; d < 8; ++d) {
+				int s = u + neighbour_offset_[d];
+				if (isBorder(s)) continue;
+
+				double traversal_time = traversalTime(s);
+				if (traversal_time == DBL_MAX) continue;
+
+				if (rhs_[s] == traversal_time * NEIGHBOUR_FACTOR[d] + g_old) {
+					rhs_[s] = calculateRhs(s);
+					updateVertex(s);
+				}
+			}
+		}
+	}
+}
+
+bool DStarLitePlanner::extractPlan(std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier) const {
+	if (rhs_[k_robot_] == DBL_MAX) return false;
+
+	// follow the cheapest steps until ending in a goal cell is cheaper than going on
+	unsigned int plan_begin = plan_xs.size();
+	int k = k_robot_;
+	for (unsigned int steps = 0; steps < g_.size(); ++steps) {
+		plan_xs.push_back(k % width_);
+		plan_ys.push_back(k / width_);
+
+		double best = DBL_MAX;
+		int k_best = -1;
+
+		double traversal_time = traversalTime(k);
+		if (traversal_time != DBL_MAX) {
+			for (unsigned int d = 0; d < 8; ++d) {
+				int n = k + neighbour_offset_[d];
+				if (g_[n] == DBL_MAX) continue;
+
+				double cost = traversal_time * NEIGHBOUR_FACTOR[d] + g_[n];
+				if (cost < best) {
+					best = cost;
+					k_best = n;
+				}
+			}
+		}
+
+		if (goal_tier_[k] != NO_GOAL && goal_tier_[k] * tier_penalty_ <= best) {
+			tier = goal_tier_[k];
+			return true;
+		}
+
+		if (k_best < 0) break;
+		k = k_best;
+	}
+
+	plan_xs.resize(plan_begin);
+	plan_ys.resize(plan_begin);
+	return false;
+}
+
+}
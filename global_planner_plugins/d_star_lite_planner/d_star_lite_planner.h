@@ -0,0 +1,163 @@
+#ifndef cb_global_planner_DSTARLITEPLANNER_H_
+#define cb_global_planner_DSTARLITEPLANNER_H_
+
+#include <float.h> // for DBL_MAX
+
+#include <algorithm>
+#include <vector>
+
+#include "a_star_planner/cost_model.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class DStarLitePlanner
+ * @brief Incremental planner (D* Lite) that keeps its search tree over plan() calls.
+ *
+ * The search runs from the goal cells to the robot, like the AStarPlanner, with the same cell costs,
+ * 8-connectivity and goal tier penalties, so it finds plans of the same cost. Between two calls the
+ * robot may move and costmap cells may change: the planner compares the costmap with the copy its tree
+ * is consistent with and only repairs the cells whose cost changed and the part of the tree that
+ * depends on them. A change of the goal cells or of the costmap size starts a new tree.
+ *
+ * Like the AStarPlanner the border cells of the costmap are never used.
+ */
+class DStarLitePlanner {
+
+public:
+
+	/**
+	 * @brief Counters of the last plan() call
+	 */
+	struct Statistics {
+		unsigned int cells_expanded;  // cells taken from the queue and made consistent
+		unsigned int cells_changed;   // costmap cells whose value changed since the previous call
+		bool restarted;               // the search tree was built from scratch
+
+		Statistics() : cells_expanded(0), cells_changed(0), restarted(false) {}
+	};
+
+	DStarLitePlanner();
+
+	/**
+	 * @brief Sets the cost model, the next plan() starts a new search tree
+	 */
+	void setCostModel(const CostModel& cost_model) { cost_model_ = cost_model; reset(); }
+
+	/**
+	 * @brief Fraction of the costmap cells that may change between two calls before the tree is rebuilt
+	 *        instead of repaired (repairing a large part of the tree is slower than a new search)
+	 */
+	void setMaxChangedFraction(double max_changed_fraction) { max_changed_fraction_ = max_changed_fraction; }
+
+	/**
+	 * @brief Drops the search tree, e.g. when the costmap moved, the next plan() starts from scratch
+	 */
+	void reset() { initialized_ = false; }
+
+	/**
+	 * @brief Plans from the goal cells to the robot cell, preferring goal cells of lower tiers
+	 * @param costmap Row-major costmap of width x height cells (Costmap2D::getCharMap())
+	 * @param mx_goals, my_goals Goal cells, one vector per tier
+	 * @param plan_xs, plan_ys The plan from the robot cell to a goal cell
+	 * @param tier The tier of the goal cell in which the plan ends
+	 * @return True if a plan was found
+	 */
+	bool plan(const unsigned char* costmap, unsigned int width, unsigned int height,
+			const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers,
+			unsigned int mx_robot, unsigned int my_robot, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier);
+
+	const Statistics& getStatistics() const { return statistics_; }
+
+private:
+
+	const static double SQRT2 = 1.414213562;
+
+	static const unsigned char NO_GOAL = 0xFF;
+
+	struct Key {
+		double k1, k2;
+		Key(double k1_ = DBL_MAX, double k2_ = DBL_MAX) : k1(k1_), k2(k2_) {}
+		bool operator<(const Key& other) const { return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2); }
+	};
+
+	// Queue entry, stale once the stamp of its cell has changed (lazy update and removal)
+	struct Entry {
+		Key key;
+		int k;
+		unsigned int stamp;
+		Entry(const Key& key_, int k_, unsigned int stamp_) : key(key_), k(k_), stamp(stamp_) {}
+		bool operator<(const Entry& other) const { return other.key < key; } // std heaps are max heaps
+	};
+
+	CostModel cost_model_;
+	double max_changed_fraction_;
+
+	bool initialized_;
+	unsigned int width_, height_;
+
+	// State of the tree, indexed by cell id (width_ * y + x)
+	std::vector<unsigned char> costmap_;     // the costmap the tree is consistent with
+	std::vector<double> g_, rhs_;
+	std::vector<unsigned char> goal_tier_;   // NO_GOAL for cells that are not a goal cell
+	std::vector<unsigned int> stamp_;        // incremented whenever the queue entry of a cell changes
+
+	std::vector<Entry> queue_;               // heap, contains stale entries
+
+	// cell id offsets of the 8 neighbours, straight ones first
+	int neighbour_offset_[8];
+
+	// goal cells of the tree, a plan() to other goal cells starts a new tree
+	std::vector<std::vector<unsigned int> > mx_goals_, my_goals_;
+
+	double tier_penalty_;
+	double min_cell_cost_;
+
+	// robot cell of the tree and accumulated key modifier
+	int k_robot_;
+	double km_;
+
+	std::vector<int> changed_cells_;
+
+	Statistics statistics_;
+
+	void initialize(const unsigned char* costmap, const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers);
+
+	// Collects the cells whose value differs from costmap_, returns false if there are more than max_changed
+	bool findChangedCells(const unsigned char* costmap, unsigned int max_changed);
+
+	inline bool isBorder(int k) const {
+		unsigned int x = k % width_, y = k / width_;
+		return x == 0 || y == 0 || x == width_ - 1 || y == height_ - 1;
+	}
+
+	inline double traversalTime(int k) const { return cost_model_.getTraversalTime(costmap_[k]); }
+
+	double heuristic(int k1, int k2) const;
+
+	inline Key calculateKey(int k) const {
+		double g = std::min(g_[k], rhs_[k]);
+		return Key(g + heuristic(k_robot_, k) + km_, g);
+	}
+
+	// Cost of the best plan from k via one of its neighbours or of ending in k
+	double calculateRhs(int k) const;
+
+	void updateVertex(int k);
+
+	// Returns the top valid entry (drops stale ones), false if the queue is empty
+	bool top(Entry& entry);
+
+	void pop();
+
+	void push(int k);
+
+	void computeShortestPath();
+
+	bool extractPlan(std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier) const;
+
+};
+
+}
+
+#endif /* DSTARLITEPLANNER_H_ */
@@ -0,0 +1,62 @@
+#include <pluginlib/class_list_macros.h>
+#include "d_star_lite_planner_gpp.h"
+
+namespace cb_global_planner
+{
+
+//register this planner as a BaseGlobalPlanner plugin
+PLUGINLIB_EXPORT_CLASS(cb_global_planner::DStarLitePlannerGPP, cb_global_planner::GlobalPlannerPlugin)
+
+// ----------------------------------------------------------------------------------------------------
+
+DStarLitePlannerGPP::DStarLitePlannerGPP() : origin_x_(0), origin_y_(0), resolution_(0) {}
+
+void DStarLitePlannerGPP::initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros)
+{
+    AStarPlannerGPP::initialize(name, tf, global_costmap_ros);
+
+    ros::NodeHandle private_nh("~/" + name);
+
+    // Fraction of the costmap cells that may change between two plans before the tree is rebuilt instead of repaired
+    double max_changed_fraction;
+    private_nh.param("d_star_lite/max_changed_fraction", max_changed_fraction, 0.1);
+    d_star_lite_.setMaxChangedFraction(std::max(0.0, max_changed_fraction));
+
+    d_star_lite_.setCostModel(cost_model_);
+
+    ROS_INFO("D* Lite Global planner initialized.");
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool DStarLitePlannerGPP::planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                          std::vector<int>& plan_xs, std::vector<int>& plan_ys)
+{
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+
+    // The tree is stored per cell, it does not survive a costmap that moved (rolling window) or was rescaled
+    if (costmap->getOriginX() != origin_x_ || costmap->getOriginY() != origin_y_ || costmap->getResolution() != resolution_) {
+        d_star_lite_.reset();
+        origin_x_ = costmap->getOriginX();
+        origin_y_ = costmap->getOriginY();
+        resolution_ = costmap->getResolution();
+    }
+
+    unsigned int tier;
+    ros::WallTime start = ros::WallTime::now();
+    bool found = d_star_lite_.plan(costmap->getCharMap(), costmap->getSizeInCellsX(), costmap->getSizeInCellsY(),
+                                   mx_tier, my_tier, CostModel::NUM_GOAL_TIERS, mx_start, my_start, plan_xs, plan_ys, tier);
+
+    statistics_.tier_searches.push_back((ros::WallTime::now() - start).toSec());
+
+    const DStarLitePlanner::Statistics& stats = d_star_lite_.getStatistics();
+    ROS_DEBUG_STREAM("[D* Lite Planner] " << (stats.restarted ? "New search" : "Repaired search") << ": " << stats.cells_changed
+                     << " cells changed, " << stats.cells_expanded << " cells expanded.");
+
+    statistics_.cells_expanded += stats.cells_expanded;
+    if (found) statistics_.tier = tier;
+
+    return found;
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef cb_global_planner_DSTARLITEPLANNER_GPP_H_
+#define cb_global_planner_DSTARLITEPLANNER_GPP_H_
+
+#include "a_star_planner/a_star_planner_gpp.h"
+#include "d_star_lite_planner.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class DStarLitePlannerGPP
+ * @brief Constrained based GlobalPlannerPlugin that replans incrementally with D* Lite.
+ *
+ * Goal constraints, goal tiers, the cost model and checkPlan are those of the AStarPlannerGPP; only the
+ * search is replaced. The search tree is kept between makePlan calls, so a replan to the same goal after
+ * the robot moved a few cells or a few costmap cells changed only repairs the affected part of the tree.
+ */
+class DStarLitePlannerGPP : public AStarPlannerGPP
+{
+
+public:
+
+    DStarLitePlannerGPP();
+
+    /**
+     * @brief  Initialization function for the DStarLitePlannerGPP object, takes the AStarPlannerGPP parameters
+     *         and d_star_lite/max_changed_fraction
+     * @param  name The name of this planner
+     * @param  tf Pointer to the tf listerner
+     * @param  costmap_ros A pointer to the ROS wrapper of the costmap to use for planning
+     */
+    void initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros);
+
+    /**
+     * @brief The search tree only pays off if every replan repairs it; a pool would spread the requests over trees
+     *        that are several costmaps behind, each with its own memory
+     */
+    bool supportsConcurrentRequests() const { return false; }
+
+protected:
+
+    bool planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                         std::vector<int>& plan_xs, std::vector<int>& plan_ys);
+
+    //! makePlanAnytime makes the optimal D* Lite plan
+    bool supportsAnytimeSearch() const { return false; }
+
+private:
+
+    DStarLitePlanner d_star_lite_;
+
+    //! Costmap geometry of the search tree, the tree is dropped when the costmap moves
+    double origin_x_, origin_y_, resolution_;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,425 @@
+#include "hierarchical_planner.h"
+
+#include <math.h> // for sqrt
+#include <string.h> // for memcmp, memcpy
+
+namespace cb_global_planner {
+
+namespace {
+
+// the 8 neighbours, straight ones first
+const int NEIGHBOUR_DX[8] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+const int NEIGHBOUR_DY[8] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+const double NEIGHBOUR_FACTOR[8] = { 1.0, 1.0, 1.0, 1.0, 1.414213562, 1.414213562, 1.414213562, 1.414213562 };
+
+}
+
+const unsigned char HierarchicalPlanner::NEIGHBOUR_CHANGED;
+const unsigned char HierarchicalPlanner::CELLS_CHANGED;
+const unsigned int HierarchicalPlanner::LONG_RUN;
+
+HierarchicalPlanner::HierarchicalPlanner() : cluster_size_(32), width_(0), height_(0), clusters_x_(0), clusters_y_(0),
+	tier_penalty_(0), min_cell_cost_(0) {
+}
+
+bool HierarchicalPlanner::plan(const unsigned char* costmap, unsigned int width, unsigned int height,
+		const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers,
+		unsigned int mx_robot, unsigned int my_robot, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier) {
+
+	statistics_ = Statistics();
+
+	if (mx_robot >= width || my_robot >= height) return false;
+
+	if (width != width_ || height != height_) {
+		width_ = width;
+		height_ = height;
+		build(costmap);
+	} else {
+		update(costmap);
+	}
+	statistics_.graph_nodes = node_cluster_.size();
+
+	int k_robot = width_ * my_robot + mx_robot;
+	if (!isTraversable(k_robot)) return false;
+
+	// 1) The goal cells to the portals of their clusters
+	std::vector<unsigned char> is_goal_cluster(clusters_.size(), 0);
+	std::vector<unsigned int> goal_clusters;
+
+	goal_nodes_.reset();
+	open_.prepare(width_ * height_);
+	for (unsigned int t = 0; t < num_tiers; ++t) {
+		for (unsigned int i = 0; i < mx_goals[t].size(); ++i) {
+			unsigned int x = mx_goals[t][i], y = my_goals[t][i];
+			if (x >= width_ || y >= height_) continue;
+
+			int k = width_ * y + x;
+			if (!goal_nodes_.touch(k) || goal_nodes_.g(k) != DBL_MAX) continue; // border or duplicate (the lowest tier keeps it)
+
+			goal_nodes_.g(k) = t * tier_penalty_;
+			open_.push(k, goal_nodes_.g(k));
+
+			int c = clusterOf(k);
+			if (!is_goal_cluster[c]) {
+				is_goal_cluster[c] = 1;
+				goal_clusters.push_back(c);
+			}
+		}
+	}
+	statistics_.cells_expanded += localSearch(goal_nodes_, false, -1);
+
+	// 2) The portals of the robot cluster to the robot
+	robot_nodes_.reset();
+	robot_nodes_.touch(k_robot);
+	robot_nodes_.g(k_robot) = 0;
+	open_.push(k_robot, 0);
+	statistics_.cells_expanded += localSearch(robot_nodes_, true, -1);
+
+	// 3) The portal graph, from the portals of the goal clusters to the robot cluster
+	unsigned int c_robot = clusterOf(k_robot);
+	double best = goal_nodes_.peekG(k_robot); // within one goal cluster
+	int best_id = -1;
+
+	unsigned int num_nodes = node_cluster_.size();
+	graph_g_.assign(num_nodes, DBL_MAX);
+	graph_parent_.assign(num_nodes, -1);
+	graph_closed_.assign(num_nodes, 0);
+	open_.prepare(num_nodes);
+
+	for (unsigned int i = 0; i < goal_clusters.size(); ++i) {
+		unsigned int c = goal_clusters[i];
+		for (unsigned int j = 0; j < clusters_[c].nodes.size(); ++j) {
+			unsigned int id = node_offset_[c] + j;
+			int k = clusters_[c].nodes[j].cell;
+			graph_g_[id] = goal_nodes_.peekG(k);
+			if (graph_g_[id] < DBL_MAX) open_.push(id, graph_g_[id] + heuristic(k, k_robot));
+		}
+	}
+
+	while (!open_.empty() && open_.topKey() < best) {
+		unsigned int id = open_.top();
+		open_.pop();
+
+		if (graph_closed_[id]) continue;
+		graph_closed_[id] = 1;
+		++statistics_.nodes_expanded;
+
+		unsigned int c = node_cluster_[id];
+		const Cluster& cluster = clusters_[c];
+		unsigned int i = id - node_offset_[c];
+		const Node& n = cluster.nodes[i];
+		double g = graph_g_[id];
+
+		if (c == c_robot) {
+			double g_robot = robot_nodes_.peekG(n.cell);
+			if (g_robot < DBL_MAX && g + g_robot < best) {
+				best = g + g_robot;
+				best_id = id;
+			}
+		}
+
+		// to the other portals of the cluster and across the border
+		unsigned int num_cluster_nodes = cluster.nodes.size();
+		for (unsigned int j = 0; j <= num_cluster_nodes; ++j) {
+			unsigned int id_next;
+			double g_next;
+			if (j < num_cluster_nodes) {
+				double cost = cluster.cost[i * num_cluster_nodes + j];
+				if (j == i || cost == DBL_MAX) continue;
+				id_next = node_offset_[c] + j;
+				g_next = g + cost;
+			} else {
+				if (n.twin_index < 0) continue;
+				id_next = node_offset_[n.twin_cluster] + n.twin_index;
+				g_next = g + traversalTime(n.twin_cell);
+			}
+
+			if (g_next < graph_g_[id_next] && !graph_closed_[id_next]) {
+				graph_g_[id_next] = g_next;
+				graph_parent_[id_next] = id;
+				open_.push(id_next, g_next + heuristic(node(id_next).cell, k_robot));
+			}
+		}
+	}
+
+	if (best == DBL_MAX) return false;
+
+	// 4) Refinement into cells, from the robot to the goal cell
+	std::vector<int> cells;
+	if (best_id < 0) {
+		for (int k = k_robot; k >= 0; k = goal_nodes_.parent(k)) cells.push_back(k);
+	} else {
+		for (int k = node(best_id).cell; k >= 0; k = robot_nodes_.parent(k)) cells.push_back(k);
+		std::reverse(cells.begin(), cells.end());
+
+		int id = best_id;
+		for (; graph_parent_[id] >= 0; id = graph_parent_[id]) {
+			int k_from = node(graph_parent_[id]).cell, k_to = node(id).cell;
+			if (clusterOf(k_from) != clusterOf(k_to)) {
+				cells.push_back(k_from);
+			} else if (k_from != k_to && !appendLocalPath(k_from, k_to, cells)) {
+				return false;
+			}
+		}
+
+		for (int k = goal_nodes_.parent(node(id).cell); k >= 0; k = goal_nodes_.parent(k)) cells.push_back(k);
+	}
+
+	tier = (unsigned int) (goal_nodes_.peekG(cells.back()) / tier_penalty_ + 0.5);
+
+	for (unsigned int i = 0; i < cells.size(); ++i) {
+		plan_xs.push_back(cells[i] % width_);
+		plan_ys.push_back(cells[i] / width_);
+	}
+	return true;
+}
+
+double HierarchicalPlanner::heuristic(int k1, int k2) const {
+	double dx = (double) ((k1 % (int) width_) - (k2 % (int) width_));
+	double dy = (double) ((k1 / (int) width_) - (k2 / (int) width_));
+	return sqrt(dx * dx + dy * dy) * min_cell_cost_;
+}
+
+void HierarchicalPlanner::build(const unsigned char* costmap) {
+	unsigned int n = width_ * height_;
+	costmap_.assign(costmap, costmap + n);
+
+	// same tier penalty as AStarPlanner::planTiered: above any plan cost
+	min_cell_cost_ = cost_model_.getMinTraversalTime();
+	tier_penalty_ = (cost_model_.getMaxTraversalTime() * SQRT2 + 1) * n;
+
+	goal_nodes_.resize(n);
+	robot_nodes_.resize(n);
+	local_nodes_.resize(n);
+	blockBorder(goal_nodes_);
+	blockBorder(robot_nodes_);
+	blockBorder(local_nodes_);
+
+	clusters_x_ = (width_ + cluster_size_ - 1) / cluster_size_;
+	clusters_y_ = (height_ + cluster_size_ - 1) / cluster_size_;
+	clusters_.assign(clusters_x_ * clusters_y_, Cluster());
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		Cluster& cluster = clusters_[c];
+		cluster.x_begin = (c % clusters_x_) * cluster_size_;
+		cluster.y_begin = (c / clusters_x_) * cluster_size_;
+		cluster.x_end = std::min(cluster.x_begin + cluster_size_, width_);
+		cluster.y_end = std::min(cluster.y_begin + cluster_size_, height_);
+	}
+
+	rebuildClusters(std::vector<unsigned char>(clusters_.size(), CELLS_CHANGED));
+}
+
+void HierarchicalPlanner::update(const unsigned char* costmap) {
+	std::vector<unsigned char> affected(clusters_.size(), 0);
+	bool changed = false;
+
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		const Cluster& cluster = clusters_[c];
+		unsigned int row_length = cluster.x_end - cluster.x_begin;
+
+		bool dirty = false;
+		for (unsigned int y = cluster.y_begin; y < cluster.y_end; ++y) {
+			unsigned int k = width_ * y + cluster.x_begin;
+			if (memcmp(&costmap_[k], costmap + k, row_length) != 0) {
+				memcpy(&costmap_[k], costmap + k, row_length);
+				dirty = true;
+			}
+		}
+		if (!dirty) continue;
+
+		// the portals on the borders with the neighbours may change as well
+		changed = true;
+		unsigned int cx = c % clusters_x_, cy = c / clusters_x_;
+		affected[c] = CELLS_CHANGED;
+		if (cx > 0) affected[c - 1] = std::max(affected[c - 1], NEIGHBOUR_CHANGED);
+		if (cx + 1 < clusters_x_) affected[c + 1] = std::max(affected[c + 1], NEIGHBOUR_CHANGED);
+		if (cy > 0) affected[c - clusters_x_] = std::max(affected[c - clusters_x_], NEIGHBOUR_CHANGED);
+		if (cy + 1 < clusters_y_) affected[c + clusters_x_] = std::max(affected[c + clusters_x_], NEIGHBOUR_CHANGED);
+	}
+
+	if (changed) rebuildClusters(affected);
+}
+
+void HierarchicalPlanner::rebuildClusters(const std::vector<unsigned char>& affected) {
+	// a cluster next to a changed one keeps its portal costs if its portals stay the same
+	std::vector<unsigned char> recompute(affected.begin(), affected.end());
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		if (!affected[c]) continue;
+
+		std::vector<Node> old_nodes;
+		if (affected[c] == NEIGHBOUR_CHANGED) old_nodes.swap(clusters_[c].nodes);
+		findPortals(c);
+
+		if (affected[c] == NEIGHBOUR_CHANGED) {
+			const std::vector<Node>& nodes = clusters_[c].nodes;
+			bool same = (nodes.size() == old_nodes.size());
+			for (unsigned int i = 0; same && i < nodes.size(); ++i) same = (nodes[i].cell == old_nodes[i].cell);
+			recompute[c] = !same;
+		}
+	}
+
+	// the node indices of a rebuilt cluster changed, so its neighbours have to relink too
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		unsigned int cx = c % clusters_x_, cy = c / clusters_x_;
+		if (affected[c] || (cx > 0 && affected[c - 1]) || (cx + 1 < clusters_x_ && affected[c + 1])
+				|| (cy > 0 && affected[c - clusters_x_]) || (cy + 1 < clusters_y_ && affected[c + clusters_x_])) {
+			linkTwins(c);
+		}
+	}
+
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		if (recompute[c]) {
+			computePortalCosts(c);
+			++statistics_.clusters_rebuilt;
+		}
+	}
+
+	node_offset_.resize(clusters_.size());
+	node_cluster_.clear();
+	for (unsigned int c = 0; c < clusters_.size(); ++c) {
+		node_offset_[c] = node_cluster_.size();
+		node_cluster_.resize(node_cluster_.size() + clusters_[c].nodes.size(), c);
+	}
+}
+
+void HierarchicalPlanner::findPortals(unsigned int c) {
+	Cluster& cluster = clusters_[c];
+	cluster.nodes.clear();
+
+	int w = width_;
+	int k_first = w * cluster.y_begin + cluster.x_begin;
+	int k_last = w * (cluster.y_end - 1) + cluster.x_end - 1;
+	unsigned int size_x = cluster.x_end - cluster.x_begin, size_y = cluster.y_end - cluster.y_begin;
+
+	// every border is walked in increasing x or y, like the neighbour walks it, so both find the same portals
+	if (cluster.x_begin > 0) addPortals(cluster, k_first, w, size_y, -1, c - 1);
+	if (cluster.x_end < width_) addPortals(cluster, k_first + size_x - 1, w, size_y, 1, c + 1);
+	if (cluster.y_begin > 0) addPortals(cluster, k_first, 1, size_x, -w, c - clusters_x_);
+	if (cluster.y_end < height_) addPortals(cluster, k_last - size_x + 1, 1, size_x, w, c + clusters_x_);
+}
+
+void HierarchicalPlanner::addPortals(Cluster& cluster, int k_first, int step, unsigned int length, int twin_offset, int twin_cluster) {
+	unsigned int run_begin = 0, run_length = 0;
+	for (unsigned int i = 0; i <= length; ++i) {
+		int k = k_first + i * step;
+		if (i < length && isTraversable(k) && isTraversable(k + twin_offset)) {
+			if (run_length++ == 0) run_begin = i;
+			continue;
+		}
+		if (run_length == 0) continue;
+
+		if (run_length < LONG_RUN) {
+			int k_portal = k_first + (run_begin + run_length / 2) * step;
+			cluster.nodes.push_back(Node(k_portal, k_portal + twin_offset, twin_cluster));
+		} else {
+			int k_begin = k_first + run_begin * step, k_end = k_first + (run_begin + run_length - 1) * step;
+			cluster.nodes.push_back(Node(k_begin, k_begin + twin_offset, twin_cluster));
+			cluster.nodes.push_back(Node(k_end, k_end + twin_offset, twin_cluster));
+		}
+		run_length = 0;
+	}
+}
+
+void HierarchicalPlanner::linkTwins(unsigned int c) {
+	std::vector<Node>& nodes = clusters_[c].nodes;
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		const std::vector<Node>& twins = clusters_[nodes[i].twin_cluster].nodes;
+		nodes[i].twin_index = -1;
+		for (unsigned int j = 0; j < twins.size(); ++j) {
+			if (twins[j].cell == nodes[i].twin_cell && twins[j].twin_cell == nodes[i].cell) {
+				nodes[i].twin_index = j;
+				break;
+			}
+		}
+	}
+}
+
+void HierarchicalPlanner::computePortalCosts(unsigned int c) {
+	Cluster& cluster = clusters_[c];
+	unsigned int n = cluster.nodes.size();
+	cluster.cost.assign(n * n, DBL_MAX);
+
+	for (unsigned int i = 0; i < n; ++i) {
+		local_nodes_.reset();
+		local_nodes_.touch(cluster.nodes[i].cell);
+		local_nodes_.g(cluster.nodes[i].cell) = 0;
+		open_.prepare(0);
+		open_.push(cluster.nodes[i].cell, 0);
+		localSearch(local_nodes_, false, -1);
+
+		for (unsigned int j = 0; j < n; ++j) {
+			cluster.cost[i * n + j] = local_nodes_.peekG(cluster.nodes[j].cell);
+		}
+	}
+}
+
+void HierarchicalPlanner::blockBorder(SearchNodes& nodes) {
+	for (unsigned int x = 0; x < width_; ++x) {
+		nodes.block(x);
+		nodes.block(width_ * (height_ - 1) + x);
+	}
+	for (unsigned int y = 0; y < height_; ++y) {
+		nodes.block(width_ * y);
+		nodes.block(width_ * y + width_ - 1);
+	}
+}
+
+unsigned int HierarchicalPlanner::localSearch(SearchNodes& nodes, bool reverse, int k_target) {
+	unsigned int expanded = 0;
+
+	while (!open_.empty()) {
+		int k = open_.top();
+		open_.pop();
+
+		if (nodes.isClosed(k)) continue;
+		nodes.close(k);
+		++expanded;
+
+		if (k == k_target) break;
+
+		// in reverse the step from a neighbour onto k is taken backwards, it costs k
+		double traversal_time = traversalTime(k);
+		if (reverse && traversal_time == DBL_MAX) continue;
+
+		double g = nodes.g(k);
+		unsigned int x = k % width_, y = k / width_;
+		unsigned int cx = x / cluster_size_, cy = y / cluster_size_;
+
+		// k is no border cell (those are blocked), so its neighbours are inside the costmap
+		for (unsigned int d = 0; d < 8; ++d) {
+			unsigned int nx = x + NEIGHBOUR_DX[d], ny = y + NEIGHBOUR_DY[d];
+			if (nx / cluster_size_ != cx || ny / cluster_size_ != cy) continue;
+
+			int n = width_ * ny + nx;
+			if (!nodes.touch(n) || nodes.isClosed(n)) continue;
+
+			double t = reverse ? traversal_time : traversalTime(n);
+			if (t == DBL_MAX) continue;
+
+			double g_n = g + t * NEIGHBOUR_FACTOR[d];
+			if (g_n < nodes.g(n)) {
+				nodes.g(n) = g_n;
+				nodes.parent(n) = k;
+				open_.push(n, k_target >= 0 ? g_n + heuristic(n, k_target) : g_n);
+			}
+		}
+	}
+
+	open_.prepare(0);
+	return expanded;
+}
+
+bool HierarchicalPlanner::appendLocalPath(int k_from, int k_to, std::vector<int>& cells) {
+	local_nodes_.reset();
+	local_nodes_.touch(k_from);
+	local_nodes_.g(k_from) = 0;
+	open_.push(k_from, heuristic(k_from, k_to));
+	statistics_.cells_expanded += localSearch(local_nodes_, false, k_to);
+
+	if (local_nodes_.peekG(k_to) == DBL_MAX) return false;
+
+	for (int k = local_nodes_.parent(k_to); k >= 0; k = local_nodes_.parent(k)) cells.push_back(k);
+	return true;
+}
+
+}
@@ -0,0 +1,187 @@
+#ifndef cb_global_planner_HIERARCHICALPLANNER_H_
+#define cb_global_planner_HIERARCHICALPLANNER_H_
+
+#include <float.h> // for DBL_MAX
+
+#include <algorithm>
+#include <vector>
+
+#include "a_star_planner/cost_model.h"
+#include "a_star_planner/open_list.h"
+#include "a_star_planner/search_nodes.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class HierarchicalPlanner
+ * @brief HPA* style planner: a cluster / portal graph over the costmap that is searched instead of the cells.
+ *
+ * The costmap is divided in square clusters. Every run of traversable cell pairs across the border of two
+ * clusters gets a portal (one in the middle of a short run, one at each end of a long run), and the portal
+ * cells of a cluster are connected by the costs of the cheapest paths between them within the cluster.
+ * A query connects the goal cells and the robot to the portals of their clusters with searches bounded to
+ * those clusters, searches the portal graph, and refines the result into cells with one search per portal
+ * graph edge, each bounded to a single cluster. Plans are close to, but not always as cheap as, the plans
+ * of the AStarPlanner; crossings between clusters are straight steps.
+ *
+ * The planner keeps a copy of the costmap; clusters whose cells changed are rebuilt together with their
+ * neighbours, the rest of the graph is kept. Costs, goal tiers and the unused border cells are those of
+ * the AStarPlanner.
+ */
+class HierarchicalPlanner {
+
+public:
+
+	/**
+	 * @brief Counters of the last plan() call
+	 */
+	struct Statistics {
+		unsigned int clusters_rebuilt;  // clusters whose portal costs were recomputed
+		unsigned int graph_nodes;       // portal cells in the graph
+		unsigned int nodes_expanded;    // portal graph nodes expanded by the query
+		unsigned int cells_expanded;    // cells expanded by the bounded searches (connection and refinement)
+
+		Statistics() : clusters_rebuilt(0), graph_nodes(0), nodes_expanded(0), cells_expanded(0) {}
+	};
+
+	HierarchicalPlanner();
+
+	/**
+	 * @brief Sets the cost model, the next plan() rebuilds the graph
+	 */
+	void setCostModel(const CostModel& cost_model) { cost_model_ = cost_model; reset(); }
+
+	/**
+	 * @brief Sets the cluster size [cells], the next plan() rebuilds the graph
+	 */
+	void setClusterSize(unsigned int cluster_size) { cluster_size_ = std::max(cluster_size, 4u); reset(); }
+
+	unsigned int getClusterSize() const { return cluster_size_; }
+
+	/**
+	 * @brief Drops the graph, e.g. when the costmap moved, the next plan() builds it from scratch
+	 */
+	void reset() { width_ = height_ = 0; }
+
+	/**
+	 * @brief Plans from the goal cells to the robot cell, preferring goal cells of lower tiers
+	 * @param costmap Row-major costmap of width x height cells (Costmap2D::getCharMap())
+	 * @param mx_goals, my_goals Goal cells, one vector per tier
+	 * @param plan_xs, plan_ys The plan from the robot cell to a goal cell
+	 * @param tier The tier of the goal cell in which the plan ends
+	 * @return True if a plan was found
+	 */
+	bool plan(const unsigned char* costmap, unsigned int width, unsigned int height,
+			const std::vector<unsigned int>* mx_goals, const std::vector<unsigned int>* my_goals, unsigned int num_tiers,
+			unsigned int mx_robot, unsigned int my_robot, std::vector<int>& plan_xs, std::vector<int>& plan_ys, unsigned int& tier);
+
+	const Statistics& getStatistics() const { return statistics_; }
+
+private:
+
+	const static double SQRT2 = 1.414213562;
+
+	// Why a cluster is rebuilt by rebuildClusters
+	static const unsigned char NEIGHBOUR_CHANGED = 1;
+	static const unsigned char CELLS_CHANGED = 2;
+
+	// Runs of at least this many cell pairs get a portal at each end instead of one in the middle
+	static const unsigned int LONG_RUN = 8;
+
+	/**
+	 * @brief Portal cell of a cluster, connected by a straight step to its twin cell in a neighbouring cluster
+	 */
+	struct Node {
+		int cell;
+		int twin_cell;
+		int twin_cluster;
+		int twin_index;  // index of the twin in the nodes of twin_cluster
+		Node(int cell_, int twin_cell_, int twin_cluster_) : cell(cell_), twin_cell(twin_cell_), twin_cluster(twin_cluster_), twin_index(-1) {}
+	};
+
+	struct Cluster {
+		unsigned int x_begin, x_end, y_begin, y_end;
+		std::vector<Node> nodes;
+		std::vector<double> cost;  // cost[i * n + j]: cheapest path within the cluster from node i to node j
+	};
+
+	CostModel cost_model_;
+	unsigned int cluster_size_;
+
+	unsigned int width_, height_;
+	unsigned int clusters_x_, clusters_y_;
+
+	// the costmap the graph was built for
+	std::vector<unsigned char> costmap_;
+
+	std::vector<Cluster> clusters_;
+	std::vector<unsigned int> node_offset_;  // id of the first node of each cluster in the portal graph
+	std::vector<unsigned int> node_cluster_; // cluster of each node id
+
+	double tier_penalty_;
+	double min_cell_cost_;
+
+	// Bounded searches: from the goal cells, from the robot (reverse) and for the refinement / portal costs
+	SearchNodes goal_nodes_, robot_nodes_, local_nodes_;
+	BinaryOpenList open_;
+
+	// Portal graph search
+	std::vector<double> graph_g_;
+	std::vector<int> graph_parent_;
+	std::vector<unsigned char> graph_closed_;
+
+	Statistics statistics_;
+
+	inline int clusterOf(unsigned int x, unsigned int y) const { return (y / cluster_size_) * clusters_x_ + x / cluster_size_; }
+
+	inline int clusterOf(int k) const { return clusterOf(k % width_, k / width_); }
+
+	inline bool isTraversable(int k) const {
+		unsigned int x = k % width_, y = k / width_;
+		return x > 0 && y > 0 && x < width_ - 1 && y < height_ - 1 && cost_model_.getTraversalTime(costmap_[k]) < DBL_MAX;
+	}
+
+	inline double traversalTime(int k) const { return cost_model_.getTraversalTime(costmap_[k]); }
+
+	inline const Node& node(unsigned int id) const {
+		unsigned int c = node_cluster_[id];
+		return clusters_[c].nodes[id - node_offset_[c]];
+	}
+
+	double heuristic(int k1, int k2) const;
+
+	void build(const unsigned char* costmap);
+
+	// Rebuilds the clusters whose cells differ from costmap_ and their neighbours
+	void update(const unsigned char* costmap);
+
+	// affected: NEIGHBOUR_CHANGED or CELLS_CHANGED per cluster to rebuild, 0 for the others
+	void rebuildClusters(const std::vector<unsigned char>& affected);
+
+	void findPortals(unsigned int c);
+
+	// Adds the portals of the run of cell pairs (k_first + i * step, k_first + i * step + twin_offset), i < length
+	void addPortals(Cluster& cluster, int k_first, int step, unsigned int length, int twin_offset, int twin_cluster);
+
+	void linkTwins(unsigned int c);
+
+	void computePortalCosts(unsigned int c);
+
+	void blockBorder(SearchNodes& nodes);
+
+	/**
+	 * @brief Search from the cells pushed on open_, every cell only reaches cells of its own cluster
+	 * @param reverse False: a step onto a cell costs its traversal time; true: a step off a cell does (search from the robot)
+	 * @param k_target Stops when this cell is expanded and uses it as A* heuristic target, -1: exhaustive
+	 * @return Number of expanded cells
+	 */
+	unsigned int localSearch(SearchNodes& nodes, bool reverse, int k_target);
+
+	// Refines a portal graph edge within one cluster: appends the cells after k_to up to k_from (plan order)
+	bool appendLocalPath(int k_from, int k_to, std::vector<int>& cells);
+
+};
+
+}
+
+#endif /* HIERARCHICALPLANNER_H_ */
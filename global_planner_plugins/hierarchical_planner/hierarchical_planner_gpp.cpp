@@ -0,0 +1,62 @@
+#include <pluginlib/class_list_macros.h>
+#include "hierarchical_planner_gpp.h"
+
+namespace cb_global_planner
+{
+
+//register this planner as a BaseGlobalPlanner plugin
+PLUGINLIB_EXPORT_CLASS(cb_global_planner::HierarchicalPlannerGPP, cb_global_planner::GlobalPlannerPlugin)
+
+// ----------------------------------------------------------------------------------------------------
+
+HierarchicalPlannerGPP::HierarchicalPlannerGPP() : origin_x_(0), origin_y_(0), resolution_(0) {}
+
+void HierarchicalPlannerGPP::initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros)
+{
+    AStarPlannerGPP::initialize(name, tf, global_costmap_ros);
+
+    ros::NodeHandle private_nh("~/" + name);
+
+    // Side of the square clusters [cells]: larger clusters give cheaper plans but slower cluster updates
+    int cluster_size;
+    private_nh.param("hierarchical/cluster_size", cluster_size, 32);
+    hierarchical_.setClusterSize(std::max(4, cluster_size));
+
+    hierarchical_.setCostModel(cost_model_);
+
+    ROS_INFO("Hierarchical Global planner initialized.");
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool HierarchicalPlannerGPP::planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                                             std::vector<int>& plan_xs, std::vector<int>& plan_ys)
+{
+    costmap_2d::Costmap2D* costmap = global_costmap_ros_->getCostmap();
+
+    // The clusters are fixed to cells, the graph does not survive a costmap that moved (rolling window) or was rescaled
+    if (costmap->getOriginX() != origin_x_ || costmap->getOriginY() != origin_y_ || costmap->getResolution() != resolution_) {
+        hierarchical_.reset();
+        origin_x_ = costmap->getOriginX();
+        origin_y_ = costmap->getOriginY();
+        resolution_ = costmap->getResolution();
+    }
+
+    unsigned int tier;
+    ros::WallTime start = ros::WallTime::now();
+    bool found = hierarchical_.plan(costmap->getCharMap(), costmap->getSizeInCellsX(), costmap->getSizeInCellsY(),
+                                    mx_tier, my_tier, CostModel::NUM_GOAL_TIERS, mx_start, my_start, plan_xs, plan_ys, tier);
+
+    statistics_.tier_searches.push_back((ros::WallTime::now() - start).toSec());
+
+    const HierarchicalPlanner::Statistics& stats = hierarchical_.getStatistics();
+    ROS_DEBUG_STREAM("[Hierarchical Planner] " << stats.clusters_rebuilt << " clusters rebuilt, " << stats.nodes_expanded << " of "
+                     << stats.graph_nodes << " portals expanded, " << stats.cells_expanded << " cells expanded.");
+
+    statistics_.cells_expanded += stats.cells_expanded;
+    if (found) statistics_.tier = tier;
+
+    return found;
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef cb_global_planner_HIERARCHICALPLANNER_GPP_H_
+#define cb_global_planner_HIERARCHICALPLANNER_GPP_H_
+
+#include "a_star_planner/a_star_planner_gpp.h"
+#include "hierarchical_planner.h"
+
+namespace cb_global_planner {
+
+/**
+ * @class HierarchicalPlannerGPP
+ * @brief Constrained based GlobalPlannerPlugin that searches a cluster / portal graph (HPA*) for building-scale costmaps.
+ *
+ * Goal constraints, goal tiers, the cost model and checkPlan are those of the AStarPlannerGPP; only the
+ * search is replaced. The portal graph is kept between makePlan calls and only the clusters whose costmap
+ * cells changed (and their neighbours) are rebuilt. Plans are slightly more expensive than A* plans.
+ */
+class HierarchicalPlannerGPP : public AStarPlannerGPP
+{
+
+public:
+
+    HierarchicalPlannerGPP();
+
+    /**
+     * @brief  Initialization function for the HierarchicalPlannerGPP object, takes the AStarPlannerGPP parameters
+     *         and hierarchical/cluster_size
+     * @param  name The name of this planner
+     * @param  tf Pointer to the tf listerner
+     * @param  costmap_ros A pointer to the ROS wrapper of the costmap to use for planning
+     */
+    void initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros);
+
+protected:
+
+    bool planToGoalCells(const std::vector<unsigned int>* mx_tier, const std::vector<unsigned int>* my_tier, unsigned int mx_start, unsigned int my_start,
+                         std::vector<int>& plan_xs, std::vector<int>& plan_ys);
+
+    //! The hierarchical search has no anytime variant
+    bool supportsAnytimeSearch() const { return false; }
+
+private:
+
+    HierarchicalPlanner hierarchical_;
+
+    //! Costmap geometry of the portal graph, the graph is dropped when the costmap moves
+    double origin_x_, origin_y_, resolution_;
+
+};
+
+}
+
+#endif
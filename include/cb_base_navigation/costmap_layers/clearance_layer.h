@@ -0,0 +1,124 @@
+#ifndef cb_base_navigation_CLEARANCE_LAYER_H_
+#define cb_base_navigation_CLEARANCE_LAYER_H_
+
+#include <costmap_2d/layer.h>
+#include <costmap_2d/layered_costmap.h>
+#include <geometry_msgs/Point.h>
+
+#include <boost/thread/shared_mutex.hpp>
+
+#include <vector>
+
+namespace cb_base_navigation {
+
+/**
+ * @class FootprintCover
+ * @brief Circles in the robot frame that together cover the robot footprint.
+ *
+ * The bounding box of the footprint is cut in slabs along its longest side, one circle per slab through the corners
+ * of the slab: the cover is conservative, also for footprints that do not fill their bounding box.
+ */
+class FootprintCover {
+
+public:
+
+    struct Circle {
+        double x, y, radius;
+    };
+
+    FootprintCover() : radius_(0) {}
+
+    /**
+     * @param max_overshoot How far a circle may reach outside the bounding box [m], sets the number of circles
+     */
+    FootprintCover(const std::vector<geometry_msgs::Point>& footprint, double max_overshoot);
+
+    const std::vector<Circle>& getCircles() const { return circles_; }
+
+    /**
+     * @brief Distance from the robot origin to the farthest point of the cover [m]
+     */
+    double getRadius() const { return radius_; }
+
+private:
+
+    std::vector<Circle> circles_;
+    double radius_;
+
+};
+
+/**
+ * @class ClearanceLayer
+ * @brief Costmap layer that changes no cells, but keeps the distance from every cell to the nearest lethal cell.
+ *
+ * The distances are exact Euclidean distances between cell centres, up to max_distance; farther cells get
+ * max_distance. They are computed on the master costmap as it is after the layers before this one, so the layer
+ * is put after the obstacle layers. An update only recomputes the cells within max_distance of the cells it
+ * changed, from the lethal cells within 2 * max_distance.
+ */
+class ClearanceLayer : public costmap_2d::Layer {
+
+public:
+
+    ClearanceLayer() : max_distance_(1.0), size_x_(0), size_y_(0), needs_full_update_(true), cells_updated_(0) {}
+
+    void updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x, double* max_y) {}
+
+    void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j);
+
+    void matchSize();
+
+    /**
+     * @brief Distance from the cell of the world point to the nearest lethal cell [m], max_distance off the map
+     */
+    double getClearance(double wx, double wy) const;
+
+    /**
+     * @brief Whether the footprint cover, at the given robot pose, keeps clear of lethal cells
+     *
+     * A circle is clear if the nearest lethal cell is farther than its radius; circles as large as max_distance never are.
+     */
+    bool isFootprintFree(const FootprintCover& cover, double x, double y, double yaw) const;
+
+    double getMaxDistance() const;
+
+    /**
+     * @brief Number of cells the last update recomputed
+     */
+    unsigned int getCellsUpdated() const { return cells_updated_; }
+
+    /**
+     * @brief Finds the clearance layer of a costmap, NULL if it has none
+     */
+    static const ClearanceLayer* find(costmap_2d::LayeredCostmap* layered_costmap);
+
+    /**
+     * @brief Exact Euclidean distance transform of a window of the map, in cells (squared input: 0 for lethal cells, large otherwise)
+     *
+     * Both passes of Felzenszwalb and Huttenlocher; f holds width * height squared distances and is overwritten.
+     */
+    static void distanceTransform(std::vector<float>& f, int width, int height);
+
+protected:
+
+    void onInitialize();
+
+private:
+
+    double max_distance_;           // [m]
+
+    mutable boost::shared_mutex mutex_; // unique while updating, the costmap updates in its own thread
+    unsigned int size_x_, size_y_;
+    double resolution_, origin_x_, origin_y_;
+    std::vector<float> distances_;  // [m], row-major
+    bool needs_full_update_;
+
+    unsigned int cells_updated_;
+
+    inline double getClearanceLocked(double wx, double wy) const;
+
+};
+
+}
+
+#endif /* CLEARANCE_LAYER_H_ */
@@ -0,0 +1,80 @@
+#ifndef cb_base_navigation_ENTITY_POSE_CACHE_H_
+#define cb_base_navigation_ENTITY_POSE_CACHE_H_
+
+#include <ros/ros.h>
+#include <tf/transform_datatypes.h>
+
+#include <boost/thread.hpp>
+
+#include <map>
+#include <string>
+
+namespace cb_base_navigation {
+
+/**
+ * @class EntityPoseCache
+ * @brief Poses of world model (ED) entities, polled in the background so lookups do not wait for ED.
+ *
+ * An entity is polled from the first time its pose is asked for until it has not been asked for during
+ * forget_after seconds. A cached pose is only served while it is younger than max_age; getPose with
+ * wait = true queries ED itself when there is no such pose, so the first lookup of an entity (or a lookup
+ * after ED stopped answering) still gets a fresh pose, at the cost of a round-trip.
+ *
+ * The frames "map" and "/map" are the identity and are never queried.
+ */
+class EntityPoseCache {
+
+public:
+
+    /**
+     * @param poll_frequency Rate at which every entity in use is queried [Hz]
+     * @param max_age Age after which a cached pose is no longer served [s]
+     * @param forget_after An entity that has not been asked for during this time is no longer polled [s]
+     */
+    EntityPoseCache(double poll_frequency = 10.0, double max_age = 1.0, double forget_after = 10.0);
+
+    ~EntityPoseCache();
+
+    /**
+     * @brief Pose of the entity in the map frame
+     * @param wait Query ED if there is no recent enough cached pose (blocks), otherwise only the cache is used
+     * @return False if there is no pose younger than max_age (and ED could not give one)
+     */
+    bool getPose(const std::string& id, tf::Transform& pose, bool wait = false);
+
+    double getMaxAge() const { return max_age_; }
+
+private:
+
+    struct Entry {
+        tf::Transform pose;
+        ros::Time stamp;        // zero as long as there is no pose
+        ros::Time last_request;
+    };
+
+    ros::ServiceClient ed_client_;      // used by the poll thread only
+    ros::ServiceClient ed_wait_client_; // used by waiting lookups, guarded by wait_mutex_
+
+    double poll_frequency_;
+    double max_age_;
+    double forget_after_;
+
+    boost::mutex mutex_; // guards entries_
+    std::map<std::string, Entry> entries_;
+
+    boost::mutex wait_mutex_;
+
+    boost::thread poll_thread_;
+
+    void pollThread();
+
+    bool query(ros::ServiceClient& client, const std::string& id, tf::Transform& pose) const;
+
+    // Stores a pose that was received at stamp, unless a newer one came in meanwhile
+    void store(const std::string& id, const tf::Transform& pose, const ros::Time& stamp);
+
+};
+
+}
+
+#endif /* ENTITY_POSE_CACHE_H_ */
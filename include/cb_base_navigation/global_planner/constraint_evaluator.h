@@ -9,6 +9,7 @@
 #define cb_global_planner_CONSTRAINT_EVALUATOR_H_
 
 #include "exprtk.h"
+#include "constraint_program.h"
 #include <tf/transform_datatypes.h>
 
 namespace cb_global_planner
@@ -33,6 +34,13 @@ public:
      */
     bool init(const std::string& constraint);
 
+    /**
+     * @brief   Initializes this evaluator with the constraint of another one, e.g. to evaluate it in another thread.
+     *          A validated ConstraintProgram is copied, only exprtk constraints are compiled again.
+     * @param   other   An initialized evaluator
+     */
+    bool initCopy(const ConstraintEvaluator& other);
+
     /**
      * @brief   Evaluates the constraint for an x,y value
      * @param   x   x value
@@ -40,6 +48,24 @@ public:
      */
     bool evaluate(const double& x, const double& y);
 
+    /**
+     * @brief   Evaluates the constraint for n points on a line: (x0 + i * dx, y0 + i * dy), i = 0 .. n-1
+     * @param   result  per point 1 if the constraint holds, 0 otherwise
+     */
+    void evaluateLine(double x0, double y0, double dx, double dy, unsigned int n, unsigned char* result);
+
+    /**
+     * @brief   Conservative bounding box of the points within a domain that may satisfy the constraint (see ConstraintProgram::getBoundingBox)
+     * @return  False if the bounding box is unknown, then the whole domain has to be evaluated
+     */
+    bool getBoundingBox(double min_x, double min_y, double max_x, double max_y, double resolution,
+                        double& bb_min_x, double& bb_min_y, double& bb_max_x, double& bb_max_y) const;
+
+    /**
+     * @brief   Returns true if the constraint is evaluated in batches by a ConstraintProgram, false if point by point by exprtk
+     */
+    inline bool isBatched() const { return program_.isValid(); }
+
     /**
      * @brief   Returns the initialized constraint.
      */
@@ -52,6 +78,11 @@ private:
     double x_,y_;
     bool initialized_;
 
+    //! Batched version of the expression, only valid if it agrees with exprtk
+    ConstraintProgram program_;
+
+    bool validateProgram();
+
 };
 
 }
@@ -0,0 +1,140 @@
+#ifndef cb_global_planner_CONSTRAINT_PROGRAM_H_
+#define cb_global_planner_CONSTRAINT_PROGRAM_H_
+
+#include <string>
+#include <vector>
+
+namespace cb_global_planner
+{
+
+/**
+ * @class ConstraintProgram
+ * @brief Position constraint compiled to a postfix program that is evaluated over batches of points.
+ *
+ * Understands the part of the exprtk grammar that is used for position constraints: numbers,
+ * the variables x and y, + - * / % ^, comparisons, and / or / xor / nand / nor / xnor (also & and |),
+ * not(), brackets and the functions abs, sqrt, sin, cos, tan, asin, acos, atan, atan2, exp, log,
+ * floor, ceil, hypot, min and max. Operator precedence and the value of every operation follow
+ * exprtk, so a program gives the same result as the exprtk expression of the same string.
+ *
+ * Every instruction runs over a whole batch of points at once, which turns the per point
+ * interpretation overhead of exprtk into tight loops over arrays.
+ */
+class ConstraintProgram
+{
+
+public:
+    /**
+     * @brief  Constructor for an empty (invalid) program
+     */
+    ConstraintProgram();
+
+    /**
+     * @brief   Compiles a constraint
+     * @param   constraint  The position constraint, e.g. "(x-1)^2 + (y-2)^2 < 0.5^2"
+     * @return  False if the constraint uses something outside the supported grammar
+     */
+    bool compile(const std::string& constraint);
+
+    /**
+     * @brief   Returns true if a constraint has been compiled successfully
+     */
+    inline bool isValid() const { return !program_.empty(); }
+
+    /**
+     * @brief   Evaluates the constraint for n points
+     * @param   x       x values
+     * @param   y       y values
+     * @param   n       number of points
+     * @param   result  per point 1 if the constraint holds, 0 otherwise
+     */
+    void evaluate(const double* x, const double* y, unsigned int n, unsigned char* result);
+
+    /**
+     * @brief   Evaluates the constraint for n points on a line: (x0 + i * dx, y0 + i * dy), i = 0 .. n-1
+     */
+    void evaluateLine(double x0, double y0, double dx, double dy, unsigned int n, unsigned char* result);
+
+    /**
+     * @brief   Evaluates the constraint for a single point
+     */
+    bool evaluate(double x, double y);
+
+    /**
+     * @brief   Conservative bounding box of the points within a domain that may satisfy the constraint
+     *
+     * Branch and bound with interval arithmetic: boxes of the domain on which the constraint is
+     * false for certain are discarded, the others are split until they are smaller than resolution.
+     * Every point of the domain that satisfies the constraint lies within the returned box.
+     *
+     * @param   min_x, min_y, max_x, max_y  The domain
+     * @param   resolution  Size below which boxes are not split any further
+     * @param   bb_min_x, bb_min_y, bb_max_x, bb_max_y  The bounding box
+     * @return  False if no point of the domain can satisfy the constraint (bounding box is not set)
+     */
+    bool getBoundingBox(double min_x, double min_y, double max_x, double max_y, double resolution,
+                        double& bb_min_x, double& bb_min_y, double& bb_max_x, double& bb_max_y) const;
+
+    //! Value range of a (sub)expression over a box, used by the interval analysis
+    struct Interval;
+
+private:
+
+    enum OpCode
+    {
+        OP_CONST, OP_X, OP_Y,
+        OP_NEG, OP_ABS, OP_SQRT, OP_SIN, OP_COS, OP_TAN, OP_ASIN, OP_ACOS, OP_ATAN, OP_EXP, OP_LOG,
+        OP_FLOOR, OP_CEIL, OP_NOT, OP_IPOW,
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW, OP_ATAN2, OP_HYPOT, OP_MIN, OP_MAX,
+        OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+        OP_AND, OP_OR, OP_XOR, OP_NAND, OP_NOR, OP_XNOR
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        double value;   // constant for OP_CONST, exponent for OP_IPOW
+        Instruction(OpCode op_, double value_ = 0) : op(op_), value(value_) {}
+    };
+
+    static const unsigned int BATCH_SIZE = 256;
+
+    std::vector<Instruction> program_;
+    unsigned int stack_depth_;
+
+    // Evaluation registers, stack_depth_ x BATCH_SIZE values
+    std::vector<double> stack_;
+    std::vector<double> x_batch_, y_batch_;
+
+    void evaluateBatch(const double* x, const double* y, unsigned int n, unsigned char* result);
+
+    // Runs the program for at most BATCH_SIZE points, returns the register with the values
+    const double* run(const double* x, const double* y, unsigned int n);
+
+    // Evaluates the program over a box: -1 false for every point, 1 true for every point, 0 unknown
+    int evaluateBox(double min_x, double min_y, double max_x, double max_y, std::vector<Interval>& stack) const;
+
+    // Parser (precedence climbing with the exprtk precedence levels)
+    struct Token
+    {
+        enum Type { NUMBER, SYMBOL, OPERATOR, LBRACKET, RBRACKET, COMMA, END, INVALID } type;
+        std::string text;
+        double number;
+    };
+
+    std::vector<Token> tokens_;
+    unsigned int current_;
+
+    bool tokenize(const std::string& constraint);
+    bool parseExpression(int precedence);
+    bool parseBranch(int precedence);
+    bool parseSymbol();
+    bool binaryOperator(const Token& token, int& left, int& right, OpCode& op) const;
+
+    // Appends an instruction, folds constants and specialises constant integer powers
+    void emit(OpCode op);
+
+};
+
+}
+#endif
@@ -11,8 +11,15 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <costmap_2d/costmap_2d_ros.h>
 
+#include <algorithm>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
 #include "visualization.h"
 #include "global_planner_plugin.h"
+#include "plan_snapshot.h"
 
 //! Messages + Services
 #include <cb_planner_msgs_srvs/PositionConstraint.h>
@@ -20,6 +27,11 @@
 #include <cb_planner_msgs_srvs/LocalPlannerActionGoal.h>
 #include <cb_planner_msgs_srvs/CheckPlan.h>
 #include <cb_planner_msgs_srvs/GetPlan.h>
+#include <cb_base_navigation/CheckPlanBlocked.h>
+#include <cb_base_navigation/GetPlanAnytime.h>
+#include <cb_base_navigation/GetPlanCosts.h>
+#include <cb_base_navigation/GetPlans.h>
+#include <cb_base_navigation/PlanStatistics.h>
 
 namespace cb_global_planner {
 
@@ -30,32 +42,106 @@ public:
     GlobalPlannerInterface(costmap_2d::Costmap2DROS& costmap);
     ~GlobalPlannerInterface();
 
+    /**
+     * @brief Number of plan requests that can run at the same time (size of the planner pool), 1 if requests are serialised
+     */
+    unsigned int getConcurrentRequests() const { return std::max<unsigned int>(1, planner_pool_.size()); }
+
 private:
 
     //! Connections to the outside world
-    ros::ServiceServer get_plan_srv_, check_plan_srv_;
+    ros::ServiceServer get_plan_srv_, get_plan_anytime_srv_, get_plans_srv_, get_plan_costs_srv_, check_plan_srv_, check_plan_blocked_srv_;
     bool getPlan(GetPlanRequest& req, GetPlanResponse& resp);
+    bool getPlanAnytime(cb_base_navigation::GetPlanAnytime::Request& req, cb_base_navigation::GetPlanAnytime::Response& resp);
+    bool getPlans(cb_base_navigation::GetPlans::Request& req, cb_base_navigation::GetPlans::Response& resp);
+    bool getPlanCosts(cb_base_navigation::GetPlanCosts::Request& req, cb_base_navigation::GetPlanCosts::Response& resp);
     bool checkPlan(CheckPlanRequest& req, CheckPlanResponse& resp);
+    bool checkPlanBlocked(cb_base_navigation::CheckPlanBlocked::Request& req, cb_base_navigation::CheckPlanBlocked::Response& resp);
+
+    int findFirstBlockedPose(const std::vector<geometry_msgs::PoseStamped>& plan);
+
+    /**
+     * @brief getPlan, getPlanAnytime and the pose callback
+     * @param time_budget [s] for an anytime plan, negative for a plan with makePlan
+     * @param refine Orientation constraint to send the plan and the improvements of the background refinement to the
+     *        local planner with, NULL to send nothing and not refine
+     * @return False if the request could not be handled
+     */
+    bool planRequest(const std::vector<PositionConstraint>& position_constraints, double time_budget, const OrientationConstraint* refine,
+                     std::vector<geometry_msgs::PoseStamped>& plan, bool& succes, double& epsilon);
 
     //! Pose callback and publisher
     ros::Subscriber pose_sub_;
     void poseCallback(const geometry_msgs::PoseStampedConstPtr &pose);
     ros::Publisher plan_pub_;
 
+    //! Sends a plan to the local planner
+    void publishPlan(const std::vector<geometry_msgs::PoseStamped>& plan, const OrientationConstraint& orientation_constraint);
+
+    //! Stage timings of every getPlan, published only when subscribed
+    ros::Publisher statistics_pub_;
+
+    //! Snapshots of the getPlan requests that fail or take at least snapshot_min_planning_time_ [s]
+    bool record_snapshots_;
+    std::string snapshot_directory_;
+    double snapshot_min_planning_time_;
+
+    //! Anytime plans: the budget of get_plan_srv and the pose callback (anytime/time_budget, 0: makePlan), and the
+    //! refinement of the last anytime request in slices of anytime_refine_slice_ [s] for anytime_max_refine_time_ [s]
+    double anytime_time_budget_, anytime_refine_slice_, anytime_max_refine_time_;
+    boost::shared_ptr<boost::thread> refine_thread_;
+    boost::mutex refine_mutex_;             // guards refine_thread_ and refine_request_
+    unsigned int refine_request_;           // incremented by every plan request, a refinement stops once it is not its own
+
+    /**
+     * @brief Stops the refinement of an earlier request
+     * @return The request number of the caller, for startRefinement
+     */
+    unsigned int cancelRefinement();
+
+    //! Refines the plan of the planner in the background; in a pool the refinement releases the planner
+    void startRefinement(GlobalPlannerPlugin* planner, unsigned int request, const std::vector<geometry_msgs::PoseStamped>& plan,
+                         const OrientationConstraint& orientation_constraint, double epsilon);
+    void refinePlan(GlobalPlannerPlugin* planner, unsigned int request, std::vector<geometry_msgs::PoseStamped> plan,
+                    OrientationConstraint orientation_constraint, double epsilon);
+
+    //! One slice with the costmap locked, false when the refinement ends
+    bool refineSlice(GlobalPlannerPlugin* planner, unsigned int request, std::vector<geometry_msgs::PoseStamped>& plan, double& epsilon, bool& improved);
+
     //! Planners + loaders
     boost::shared_ptr<GlobalPlannerPlugin> global_planner_;
     pluginlib::ClassLoader<GlobalPlannerPlugin> gp_loader_;
 
+    //! Concurrent requests (concurrent_requests > 1): every getPlan takes a free instance of the pool and
+    //! checkPlan has an instance of its own, all of them only read the costmap
+    std::vector<boost::shared_ptr<GlobalPlannerPlugin> > planner_pool_;
+    std::vector<GlobalPlannerPlugin*> free_planners_;
+    boost::mutex pool_mutex_;
+    boost::condition_variable pool_condition_;
+    boost::shared_ptr<GlobalPlannerPlugin> check_planner_;
+    boost::mutex check_mutex_;
+
+    boost::shared_ptr<GlobalPlannerPlugin> createPlanner(const std::string& global_planner);
+    GlobalPlannerPlugin* acquirePlanner();
+    void releasePlanner(GlobalPlannerPlugin* planner);
+
+    //! Fills the snapshot (if not NULL) when the request is recorded, a negative time budget plans with makePlan
+    bool makePlan(GlobalPlannerPlugin* planner, const std::vector<PositionConstraint>& position_constraints, double time_budget,
+                  std::vector<geometry_msgs::PoseStamped>& plan, bool& succes, double& epsilon, cb_base_navigation::PlanStatistics& statistics,
+                  PlanSnapshot* snapshot);
+    bool makePlans(GlobalPlannerPlugin* planner, cb_base_navigation::GetPlans::Request& req, cb_base_navigation::GetPlans::Response& resp);
+    bool calculatePlanCosts(GlobalPlannerPlugin* planner, cb_base_navigation::GetPlanCosts::Request& req, cb_base_navigation::GetPlanCosts::Response& resp);
+
     //! Frame names + Tranforms
     std::string robot_base_frame_, global_frame_;
     tf::TransformListener* tf_;
-    tf::Stamped<tf::Pose> global_pose_;
 
     //! Costmaps
     costmap_2d::Costmap2DROS& costmap_;
 
-    //! Visualization
+    //! Visualization, guarded by vis_mutex_ for concurrent requests
     Visualization vis_;
+    boost::mutex vis_mutex_;
 
 };
 
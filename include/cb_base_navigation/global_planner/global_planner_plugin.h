@@ -11,6 +11,10 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <costmap_2d/costmap_2d_ros.h>
 #include <cb_planner_msgs_srvs/PositionConstraint.h>
+#include <cb_base_navigation/PlanStatistics.h>
+
+#include <math.h> // for hypot
+#include <vector>
 
 using namespace cb_planner_msgs_srvs;
 
@@ -30,6 +34,78 @@ namespace cb_global_planner {
        */
       virtual bool makePlan(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions) = 0;
 
+      /**
+       * @brief makePlan that spends at most time_budget [s] on the plan: a first plan with a cost of at most epsilon
+       *        times the optimal one, improved until the budget is used. Planners without an anytime search make
+       *        the optimal plan, whatever it takes.
+       * @param epsilon Bound of the cost of the plan relative to the optimal one, 1 for the optimal plan
+       */
+      virtual bool makePlanAnytime(const tf::Stamped<tf::Pose>& start, const PositionConstraint& position_constraint, double time_budget,
+                                   std::vector<geometry_msgs::PoseStamped>& plan, std::vector<tf::Point>& goal_positions, double& epsilon)
+      {
+          epsilon = 1;
+          return makePlan(start, position_constraint, plan, goal_positions);
+      }
+
+      /**
+       * @brief Continues the search of the last makePlanAnytime for at most time_budget [s], on the same costmap
+       * @param plan The improved plan, only changed if it improved
+       * @return False if the plan did not improve: no search finished in time, or canImprovePlan is false
+       */
+      virtual bool improvePlan(double time_budget, std::vector<geometry_msgs::PoseStamped>& plan, double& epsilon) { return false; }
+
+      /**
+       * @brief Whether improvePlan may still improve the plan of the last makePlanAnytime
+       */
+      virtual bool canImprovePlan() const { return false; }
+
+      /**
+       * @brief Computes a plan to each of several goal constraints, against the same costmap
+       * @param plans One plan per constraint, empty if there is none
+       * @param costs Cost of every plan, -1 if there is none; planners without costs of their own give the plan length [m]
+       * @param failed Per constraint 1 if it failed like a makePlan that returns false (no goal area), 0 otherwise
+       * @return False if no plans could be computed at all (e.g. not initialized), true otherwise
+       */
+      virtual bool makePlans(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                             std::vector<std::vector<geometry_msgs::PoseStamped> >& plans, std::vector<double>& costs, std::vector<unsigned char>& failed)
+      {
+          plans.assign(position_constraints.size(), std::vector<geometry_msgs::PoseStamped>());
+          costs.assign(position_constraints.size(), -1);
+          failed.assign(position_constraints.size(), 0);
+          for (unsigned int i = 0; i < position_constraints.size(); ++i) {
+              std::vector<tf::Point> goal_positions;
+              if (!makePlan(start, position_constraints[i], plans[i], goal_positions)) {
+                  failed[i] = 1;
+                  continue;
+              }
+              if (plans[i].empty()) continue;
+
+              costs[i] = getPlanLength(plans[i]);
+          }
+          return true;
+      }
+
+      /**
+       * @brief Cost and length of the plan to each of several goal constraints, without building the plans (poses,
+       *        visualization) where the planner can avoid it
+       * @param costs Cost of every plan as in makePlans, -1 if there is none
+       * @param lengths Length of every plan [m], -1 if there is none
+       * @param failed As in makePlans
+       * @return False if no costs could be computed at all (e.g. not initialized), true otherwise
+       */
+      virtual bool getPlanCosts(const tf::Stamped<tf::Pose>& start, const std::vector<PositionConstraint>& position_constraints,
+                                std::vector<double>& costs, std::vector<double>& lengths, std::vector<unsigned char>& failed)
+      {
+          std::vector<std::vector<geometry_msgs::PoseStamped> > plans;
+          if (!makePlans(start, position_constraints, plans, costs, failed)) return false;
+
+          lengths.assign(plans.size(), -1);
+          for (unsigned int i = 0; i < plans.size(); ++i) {
+              if (!plans[i].empty()) lengths[i] = getPlanLength(plans[i]);
+          }
+          return true;
+      }
+
       /**
        * @brief Checks if a plan is valid
        * @param plan The plan that needs to be checked
@@ -37,6 +113,15 @@ namespace cb_global_planner {
        */
       virtual bool checkPlan(const std::vector<geometry_msgs::PoseStamped>& plan) = 0;
 
+      /**
+       * @brief Index of the first blocked pose of a plan, so only the plan from there on needs to be replanned
+       * @return -1 if the plan is valid; planners that cannot tell where the plan is blocked return 0
+       */
+      virtual int findFirstBlockedPose(const std::vector<geometry_msgs::PoseStamped>& plan)
+      {
+          return checkPlan(plan) ? -1 : 0;
+      }
+
       /**
        * @brief  Initialization function for the BaseGlobalPlanner
        * @param  name The name of this planner
@@ -45,6 +130,36 @@ namespace cb_global_planner {
        */
       virtual void initialize(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* global_costmap_ros) = 0;
 
+      /**
+       * @brief Fills in the stages and counters of the last makePlan that the planner measures (entity queries,
+       *        constraint, searches, plan conversion); the interface measures the others
+       */
+      virtual void getStatistics(cb_base_navigation::PlanStatistics& statistics) const {}
+
+      /**
+       * @brief Pose of the constraint frame in the global frame that the last makePlan used (e.g. to record the request)
+       * @return False if it used none
+       */
+      virtual bool getConstraintFramePose(tf::Transform& pose) const { return false; }
+
+      /**
+       * @brief Whether instances of this planner may plan at the same time, each on its own instance, while the
+       *        costmap is only read (shared lock); a planner that shares state between its instances returns false
+       */
+      virtual bool supportsConcurrentRequests() const { return false; }
+
+      /**
+       * @brief Length of a plan [m]
+       */
+      static double getPlanLength(const std::vector<geometry_msgs::PoseStamped>& plan)
+      {
+          double length = 0;
+          for (unsigned int i = 1; i < plan.size(); ++i) {
+              length += hypot(plan[i].pose.position.x - plan[i-1].pose.position.x, plan[i].pose.position.y - plan[i-1].pose.position.y);
+          }
+          return length;
+      }
+
       /**
        * @brief  Virtual destructor for the interface
        */
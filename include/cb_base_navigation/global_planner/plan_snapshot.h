@@ -0,0 +1,90 @@
+#ifndef cb_global_planner_PLAN_SNAPSHOT_H_
+#define cb_global_planner_PLAN_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace cb_global_planner {
+
+/**
+ * @class PlanSnapshot
+ * @brief What makePlan saw for one plan request: the costmap cells and geometry, the robot pose, the constraint
+ *        and the pose of its frame. Written by the global planner interface, replayed by a_star_planner_benchmark.
+ *
+ * The file is a fixed header, the strings and the row-major char map at a 64 byte aligned offset, all in host
+ * byte order. A mapped snapshot is not read into memory: getCostmap() points into the file mapping, so it can be
+ * given to AStarPlanner::setCostmap as it is.
+ */
+class PlanSnapshot {
+
+public:
+
+    //! Fixed part of the file header
+    struct Info {
+        uint32_t width, height;
+        double resolution, origin_x, origin_y;  // [m]
+        double robot_x, robot_y, robot_yaw;     // in the global frame
+        double frame_x, frame_y, frame_yaw;     // pose of the constraint frame in the global frame
+        uint32_t has_frame_pose;                // 0 if no frame pose was used, e.g. the request failed before
+        uint32_t succes;
+        double stamp;                           // of the request [s]
+        double planning_time;                   // of makePlan [s]
+        uint32_t plan_size;                     // poses
+    };
+
+    Info info;
+    std::string global_frame, constraint_frame, constraint;
+
+    PlanSnapshot();
+
+    ~PlanSnapshot();
+
+    /**
+     * @brief Copies the char map of info.width x info.height cells into the snapshot
+     */
+    void copyCostmap(const unsigned char* costmap);
+
+    /**
+     * @brief Row-major char map of the snapshot, in the file mapping for a mapped snapshot; NULL if there is none
+     */
+    const unsigned char* getCostmap() const;
+
+    bool write(const std::string& filename) const;
+
+    /**
+     * @brief Maps a snapshot file read-only, the costmap of the snapshot stays in the mapping
+     */
+    bool map(const std::string& filename);
+
+private:
+
+    static const uint32_t VERSION = 1;
+    static const uint32_t ALIGNMENT = 64;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;   // sizeof(FileHeader) of the writer
+        uint64_t costmap_offset;
+        uint32_t global_frame_size, constraint_frame_size, constraint_size;
+        Info info;
+    };
+
+    std::vector<unsigned char> costmap_;    // copied costmap
+    void* mapping_;                         // mapped file, NULL if not mapped
+    size_t mapping_size_;
+    const unsigned char* mapped_costmap_;
+
+    void unmap();
+
+    // not copyable, a copy would unmap the file of the other
+    PlanSnapshot(const PlanSnapshot&);
+    PlanSnapshot& operator=(const PlanSnapshot&);
+
+};
+
+}
+
+#endif /* PLAN_SNAPSHOT_H_ */
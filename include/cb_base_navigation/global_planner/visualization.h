@@ -12,12 +12,18 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <tf/transform_datatypes.h>
 
+#include <vector>
+
 namespace cb_global_planner
 {
 
 /**
  * @class Class with visualization functions for the global planner interface.
  * @brief Implements some visualziation functions (ROS vis messages)
+ *
+ * Nothing is published on topics without subscribers. In compact mode (visualization/compact) the plan arrows are
+ * at least arrow_spacing apart and all lists stop at a fixed number of markers or points; the arrows of the previous
+ * plan are cleared with one DELETEALL marker in the same message.
  */
 class Visualization
 {
@@ -52,6 +58,13 @@ public:
 private:
     ros::Publisher global_plan_marker_array_pub_, global_plan_marker_pub_, goal_positions_marker_pub_;
 
+    //! Compact mode
+    bool compact_;
+    double arrow_spacing_;      // [m]
+    int max_arrows_, max_points_;
+
+    unsigned int num_arrows_;   // of the last published plan, deleted one by one if not compact
+
 };
 
 }
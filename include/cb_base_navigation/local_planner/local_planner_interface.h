@@ -15,6 +15,7 @@
 
 #include <cb_planner_msgs_srvs/LocalPlannerAction.h>
 #include "visualization.h"
+#include "cb_base_navigation/entity_pose_cache.h"
 
 #include <actionlib/client/action_client.h>
 
@@ -41,6 +42,19 @@ private:
     void controllerThread();
     void doSomeMotionPlanning();
 
+    //! Pipelined mode: the costmap is updated and published by threads of their own, at their own rates
+    bool pipelined_;
+    double costmap_update_frequency_, costmap_publish_frequency_;
+    double costmap_max_age_;                // [s] older costmaps stop the robot
+    boost::shared_mutex costmap_mtx_;       // unique while the costmap is updated, shared while it is used
+    ros::Time costmap_stamp_;               // of the last update, guarded by costmap_mtx_
+    boost::thread* costmap_update_thread_;
+    boost::thread* costmap_publish_thread_;
+
+    void costmapUpdateThread();
+    void costmapPublishThread();
+    bool isCostmapCurrent();
+
     inline bool isGoalSet() { return goal_.plan.size() > 0; }
 
     //! ROS Communication
@@ -51,8 +65,8 @@ private:
     //! topic goal cb
     void topicGoalCallback(const LocalPlannerActionGoalConstPtr &goal);
 
-    //! World model client
-    ros::ServiceClient ed_client_;
+    //! World model entity poses, polled in the background so the control loop never waits for ED
+    cb_base_navigation::EntityPoseCache* entity_poses_;
 
     //! Action Server stuff
     void actionServerSetPlan();
@@ -73,8 +87,14 @@ private:
     //! Costmaps
     costmap_2d::Costmap2DROS* costmap_;
 
+    //! Plan progress: the cursor only moves forward, plan_distances_[i] is the arc length up to pose i
+    unsigned int plan_index_;
+    std::vector<double> plan_distances_;
+    void resetPlanProgress();
+    void updatePlanProgress();
+
     //! Helper functions
-    bool updateEndGoalOrientation();
+    bool updateEndGoalOrientation(bool wait_for_frame = false);
 
     //! Visualization
     Visualization vis;
@@ -0,0 +1,236 @@
+#include <pluginlib/class_list_macros.h>
+#include "cb_base_navigation/costmap_layers/clearance_layer.h"
+
+#include <costmap_2d/cost_values.h>
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <math.h> // for sqrt, ceil
+
+PLUGINLIB_EXPORT_CLASS(cb_base_navigation::ClearanceLayer, costmap_2d::Layer)
+
+namespace cb_base_navigation
+{
+
+namespace
+{
+
+// Squared distance of the cells without a lethal cell in the window
+const float FAR = 1e20f;
+
+// Lower envelope of the parabolas over f: d[q] = min_p (q - p)^2 + f[p]
+void transform1D(const float* f, int n, float* d, int* v, float* z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -FAR;
+    z[1] = FAR;
+    for (int q = 1; q < n; ++q)
+    {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k])
+        {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FAR;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q)
+    {
+        while (z[k + 1] < q) ++k;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+FootprintCover::FootprintCover(const std::vector<geometry_msgs::Point>& footprint, double max_overshoot) : radius_(0)
+{
+    if (footprint.empty())
+    {
+        Circle c = { 0, 0, 0 };
+        circles_.push_back(c);
+        return;
+    }
+
+    double min_x = footprint[0].x, max_x = footprint[0].x, min_y = footprint[0].y, max_y = footprint[0].y;
+    for (unsigned int i = 1; i < footprint.size(); ++i)
+    {
+        min_x = std::min(min_x, footprint[i].x);
+        max_x = std::max(max_x, footprint[i].x);
+        min_y = std::min(min_y, footprint[i].y);
+        max_y = std::max(max_y, footprint[i].y);
+    }
+
+    // Slabs across the longest side: a circle through the corners of a slab of length l reaches
+    // sqrt((l/2)^2 + (w/2)^2) - w/2 outside the box
+    bool along_x = (max_x - min_x) >= (max_y - min_y);
+    double length = along_x ? max_x - min_x : max_y - min_y;
+    double width = along_x ? max_y - min_y : max_x - min_x;
+    double m = std::max(1e-3, max_overshoot);
+    unsigned int n = std::max(1, (int) ceil(length / (2 * sqrt(m * (width + m)))));
+
+    double l = length / n;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        Circle c;
+        c.x = along_x ? min_x + (i + 0.5) * l : (min_x + max_x) / 2;
+        c.y = along_x ? (min_y + max_y) / 2 : min_y + (i + 0.5) * l;
+        c.radius = sqrt(l * l / 4 + width * width / 4);
+        circles_.push_back(c);
+        radius_ = std::max(radius_, sqrt(c.x * c.x + c.y * c.y) + c.radius);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void ClearanceLayer::onInitialize()
+{
+    ros::NodeHandle nh("~/" + name_);
+    nh.param("max_distance", max_distance_, 1.0);
+    current_ = true;
+    matchSize();
+}
+
+void ClearanceLayer::matchSize()
+{
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+
+    costmap_2d::Costmap2D* master = layered_costmap_->getCostmap();
+    size_x_ = master->getSizeInCellsX();
+    size_y_ = master->getSizeInCellsY();
+    resolution_ = master->getResolution();
+    origin_x_ = master->getOriginX();
+    origin_y_ = master->getOriginY();
+    distances_.assign(size_x_ * size_y_, max_distance_);
+    needs_full_update_ = true;
+}
+
+void ClearanceLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j)
+{
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+
+    cells_updated_ = 0;
+
+    // A rolling window moves the origin without a resize
+    if (master_grid.getSizeInCellsX() != size_x_ || master_grid.getSizeInCellsY() != size_y_ || master_grid.getResolution() != resolution_
+            || master_grid.getOriginX() != origin_x_ || master_grid.getOriginY() != origin_y_)
+    {
+        size_x_ = master_grid.getSizeInCellsX();
+        size_y_ = master_grid.getSizeInCellsY();
+        resolution_ = master_grid.getResolution();
+        origin_x_ = master_grid.getOriginX();
+        origin_y_ = master_grid.getOriginY();
+        distances_.assign(size_x_ * size_y_, max_distance_);
+        needs_full_update_ = true;
+    }
+
+    if (needs_full_update_)
+    {
+        min_i = 0; min_j = 0;
+        max_i = size_x_; max_j = size_y_;
+        needs_full_update_ = false;
+    }
+    if (min_i >= max_i || min_j >= max_j) return;
+
+    // Cells within max_distance of the changed cells get new distances, from the lethal cells within max_distance of those
+    int c = (int) ceil(max_distance_ / resolution_);
+    int out_x0 = std::max(0, min_i - c), out_y0 = std::max(0, min_j - c);
+    int out_x1 = std::min((int) size_x_, max_i + c), out_y1 = std::min((int) size_y_, max_j + c);
+    int in_x0 = std::max(0, min_i - 2 * c), in_y0 = std::max(0, min_j - 2 * c);
+    int in_x1 = std::min((int) size_x_, max_i + 2 * c), in_y1 = std::min((int) size_y_, max_j + 2 * c);
+
+    int w = in_x1 - in_x0, h = in_y1 - in_y0;
+    std::vector<float> f(w * h);
+    const unsigned char* master = master_grid.getCharMap();
+    for (int y = 0; y < h; ++y)
+    {
+        const unsigned char* row = &master[(in_y0 + y) * size_x_ + in_x0];
+        for (int x = 0; x < w; ++x) f[y * w + x] = (row[x] == costmap_2d::LETHAL_OBSTACLE) ? 0 : FAR;
+    }
+
+    distanceTransform(f, w, h);
+
+    for (int y = out_y0; y < out_y1; ++y)
+    {
+        for (int x = out_x0; x < out_x1; ++x)
+        {
+            double d = sqrt(f[(y - in_y0) * w + x - in_x0]) * resolution_;
+            distances_[y * size_x_ + x] = std::min(d, max_distance_);
+        }
+    }
+    cells_updated_ = (out_x1 - out_x0) * (out_y1 - out_y0);
+}
+
+void ClearanceLayer::distanceTransform(std::vector<float>& f, int width, int height)
+{
+    int n = std::max(width, height);
+    std::vector<float> line(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+
+    // columns, then rows
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y) line[y] = f[y * width + x];
+        transform1D(&line[0], height, &d[0], &v[0], &z[0]);
+        for (int y = 0; y < height; ++y) f[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; ++y)
+    {
+        transform1D(&f[y * width], width, &d[0], &v[0], &z[0]);
+        std::copy(d.begin(), d.begin() + width, f.begin() + y * width);
+    }
+}
+
+double ClearanceLayer::getClearanceLocked(double wx, double wy) const
+{
+    double mx = (wx - origin_x_) / resolution_, my = (wy - origin_y_) / resolution_;
+    if (mx < 0 || my < 0 || mx >= size_x_ || my >= size_y_) return max_distance_;
+    return distances_[(int) my * size_x_ + (int) mx];
+}
+
+double ClearanceLayer::getClearance(double wx, double wy) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(mutex_);
+    return getClearanceLocked(wx, wy);
+}
+
+bool ClearanceLayer::isFootprintFree(const FootprintCover& cover, double x, double y, double yaw) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(mutex_);
+
+    // Distances are between cell centres, like those of the inflation layer
+    double c = cos(yaw), s = sin(yaw);
+    const std::vector<FootprintCover::Circle>& circles = cover.getCircles();
+    for (std::vector<FootprintCover::Circle>::const_iterator it = circles.begin(); it != circles.end(); ++it)
+    {
+        double clearance = getClearanceLocked(x + c * it->x - s * it->y, y + s * it->x + c * it->y);
+        if (clearance <= it->radius) return false;
+    }
+    return true;
+}
+
+double ClearanceLayer::getMaxDistance() const
+{
+    return max_distance_;
+}
+
+const ClearanceLayer* ClearanceLayer::find(costmap_2d::LayeredCostmap* layered_costmap)
+{
+    std::vector<boost::shared_ptr<costmap_2d::Layer> >* layers = layered_costmap->getPlugins();
+    for (std::vector<boost::shared_ptr<costmap_2d::Layer> >::iterator it = layers->begin(); it != layers->end(); ++it)
+    {
+        const ClearanceLayer* layer = dynamic_cast<const ClearanceLayer*>(it->get());
+        if (layer) return layer;
+    }
+    return NULL;
+}
+
+}
@@ -0,0 +1,136 @@
+#include "cb_base_navigation/entity_pose_cache.h"
+
+// Querying world model (ED)
+#include <ed_msgs/SimpleQuery.h>
+
+#include <vector>
+
+namespace cb_base_navigation {
+
+EntityPoseCache::EntityPoseCache(double poll_frequency, double max_age, double forget_after) :
+    poll_frequency_(poll_frequency > 0 ? poll_frequency : 10.0),
+    max_age_(max_age),
+    forget_after_(forget_after)
+{
+    if (max_age_ <= 1.0 / poll_frequency_)
+        ROS_WARN("[Entity poses] The maximum pose age (%.3f s) is not above the poll period (%.3f s), lookups will often miss.",
+                 max_age_, 1.0 / poll_frequency_);
+
+    ros::NodeHandle n;
+    ed_client_ = n.serviceClient<ed_msgs::SimpleQuery>("ed/simple_query");
+    ed_wait_client_ = n.serviceClient<ed_msgs::SimpleQuery>("ed/simple_query");
+
+    poll_thread_ = boost::thread(boost::bind(&EntityPoseCache::pollThread, this));
+}
+
+EntityPoseCache::~EntityPoseCache()
+{
+    poll_thread_.interrupt();
+    poll_thread_.join();
+}
+
+bool EntityPoseCache::getPose(const std::string& id, tf::Transform& pose, bool wait)
+{
+    if (id == "map" || id == "/map")
+    {
+        pose = tf::Transform::getIdentity();
+        return true;
+    }
+
+    ros::Time now = ros::Time::now();
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        Entry& entry = entries_[id]; // from now on the entity is polled
+        entry.last_request = now;
+        if (!entry.stamp.isZero() && (now - entry.stamp).toSec() <= max_age_)
+        {
+            pose = entry.pose;
+            return true;
+        }
+    }
+
+    if (!wait)
+        return false;
+
+    boost::mutex::scoped_lock lock(wait_mutex_);
+    if (!query(ed_wait_client_, id, pose))
+        return false;
+    store(id, pose, now);
+    return true;
+}
+
+void EntityPoseCache::pollThread()
+{
+    std::vector<std::string> ids;
+
+    try
+    {
+        while (ros::ok())
+        {
+            boost::this_thread::sleep(boost::posix_time::microseconds((long) (1e6 / poll_frequency_)));
+
+            ros::Time now = ros::Time::now();
+
+            // Forget the entities nobody asks for anymore, poll the others without holding the lock
+            ids.clear();
+            {
+                boost::mutex::scoped_lock lock(mutex_);
+                for (std::map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); )
+                {
+                    if ((now - it->second.last_request).toSec() > forget_after_)
+                        entries_.erase(it++);
+                    else
+                        ids.push_back((it++)->first);
+                }
+            }
+
+            for (unsigned int i = 0; i < ids.size(); ++i)
+            {
+                boost::this_thread::interruption_point();
+
+                ros::Time stamp = ros::Time::now();
+                tf::Transform pose;
+                if (query(ed_client_, ids[i], pose))
+                    store(ids[i], pose, stamp);
+            }
+        }
+    }
+    catch (const boost::thread_interrupted&)
+    {
+    }
+}
+
+bool EntityPoseCache::query(ros::ServiceClient& client, const std::string& id, tf::Transform& pose) const
+{
+    ed_msgs::SimpleQuery ed_query;
+    ed_query.request.id = id;
+
+    if (!client.call(ed_query))
+    {
+        ROS_ERROR_STREAM_THROTTLE(1.0, "[Entity poses] Failed to get pose for entity '" << id << "': ED could not be queried.");
+        return false;
+    }
+
+    if (ed_query.response.entities.empty())
+    {
+        ROS_ERROR_STREAM_THROTTLE(1.0, "[Entity poses] Failed to get pose for entity '" << id << "': ED returns 'no such entity'.");
+        return false;
+    }
+
+    tf::poseMsgToTF(ed_query.response.entities.front().pose, pose);
+    return true;
+}
+
+void EntityPoseCache::store(const std::string& id, const tf::Transform& pose, const ros::Time& stamp)
+{
+    boost::mutex::scoped_lock lock(mutex_);
+
+    std::map<std::string, Entry>::iterator it = entries_.find(id);
+    if (it == entries_.end() || it->second.stamp > stamp)
+        return; // forgotten meanwhile, or a newer pose is already there
+
+    it->second.pose = pose;
+    it->second.stamp = stamp;
+}
+
+}
@@ -14,8 +14,13 @@ int main(int argc, char** argv){
     // Create planner interface
     cb_global_planner::GlobalPlannerInterface gpi(costmap);
 
-    // Spin :)
-    ros::spin();
+    // Spin :) A thread more than concurrent plan requests, so a check is never queued behind the searches
+    if (gpi.getConcurrentRequests() > 1) {
+        ros::MultiThreadedSpinner spinner(gpi.getConcurrentRequests() + 1);
+        spinner.spin();
+    } else {
+        ros::spin();
+    }
 
     return(0);
 }
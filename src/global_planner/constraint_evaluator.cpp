@@ -2,7 +2,7 @@
 
 namespace cb_global_planner {
 
-ConstraintEvaluator::ConstraintEvaluator() {}
+ConstraintEvaluator::ConstraintEvaluator() : initialized_(false) {}
 
 bool ConstraintEvaluator::init(const std::string& constraint)
 {
@@ -20,13 +20,87 @@ bool ConstraintEvaluator::init(const std::string& constraint)
 
     constraint_ = constraint;
     initialized_ = true;
+
+    // Constraints outside the grammar of the ConstraintProgram stay with exprtk
+    if (program_.compile(constraint) && !validateProgram()) {
+        printf("Warning: batched evaluation disagrees with exprtk, using exprtk. Expression: %s\n", constraint.c_str());
+        program_ = ConstraintProgram();
+    }
+
+    return true;
+}
+
+bool ConstraintEvaluator::initCopy(const ConstraintEvaluator& other)
+{
+    if (!other.initialized_) return false;
+    if (!other.program_.isValid()) return init(other.constraint_);
+
+    // the exprtk expression is bound to the members of other, it is not needed for a validated program
+    program_ = other.program_;
+    constraint_ = other.constraint_;
+    initialized_ = true;
     return true;
 }
 
 bool ConstraintEvaluator::evaluate(const double& x, const double& y) {
     if (!initialized_) return false;
+    if (program_.isValid()) return program_.evaluate(x, y);
     x_ = x; y_ = y;
     return expression_.value();
 }
 
+void ConstraintEvaluator::evaluateLine(double x0, double y0, double dx, double dy, unsigned int n, unsigned char* result) {
+    if (program_.isValid()) {
+        program_.evaluateLine(x0, y0, dx, dy, n, result);
+        return;
+    }
+
+    for (unsigned int i = 0; i < n; ++i) {
+        result[i] = evaluate(x0 + i * dx, y0 + i * dy);
+    }
+}
+
+bool ConstraintEvaluator::getBoundingBox(double min_x, double min_y, double max_x, double max_y, double resolution,
+                                         double& bb_min_x, double& bb_min_y, double& bb_max_x, double& bb_max_y) const {
+    if (!program_.isValid()) return false;
+
+    if (!program_.getBoundingBox(min_x, min_y, max_x, max_y, resolution, bb_min_x, bb_min_y, bb_max_x, bb_max_y)) {
+        // nothing satisfies the constraint: empty box
+        bb_min_x = bb_min_y = 1;
+        bb_max_x = bb_max_y = 0;
+    }
+    return true;
+}
+
+bool ConstraintEvaluator::validateProgram() {
+    // Compare both on grids around the origin at room and building scale
+    static const double scales[] = { 0.25, 4.0 };
+    static const int N = 16;
+
+    std::vector<unsigned char> batched(2 * N + 1);
+    for (unsigned int s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s) {
+        for (int j = -N; j <= N; ++j) {
+            double y = j * scales[s];
+            program_.evaluateLine(-N * scales[s], y, scales[s], 0, 2 * N + 1, &batched[0]);
+            for (int i = -N; i <= N; ++i) {
+                x_ = i * scales[s]; y_ = y;
+                if ((bool) batched[i + N] != (bool) expression_.value()) return false;
+            }
+        }
+    }
+
+    // and on values where a tolerance or rounding would differ: near-equal, huge, tiny and infinite coordinates
+    static const double special[] = { 0.0, 1e-300, 1e-12, 0.3, 0.1 + 0.2, 1.0, 1.0 + 1e-12, 1e300, HUGE_VAL, -1e-12, -0.3, -1.0, -1e300, -HUGE_VAL };
+    static const unsigned int S = sizeof(special) / sizeof(special[0]);
+    for (unsigned int j = 0; j < S; ++j) {
+        for (unsigned int i = 0; i < S; ++i) {
+            unsigned char result;
+            program_.evaluateLine(special[i], special[j], 0, 0, 1, &result);
+            x_ = special[i]; y_ = special[j];
+            if ((bool) result != (bool) expression_.value()) return false;
+        }
+    }
+    return true;
+}
+
 }
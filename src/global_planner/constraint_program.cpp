@@ -0,0 +1,719 @@
+#include "cb_base_navigation/global_planner/constraint_program.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+namespace cb_global_planner {
+
+namespace {
+
+// exprtk precedence levels, see exprtk::parser::parse_expression
+enum Level
+{
+    LEVEL00 = 0, LEVEL01, LEVEL02, LEVEL03, LEVEL04, LEVEL05, LEVEL06, LEVEL07,
+    LEVEL08, LEVEL09, LEVEL10, LEVEL11, LEVEL12, LEVEL13
+};
+
+inline double boolean(bool b) { return b ? 1.0 : 0.0; }
+
+// exprtk's fast_exp: integer powers by multiplication, in the same order as exprtk
+inline double integerPower(double v, unsigned int n)
+{
+    switch (n)
+    {
+    case 0: return 1;
+    case 1: return v;
+    case 2: return v * v;
+    case 3: return v * v * v;
+    case 4: { double v2 = v * v; return v2 * v2; }
+    case 5: { double v2 = v * v; return (v2 * v2) * v; }
+    case 6: { double v3 = v * v * v; return v3 * v3; }
+    case 7: { double v3 = v * v * v; return (v3 * v3) * v; }
+    case 8: { double v2 = v * v; double v4 = v2 * v2; return v4 * v4; }
+    case 9: { double v2 = v * v; double v4 = v2 * v2; return (v4 * v4) * v; }
+    case 10: { double v2 = v * v; double v5 = (v2 * v2) * v; return v5 * v5; }
+    default:
+        double l = 1;
+        while (n)
+        {
+            if (n & 1) { l *= v; --n; }
+            v *= v;
+            n >>= 1;
+        }
+        return l;
+    }
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+ConstraintProgram::ConstraintProgram() : stack_depth_(0), current_(0) {}
+
+bool ConstraintProgram::compile(const std::string& constraint)
+{
+    program_.clear();
+    stack_depth_ = 0;
+
+    current_ = 0;
+    if (!tokenize(constraint) || !parseExpression(LEVEL00) || tokens_[current_].type != Token::END)
+    {
+        program_.clear();
+        tokens_.clear();
+        return false;
+    }
+    tokens_.clear();
+
+    // Stack depth of the program
+    int depth = 0;
+    for (unsigned int i = 0; i < program_.size(); ++i)
+    {
+        OpCode op = program_[i].op;
+        if (op <= OP_Y) ++depth;
+        else if (op >= OP_ADD) --depth;
+        stack_depth_ = std::max(stack_depth_, (unsigned int) depth);
+    }
+
+    stack_.resize(stack_depth_ * BATCH_SIZE);
+    x_batch_.resize(BATCH_SIZE);
+    y_batch_.resize(BATCH_SIZE);
+
+    return true;
+}
+
+void ConstraintProgram::evaluate(const double* x, const double* y, unsigned int n, unsigned char* result)
+{
+    for (unsigned int i = 0; i < n; i += BATCH_SIZE)
+        evaluateBatch(x + i, y + i, std::min(BATCH_SIZE, n - i), result + i);
+}
+
+void ConstraintProgram::evaluateLine(double x0, double y0, double dx, double dy, unsigned int n, unsigned char* result)
+{
+    for (unsigned int i = 0; i < n; i += BATCH_SIZE)
+    {
+        unsigned int m = std::min(BATCH_SIZE, n - i);
+        for (unsigned int j = 0; j < m; ++j)
+        {
+            x_batch_[j] = x0 + (i + j) * dx;
+            y_batch_[j] = y0 + (i + j) * dy;
+        }
+        evaluateBatch(&x_batch_[0], &y_batch_[0], m, result + i);
+    }
+}
+
+bool ConstraintProgram::evaluate(double x, double y)
+{
+    unsigned char result;
+    evaluateBatch(&x, &y, 1, &result);
+    return result;
+}
+
+void ConstraintProgram::evaluateBatch(const double* x, const double* y, unsigned int n, unsigned char* result)
+{
+    if (program_.empty())
+    {
+        std::fill(result, result + n, 0);
+        return;
+    }
+
+    // Like the cast of expression::value() to bool: everything but 0 holds (including NaN)
+    const double* value = run(x, y, n);
+    for (unsigned int i = 0; i < n; ++i) result[i] = (value[i] != 0);
+}
+
+const double* ConstraintProgram::run(const double* x, const double* y, unsigned int n)
+{
+    // Every register holds BATCH_SIZE values; a is the top of the stack, b the one below
+    double* top = &stack_[0] - BATCH_SIZE;
+
+    for (std::vector<Instruction>::const_iterator it = program_.begin(); it != program_.end(); ++it)
+    {
+        const OpCode op = it->op;
+
+        if (op <= OP_Y)
+        {
+            top += BATCH_SIZE;
+            if (op == OP_CONST) std::fill(top, top + n, it->value);
+            else std::copy(op == OP_X ? x : y, (op == OP_X ? x : y) + n, top);
+            continue;
+        }
+
+        double* a = top;
+        if (op < OP_ADD)
+        {
+            switch (op)
+            {
+            case OP_NEG:   for (unsigned int i = 0; i < n; ++i) a[i] = -a[i]; break;
+            case OP_ABS:   for (unsigned int i = 0; i < n; ++i) a[i] = fabs(a[i]); break;
+            case OP_SQRT:  for (unsigned int i = 0; i < n; ++i) a[i] = sqrt(a[i]); break;
+            case OP_SIN:   for (unsigned int i = 0; i < n; ++i) a[i] = sin(a[i]); break;
+            case OP_COS:   for (unsigned int i = 0; i < n; ++i) a[i] = cos(a[i]); break;
+            case OP_TAN:   for (unsigned int i = 0; i < n; ++i) a[i] = tan(a[i]); break;
+            case OP_ASIN:  for (unsigned int i = 0; i < n; ++i) a[i] = asin(a[i]); break;
+            case OP_ACOS:  for (unsigned int i = 0; i < n; ++i) a[i] = acos(a[i]); break;
+            case OP_ATAN:  for (unsigned int i = 0; i < n; ++i) a[i] = atan(a[i]); break;
+            case OP_EXP:   for (unsigned int i = 0; i < n; ++i) a[i] = exp(a[i]); break;
+            case OP_LOG:   for (unsigned int i = 0; i < n; ++i) a[i] = log(a[i]); break;
+            case OP_FLOOR: for (unsigned int i = 0; i < n; ++i) a[i] = floor(a[i]); break;
+            case OP_CEIL:  for (unsigned int i = 0; i < n; ++i) a[i] = ceil(a[i]); break;
+            case OP_NOT:   for (unsigned int i = 0; i < n; ++i) a[i] = boolean(a[i] == 0); break;
+            case OP_IPOW:
+            {
+                unsigned int p = (unsigned int) fabs(it->value);
+                if (p == 2 && it->value > 0)
+                    for (unsigned int i = 0; i < n; ++i) a[i] = a[i] * a[i];
+                else if (it->value > 0)
+                    for (unsigned int i = 0; i < n; ++i) a[i] = integerPower(a[i], p);
+                else
+                    for (unsigned int i = 0; i < n; ++i) a[i] = 1.0 / integerPower(a[i], p);
+                break;
+            }
+            default: break;
+            }
+            continue;
+        }
+
+        // binary: b = b op a
+        top -= BATCH_SIZE;
+        double* b = top;
+        switch (op)
+        {
+        case OP_ADD:   for (unsigned int i = 0; i < n; ++i) b[i] = b[i] + a[i]; break;
+        case OP_SUB:   for (unsigned int i = 0; i < n; ++i) b[i] = b[i] - a[i]; break;
+        case OP_MUL:   for (unsigned int i = 0; i < n; ++i) b[i] = b[i] * a[i]; break;
+        case OP_DIV:   for (unsigned int i = 0; i < n; ++i) b[i] = b[i] / a[i]; break;
+        case OP_MOD:   for (unsigned int i = 0; i < n; ++i) b[i] = fmod(b[i], a[i]); break;
+        case OP_POW:   for (unsigned int i = 0; i < n; ++i) b[i] = pow(b[i], a[i]); break;
+        case OP_ATAN2: for (unsigned int i = 0; i < n; ++i) b[i] = atan2(b[i], a[i]); break;
+        case OP_HYPOT: for (unsigned int i = 0; i < n; ++i) b[i] = sqrt(b[i] * b[i] + a[i] * a[i]); break;
+        case OP_MIN:   for (unsigned int i = 0; i < n; ++i) b[i] = std::min(b[i], a[i]); break;
+        case OP_MAX:   for (unsigned int i = 0; i < n; ++i) b[i] = std::max(b[i], a[i]); break;
+        case OP_LT:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] < a[i]); break;
+        case OP_LE:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] <= a[i]); break;
+        case OP_GT:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] > a[i]); break;
+        case OP_GE:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] >= a[i]); break;
+        case OP_EQ:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] == a[i]); break;
+        case OP_NE:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] != a[i]); break;
+        case OP_AND:   for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] != 0 && a[i] != 0); break;
+        case OP_OR:    for (unsigned int i = 0; i < n; ++i) b[i] = boolean(b[i] != 0 || a[i] != 0); break;
+        case OP_XOR:   for (unsigned int i = 0; i < n; ++i) b[i] = boolean((b[i] != 0) != (a[i] != 0)); break;
+        case OP_NAND:  for (unsigned int i = 0; i < n; ++i) b[i] = boolean(!(b[i] != 0 && a[i] != 0)); break;
+        case OP_NOR:   for (unsigned int i = 0; i < n; ++i) b[i] = boolean(!(b[i] != 0 || a[i] != 0)); break;
+        case OP_XNOR:  for (unsigned int i = 0; i < n; ++i) b[i] = boolean((b[i] != 0) == (a[i] != 0)); break;
+        default: break;
+        }
+    }
+
+    return top;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Interval analysis
+
+struct ConstraintProgram::Interval
+{
+    double lo, hi;
+    bool nan;   // some point of the box may give NaN
+
+    Interval() : lo(0), hi(0), nan(false) {}
+    Interval(double lo_, double hi_, bool nan_ = false) : lo(lo_), hi(hi_), nan(nan_) {}
+
+    static Interval all() { return Interval(-HUGE_VAL, HUGE_VAL, true); }
+
+    // Truth value as interval: [0,0] false, [1,1] true, [0,1] unknown
+    static Interval truth(int t) { return t < 0 ? Interval(0, 0) : t > 0 ? Interval(1, 1) : Interval(0, 1); }
+
+    // -1 zero for every point, 1 non-zero (or NaN, which counts as true) for every point, 0 unknown
+    int isTrue() const
+    {
+        if (lo > 0 || hi < 0) return 1;
+        if (lo == 0 && hi == 0 && !nan) return -1;
+        return 0;
+    }
+};
+
+namespace {
+
+typedef ConstraintProgram::Interval Interval;
+
+// An interval with NaN bounds (inf - inf, 0 * inf, ...) can be anything
+inline Interval make(double lo, double hi, bool nan)
+{
+    if (lo != lo || hi != hi) return Interval::all();
+    return Interval(lo, hi, nan);
+}
+
+inline Interval hull4(double a, double b, double c, double d, bool nan)
+{
+    if (a != a || b != b || c != c || d != d) return Interval::all();
+    return Interval(std::min(std::min(a, b), std::min(c, d)), std::max(std::max(a, b), std::max(c, d)), nan);
+}
+
+inline Interval integerPower(const Interval& a, double exponent)
+{
+    unsigned int p = (unsigned int) fabs(exponent);
+    double l = integerPower(a.lo, p), h = integerPower(a.hi, p);
+
+    Interval r;
+    if (p % 2 == 1 || a.lo >= 0) r = make(std::min(l, h), std::max(l, h), a.nan);
+    else if (a.hi <= 0) r = make(std::min(l, h), std::max(l, h), a.nan);
+    else r = make(0, std::max(l, h), a.nan);
+
+    if (exponent >= 0) return r;
+
+    // reciprocal
+    if (r.lo > 0 || r.hi < 0) return make(1.0 / r.hi, 1.0 / r.lo, r.nan);
+    if (r.lo == 0 && r.hi == 0) return Interval::all();
+    if (r.lo >= 0) return Interval(1.0 / r.hi, HUGE_VAL, r.nan);
+    return Interval::all();
+}
+
+// Monotone increasing function, NaN outside [domain_lo, domain_hi]
+inline Interval increasing(const Interval& a, double (*f)(double), double domain_lo = -HUGE_VAL, double domain_hi = HUGE_VAL)
+{
+    bool nan = a.nan || a.lo < domain_lo || a.hi > domain_hi;
+    double lo = std::max(a.lo, domain_lo), hi = std::min(a.hi, domain_hi);
+    if (lo > hi) return Interval::all();
+    return make(f(lo), f(hi), nan);
+}
+
+inline double negacos(double v) { return -acos(v); }
+
+struct Box
+{
+    double min_x, min_y, max_x, max_y;
+};
+
+// Comparison with a margin for rounding: a definite answer is only given if it holds by more than the margin
+inline double margin(const Interval& a, const Interval& b)
+{
+    double m = std::max(std::max(fabs(a.lo), fabs(a.hi)), std::max(fabs(b.lo), fabs(b.hi)));
+    return 1e-9 * std::max(1.0, m);
+}
+
+inline int isLess(const Interval& a, const Interval& b)
+{
+    double eps = margin(a, b);
+    if (a.hi + eps < b.lo && !a.nan && !b.nan) return 1;
+    if (a.lo > b.hi + eps) return -1;
+    return 0;
+}
+
+// Exact like exprtk's eq_op: disjoint intervals never compare equal, two equal single values always do
+inline int equalTo(const Interval& a, const Interval& b)
+{
+    if (a.lo > b.hi || a.hi < b.lo) return -1;
+    if (a.lo == a.hi && b.lo == b.hi && a.lo == b.lo && !a.nan && !b.nan) return 1;
+    return 0;
+}
+
+}
+
+int ConstraintProgram::evaluateBox(double min_x, double min_y, double max_x, double max_y, std::vector<Interval>& stack) const
+{
+    stack.clear();
+
+    for (std::vector<Instruction>::const_iterator it = program_.begin(); it != program_.end(); ++it)
+    {
+        const OpCode op = it->op;
+
+        if (op == OP_CONST) { stack.push_back(make(it->value, it->value, false)); continue; }
+        if (op == OP_X) { stack.push_back(Interval(min_x, max_x)); continue; }
+        if (op == OP_Y) { stack.push_back(Interval(min_y, max_y)); continue; }
+
+        if (op < OP_ADD)
+        {
+            Interval& a = stack.back();
+            switch (op)
+            {
+            case OP_NEG:   a = Interval(-a.hi, -a.lo, a.nan); break;
+            case OP_ABS:   a = (a.lo >= 0) ? a : (a.hi <= 0) ? Interval(-a.hi, -a.lo, a.nan) : Interval(0, std::max(-a.lo, a.hi), a.nan); break;
+            case OP_SQRT:  a = increasing(a, sqrt, 0); break;
+            case OP_SIN:
+            case OP_COS:   a = Interval(-1, 1, a.nan || a.lo == -HUGE_VAL || a.hi == HUGE_VAL); break;
+            case OP_TAN:   a = Interval::all(); break;
+            case OP_ASIN:  a = increasing(a, asin, -1, 1); break;
+            case OP_ACOS:  { Interval r = increasing(a, negacos, -1, 1); a = Interval(-r.hi, -r.lo, r.nan); break; }
+            case OP_ATAN:  a = increasing(a, atan); break;
+            case OP_EXP:   a = increasing(a, exp); break;
+            case OP_LOG:   a = increasing(a, log, 0); break;
+            case OP_FLOOR: a = increasing(a, floor); break;
+            case OP_CEIL:  a = increasing(a, ceil); break;
+            case OP_NOT:   a = Interval::truth(-a.isTrue()); break;
+            case OP_IPOW:  a = integerPower(a, it->value); break;
+            default: break;
+            }
+            continue;
+        }
+
+        Interval a = stack.back();
+        stack.pop_back();
+        Interval& b = stack.back();
+        bool nan = a.nan || b.nan;
+        switch (op)
+        {
+        case OP_ADD: b = make(b.lo + a.lo, b.hi + a.hi, nan); break;
+        case OP_SUB: b = make(b.lo - a.hi, b.hi - a.lo, nan); break;
+        case OP_MUL: b = hull4(b.lo * a.lo, b.lo * a.hi, b.hi * a.lo, b.hi * a.hi, nan); break;
+        case OP_DIV:
+            if (a.lo > 0 || a.hi < 0) b = hull4(b.lo / a.lo, b.lo / a.hi, b.hi / a.lo, b.hi / a.hi, nan);
+            else b = Interval::all();
+            break;
+        case OP_MOD:
+        {
+            // fmod keeps the sign of b and is smaller than |a|
+            double m = std::max(fabs(a.lo), fabs(a.hi));
+            nan = nan || (a.lo <= 0 && a.hi >= 0) || b.lo == -HUGE_VAL || b.hi == HUGE_VAL;
+            if (b.lo >= 0) b = Interval(0, std::min(b.hi, m), nan);
+            else if (b.hi <= 0) b = Interval(-std::min(-b.lo, m), 0, nan);
+            else b = Interval(-m, m, nan);
+            break;
+        }
+        case OP_POW:
+            // monotone in both arguments for positive bases
+            if (b.lo > 0) b = hull4(pow(b.lo, a.lo), pow(b.lo, a.hi), pow(b.hi, a.lo), pow(b.hi, a.hi), nan);
+            else b = Interval::all();
+            break;
+        case OP_ATAN2: b = Interval(-M_PI, M_PI, nan); break;
+        case OP_HYPOT:
+        {
+            double ma = (a.lo >= 0) ? a.lo : (a.hi <= 0) ? -a.hi : 0;
+            double mb = (b.lo >= 0) ? b.lo : (b.hi <= 0) ? -b.hi : 0;
+            double Ma = std::max(fabs(a.lo), fabs(a.hi)), Mb = std::max(fabs(b.lo), fabs(b.hi));
+            b = make(sqrt(ma * ma + mb * mb), sqrt(Ma * Ma + Mb * Mb), nan);
+            break;
+        }
+        case OP_MIN: b = Interval(std::min(b.lo, a.lo), std::min(b.hi, a.hi), nan); break;
+        case OP_MAX: b = Interval(std::max(b.lo, a.lo), std::max(b.hi, a.hi), nan); break;
+        case OP_LT:  b = Interval::truth(isLess(b, a)); break;
+        case OP_LE:  b = Interval::truth(isLess(b, a)); break;
+        case OP_GT:  b = Interval::truth(isLess(a, b)); break;
+        case OP_GE:  b = Interval::truth(isLess(a, b)); break;
+        case OP_EQ:  b = Interval::truth(equalTo(b, a)); break;
+        case OP_NE:  b = Interval::truth(-equalTo(b, a)); break;
+        default:
+        {
+            // logical operators on three-valued truth
+            int tb = b.isTrue(), ta = a.isTrue();
+            int t = 0;
+            switch (op)
+            {
+            case OP_AND:  t = (ta < 0 || tb < 0) ? -1 : (ta > 0 && tb > 0) ? 1 : 0; break;
+            case OP_OR:   t = (ta > 0 || tb > 0) ? 1 : (ta < 0 && tb < 0) ? -1 : 0; break;
+            case OP_NAND: t = (ta < 0 || tb < 0) ? 1 : (ta > 0 && tb > 0) ? -1 : 0; break;
+            case OP_NOR:  t = (ta > 0 || tb > 0) ? -1 : (ta < 0 && tb < 0) ? 1 : 0; break;
+            case OP_XOR:  t = (ta == 0 || tb == 0) ? 0 : (ta != tb) ? 1 : -1; break;
+            case OP_XNOR: t = (ta == 0 || tb == 0) ? 0 : (ta == tb) ? 1 : -1; break;
+            default: break;
+            }
+            b = Interval::truth(t);
+        }
+        }
+    }
+
+    return stack.back().isTrue();
+}
+
+bool ConstraintProgram::getBoundingBox(double min_x, double min_y, double max_x, double max_y, double resolution,
+                                       double& bb_min_x, double& bb_min_y, double& bb_max_x, double& bb_max_y) const
+{
+    // Limit on the number of boxes that is evaluated, the boxes left then all count as maybe true
+    static const unsigned int MAX_EVALUATIONS = 20000;
+
+    if (program_.empty()) return false;
+
+    std::vector<Interval> stack;
+    stack.reserve(stack_depth_);
+
+    std::vector<Box> boxes;
+    Box domain = { min_x, min_y, max_x, max_y };
+    boxes.push_back(domain);
+
+    bool found = false;
+    unsigned int evaluations = 0;
+
+    while (!boxes.empty())
+    {
+        Box box = boxes.back();
+        boxes.pop_back();
+
+        // Nothing to gain for boxes within the bounding box so far
+        if (found && box.min_x >= bb_min_x && box.max_x <= bb_max_x && box.min_y >= bb_min_y && box.max_y <= bb_max_y)
+            continue;
+
+        int t = 0;
+        if (evaluations < MAX_EVALUATIONS)
+        {
+            t = evaluateBox(box.min_x, box.min_y, box.max_x, box.max_y, stack);
+            ++evaluations;
+        }
+        if (t < 0) continue;
+
+        double w = box.max_x - box.min_x, h = box.max_y - box.min_y;
+        if (t == 0 && evaluations < MAX_EVALUATIONS && std::max(w, h) > resolution)
+        {
+            Box b1 = box, b2 = box;
+            if (w > h) b1.max_x = b2.min_x = box.min_x + w / 2;
+            else b1.max_y = b2.min_y = box.min_y + h / 2;
+            boxes.push_back(b1);
+            boxes.push_back(b2);
+            continue;
+        }
+
+        if (!found)
+        {
+            bb_min_x = box.min_x; bb_min_y = box.min_y; bb_max_x = box.max_x; bb_max_y = box.max_y;
+            found = true;
+        }
+        else
+        {
+            bb_min_x = std::min(bb_min_x, box.min_x); bb_min_y = std::min(bb_min_y, box.min_y);
+            bb_max_x = std::max(bb_max_x, box.max_x); bb_max_y = std::max(bb_max_y, box.max_y);
+        }
+    }
+
+    return found;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Parser
+
+bool ConstraintProgram::tokenize(const std::string& constraint)
+{
+    tokens_.clear();
+
+    unsigned int i = 0;
+    while (i < constraint.size())
+    {
+        char c = constraint[i];
+        if (isspace(c)) { ++i; continue; }
+
+        Token token;
+        token.number = 0;
+
+        if (isdigit(c) || (c == '.' && i + 1 < constraint.size() && isdigit(constraint[i + 1])))
+        {
+            const char* begin = constraint.c_str() + i;
+            char* end;
+            token.type = Token::NUMBER;
+            token.number = strtod(begin, &end);
+            i += end - begin;
+
+            // exprtk would read '2x' as 2*x; leave that to exprtk
+            if (i < constraint.size() && (isalpha(constraint[i]) || constraint[i] == '_')) return false;
+        }
+        else if (isalpha(c) || c == '_')
+        {
+            unsigned int j = i;
+            while (j < constraint.size() && (isalnum(constraint[j]) || constraint[j] == '_')) ++j;
+            token.type = Token::SYMBOL;
+            token.text = constraint.substr(i, j - i);
+            std::transform(token.text.begin(), token.text.end(), token.text.begin(), ::tolower);
+            i = j;
+        }
+        else if (c == '(' || c == '[' || c == '{') { token.type = Token::LBRACKET; token.text = c; ++i; }
+        else if (c == ')' || c == ']' || c == '}') { token.type = Token::RBRACKET; token.text = c; ++i; }
+        else if (c == ',') { token.type = Token::COMMA; ++i; }
+        else
+        {
+            static const char* operators[] = { "<=", ">=", "==", "!=", "<>", "<", ">", "=", "+", "-", "*", "/", "%", "^", "&", "|" };
+            token.type = Token::INVALID;
+            for (unsigned int k = 0; k < sizeof(operators) / sizeof(operators[0]); ++k)
+            {
+                std::string op(operators[k]);
+                if (constraint.compare(i, op.size(), op) == 0)
+                {
+                    token.type = Token::OPERATOR;
+                    token.text = op;
+                    i += op.size();
+                    break;
+                }
+            }
+            if (token.type == Token::INVALID) return false;
+        }
+
+        tokens_.push_back(token);
+    }
+
+    Token end;
+    end.type = Token::END;
+    end.number = 0;
+    tokens_.push_back(end);
+    return true;
+}
+
+bool ConstraintProgram::binaryOperator(const Token& token, int& left, int& right, OpCode& op) const
+{
+    static const struct { const char* text; int left, right; OpCode op; } ops[] =
+    {
+        { "<", LEVEL05, LEVEL06, OP_LT }, { "<=", LEVEL05, LEVEL06, OP_LE }, { ">", LEVEL05, LEVEL06, OP_GT },
+        { ">=", LEVEL05, LEVEL06, OP_GE }, { "==", LEVEL05, LEVEL06, OP_EQ }, { "=", LEVEL05, LEVEL06, OP_EQ },
+        { "!=", LEVEL05, LEVEL06, OP_NE }, { "<>", LEVEL05, LEVEL06, OP_NE },
+        { "+", LEVEL07, LEVEL08, OP_ADD }, { "-", LEVEL07, LEVEL08, OP_SUB },
+        { "*", LEVEL10, LEVEL11, OP_MUL }, { "/", LEVEL10, LEVEL11, OP_DIV }, { "%", LEVEL10, LEVEL11, OP_MOD },
+        { "^", LEVEL12, LEVEL12, OP_POW },
+        { "and", LEVEL01, LEVEL02, OP_AND }, { "&", LEVEL01, LEVEL02, OP_AND }, { "nand", LEVEL01, LEVEL02, OP_NAND },
+        { "or", LEVEL03, LEVEL04, OP_OR }, { "|", LEVEL03, LEVEL04, OP_OR }, { "nor", LEVEL03, LEVEL04, OP_NOR },
+        { "xor", LEVEL03, LEVEL04, OP_XOR }, { "xnor", LEVEL03, LEVEL04, OP_XNOR }
+    };
+
+    if (token.type != Token::OPERATOR && token.type != Token::SYMBOL) return false;
+
+    for (unsigned int i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i)
+    {
+        if (token.text == ops[i].text)
+        {
+            left = ops[i].left;
+            right = ops[i].right;
+            op = ops[i].op;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConstraintProgram::parseExpression(int precedence)
+{
+    if (!parseBranch(precedence)) return false;
+
+    while (true)
+    {
+        int left, right;
+        OpCode op;
+        if (!binaryOperator(tokens_[current_], left, right, op) || left < precedence) return true;
+
+        ++current_;
+        if (!parseExpression(right)) return false;
+        emit(op);
+    }
+}
+
+bool ConstraintProgram::parseBranch(int precedence)
+{
+    const Token& token = tokens_[current_];
+
+    if (token.type == Token::NUMBER)
+    {
+        ++current_;
+        program_.push_back(Instruction(OP_CONST, token.number));
+        return true;
+    }
+    else if (token.type == Token::SYMBOL)
+    {
+        return parseSymbol();
+    }
+    else if (token.type == Token::LBRACKET)
+    {
+        char close = (token.text == "(") ? ')' : (token.text == "[") ? ']' : '}';
+        ++current_;
+        if (!parseExpression(LEVEL00) || tokens_[current_].type != Token::RBRACKET || tokens_[current_].text[0] != close)
+            return false;
+        ++current_;
+        return true;
+    }
+    else if (token.type == Token::OPERATOR && token.text == "-")
+    {
+        // Like exprtk: -a^b is -(a^b), but a^-b is a^(-b)
+        ++current_;
+        if (!(precedence == LEVEL12 ? parseBranch(LEVEL09) : parseExpression(LEVEL09))) return false;
+        emit(OP_NEG);
+        return true;
+    }
+    else if (token.type == Token::OPERATOR && token.text == "+")
+    {
+        ++current_;
+        return parseExpression(LEVEL13);
+    }
+    return false;
+}
+
+bool ConstraintProgram::parseSymbol()
+{
+    std::string name = tokens_[current_].text;
+    ++current_;
+
+    if (name == "x") { emit(OP_X); return true; }
+    if (name == "y") { emit(OP_Y); return true; }
+
+    static const struct { const char* name; OpCode op; } unary[] =
+    {
+        { "abs", OP_ABS }, { "sqrt", OP_SQRT }, { "sin", OP_SIN }, { "cos", OP_COS }, { "tan", OP_TAN },
+        { "asin", OP_ASIN }, { "acos", OP_ACOS }, { "atan", OP_ATAN }, { "exp", OP_EXP }, { "log", OP_LOG },
+        { "floor", OP_FLOOR }, { "ceil", OP_CEIL }, { "not", OP_NOT }
+    };
+    static const struct { const char* name; OpCode op; bool variadic; } binary[] =
+    {
+        { "atan2", OP_ATAN2, false }, { "hypot", OP_HYPOT, false }, { "min", OP_MIN, true }, { "max", OP_MAX, true }
+    };
+
+    int arity = 0;
+    OpCode op = OP_CONST;
+    bool variadic = false;
+    for (unsigned int i = 0; i < sizeof(unary) / sizeof(unary[0]); ++i)
+        if (name == unary[i].name) { op = unary[i].op; arity = 1; }
+    for (unsigned int i = 0; i < sizeof(binary) / sizeof(binary[0]); ++i)
+        if (name == binary[i].name) { op = binary[i].op; arity = 2; variadic = binary[i].variadic; }
+    if (arity == 0) return false;
+
+    // Function call: name(arg, ...)
+    if (tokens_[current_].type != Token::LBRACKET || tokens_[current_].text != "(") return false;
+    ++current_;
+
+    int n_args = 0;
+    while (true)
+    {
+        if (!parseExpression(LEVEL00)) return false;
+        ++n_args;
+        if (variadic && n_args >= 2) emit(op);
+
+        if (tokens_[current_].type == Token::COMMA) { ++current_; continue; }
+        if (tokens_[current_].type == Token::RBRACKET && tokens_[current_].text == ")") { ++current_; break; }
+        return false;
+    }
+
+    if (variadic ? n_args < 2 : n_args != arity) return false;
+    if (!variadic) emit(op);
+    return true;
+}
+
+void ConstraintProgram::emit(OpCode op)
+{
+    program_.push_back(Instruction(op));
+
+    unsigned int n = program_.size();
+    unsigned int arity = (op <= OP_Y) ? 0 : (op < OP_ADD) ? 1 : 2;
+    if (arity == 0) return;
+
+    bool a_const = program_[n - 2].op == OP_CONST;
+    bool b_const = arity == 2 && n >= 3 && program_[n - 3].op == OP_CONST;
+
+    if (op == OP_POW && a_const && !b_const)
+    {
+        // exprtk evaluates constant integer exponents up to 60 by multiplication
+        double c = program_[n - 2].value;
+        if (fabs(c) <= 60 && c == floor(c))
+        {
+            program_.erase(program_.end() - 2, program_.end());
+            program_.push_back(Instruction(OP_IPOW, c));
+        }
+        return;
+    }
+
+    // Fold operations on constants, like exprtk does
+    if (a_const && (arity == 1 || b_const))
+    {
+        std::vector<Instruction> folded(program_.end() - (arity + 1), program_.end());
+        program_.erase(program_.end() - (arity + 1), program_.end());
+
+        ConstraintProgram constant;
+        constant.program_ = folded;
+        constant.stack_.resize(2 * BATCH_SIZE);
+        double x = 0;
+        program_.push_back(Instruction(OP_CONST, *constant.run(&x, &x, 1)));
+    }
+}
+
+}
@@ -1,16 +1,25 @@
 #include "cb_base_navigation/global_planner/global_planner_interface.h"
 
+#include <boost/bind.hpp>
+
+#include <sys/stat.h> // for mkdir
+
 namespace cb_global_planner {
 
 GlobalPlannerInterface::~GlobalPlannerInterface()
 {
     // Clean things up
+    cancelRefinement();
+    check_planner_.reset();
+    free_planners_.clear();
+    planner_pool_.clear();
     global_planner_.reset();
 
     delete tf_;
 }
 
 GlobalPlannerInterface::GlobalPlannerInterface(costmap_2d::Costmap2DROS& costmap) :
+    refine_request_(0),
     gp_loader_("cb_base_navigation", "cb_global_planner::GlobalPlannerPlugin"),
     tf_(new tf::TransformListener(ros::Duration(10))),
     costmap_(costmap)
@@ -24,60 +33,128 @@ GlobalPlannerInterface::GlobalPlannerInterface(costmap_2d::Costmap2DROS& costmap
     nh.param("robot_base_frame", robot_base_frame_, std::string("/base_link"));;
     nh.param("global_frame", global_frame_, std::string("/map"));
 
+    int concurrent_requests;
+    nh.param("concurrent_requests", concurrent_requests, 1);
+
+    // Snapshots of plan requests, to replay them offline (a_star_planner_benchmark --snapshot)
+    nh.param("snapshots/enabled", record_snapshots_, false);
+    nh.param("snapshots/directory", snapshot_directory_, std::string("/tmp/plan_snapshots"));
+    nh.param("snapshots/min_planning_time", snapshot_min_planning_time_, 0.0);
+    if (record_snapshots_) {
+        mkdir(snapshot_directory_.c_str(), 0755);
+        ROS_INFO("GPI: Recording snapshots of the plan requests that fail or take at least %.3f s in '%s'.",
+                 snapshot_min_planning_time_, snapshot_directory_.c_str());
+    }
+
+    // Anytime plans: a budget for get_plan_srv and the pose callback; the pose callback and get_plan_anytime_srv
+    // improve the plan in the background and send every improvement to the local planner
+    nh.param("anytime/time_budget", anytime_time_budget_, 0.0);
+    nh.param("anytime/refine_slice", anytime_refine_slice_, 0.02);
+    nh.param("anytime/max_refine_time", anytime_max_refine_time_, 2.0);
+    if (anytime_refine_slice_ <= 0) {
+        ROS_WARN("GPI: anytime/refine_slice should be positive, using 0.02.");
+        anytime_refine_slice_ = 0.02;
+    }
+
     // Initialize the global planner
+    global_planner_ = createPlanner(global_planner);
+
+    // Concurrent requests: a pool of planner instances and one for checkPlan, so checks do not wait for searches
+    if (concurrent_requests > 1) {
+        if (global_planner_->supportsConcurrentRequests()) {
+            planner_pool_.push_back(global_planner_);
+            for (int i = 1; i < concurrent_requests; ++i) planner_pool_.push_back(createPlanner(global_planner));
+            for (unsigned int i = 0; i < planner_pool_.size(); ++i) free_planners_.push_back(planner_pool_[i].get());
+            check_planner_ = createPlanner(global_planner);
+            ROS_INFO("GPI: Serving up to %d plan requests at the same time.", concurrent_requests);
+        } else {
+            ROS_WARN("GPI: %s does not support concurrent requests, plan requests are serialised.", global_planner.c_str());
+        }
+    }
+
+    // Register the ROS Service Servers
+    get_plan_srv_   = nh.advertiseService("get_plan_srv",   &GlobalPlannerInterface::getPlan,   this);
+    get_plan_anytime_srv_ = nh.advertiseService("get_plan_anytime_srv", &GlobalPlannerInterface::getPlanAnytime, this);
+    get_plans_srv_  = nh.advertiseService("get_plans_srv",  &GlobalPlannerInterface::getPlans,  this);
+    get_plan_costs_srv_ = nh.advertiseService("get_plan_costs_srv", &GlobalPlannerInterface::getPlanCosts, this);
+    check_plan_srv_ = nh.advertiseService("check_plan_srv", &GlobalPlannerInterface::checkPlan, this);
+    check_plan_blocked_srv_ = nh.advertiseService("check_plan_blocked_srv", &GlobalPlannerInterface::checkPlanBlocked, this);
+
+    // Pose callback and plan pub
+    pose_sub_ = nh.subscribe("/move_base_simple/goal", 1, &GlobalPlannerInterface::poseCallback, this);
+    plan_pub_ = gh.advertise<LocalPlannerActionGoal>("local_planner/action_server/goal",1);
+    statistics_pub_ = nh.advertise<cb_base_navigation::PlanStatistics>("plan_statistics", 10);
+
+    ROS_INFO_STREAM("GPI: Subsribed to '" << pose_sub_.getTopic() << "' for simple pose callbacks and I will send the plans to '" << plan_pub_.getTopic() << "'.");
+}
+
+boost::shared_ptr<GlobalPlannerPlugin> GlobalPlannerInterface::createPlanner(const std::string& global_planner)
+{
+    boost::shared_ptr<GlobalPlannerPlugin> planner;
+    std::string class_name = global_planner;
     try {
-        if(!gp_loader_.isClassAvailable(global_planner)){
+        if(!gp_loader_.isClassAvailable(class_name)){
             std::vector<std::string> classes = gp_loader_.getDeclaredClasses();
             for(unsigned int i = 0; i < classes.size(); ++i){
-                if(global_planner == gp_loader_.getName(classes[i])){
-                    global_planner = classes[i]; break;
+                if(class_name == gp_loader_.getName(classes[i])){
+                    class_name = classes[i]; break;
                 }
             }
         }
-        global_planner_ = gp_loader_.createInstance(global_planner);
-        global_planner_->initialize(gp_loader_.getName(global_planner), tf_, &costmap_);
+        planner = gp_loader_.createInstance(class_name);
+        planner->initialize(gp_loader_.getName(class_name), tf_, &costmap_);
     } catch (const pluginlib::PluginlibException& ex)
     {
-        ROS_FATAL("Failed to create the %s planner, are you sure it is properly registered and that the containing library is built? Exception: %s", global_planner.c_str(), ex.what());
+        ROS_FATAL("Failed to create the %s planner, are you sure it is properly registered and that the containing library is built? Exception: %s", class_name.c_str(), ex.what());
         exit(0);
     }
+    return planner;
+}
 
-    // Register the ROS Service Servers
-    get_plan_srv_   = nh.advertiseService("get_plan_srv",   &GlobalPlannerInterface::getPlan,   this);
-    check_plan_srv_ = nh.advertiseService("check_plan_srv", &GlobalPlannerInterface::checkPlan, this);
+GlobalPlannerPlugin* GlobalPlannerInterface::acquirePlanner()
+{
+    boost::unique_lock<boost::mutex> lock(pool_mutex_);
+    while (free_planners_.empty()) pool_condition_.wait(lock);
 
-    // Pose callback and plan pub
-    pose_sub_ = nh.subscribe("/move_base_simple/goal", 1, &GlobalPlannerInterface::poseCallback, this);
-    plan_pub_ = gh.advertise<LocalPlannerActionGoal>("local_planner/action_server/goal",1);
+    GlobalPlannerPlugin* planner = free_planners_.back();
+    free_planners_.pop_back();
+    return planner;
+}
 
-    ROS_INFO_STREAM("GPI: Subsribed to '" << pose_sub_.getTopic() << "' for simple pose callbacks and I will send the plans to '" << plan_pub_.getTopic() << "'.");
+void GlobalPlannerInterface::releasePlanner(GlobalPlannerPlugin* planner)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(pool_mutex_);
+        free_planners_.push_back(planner);
+    }
+    pool_condition_.notify_one();
 }
 
 void GlobalPlannerInterface::poseCallback(const geometry_msgs::PoseStampedConstPtr &pose)
 {
     ROS_INFO("GPI: Simple Pose callback");
 
-    GetPlanRequest req;
-    GetPlanResponse resp;
-
-    PositionConstraint pc;
+    std::vector<PositionConstraint> position_constraints(1);
+    PositionConstraint& pc = position_constraints[0];
     pc.frame = "/map";
     std::stringstream str;
     str << "(x-" << pose->pose.position.x << ")^2 + (y-" << pose->pose.position.y << ")^2 < .05^2";
     pc.constraint = str.str();
-    req.goal_position_constraints.push_back(pc);
-
-    if (getPlan(req,resp)) {
-        if(resp.succes) {
-            OrientationConstraint oc;
-            oc.frame = "/map";
-            oc.look_at.x = pose->pose.position.x + cos(tf::getYaw(pose->pose.orientation));
-            oc.look_at.y = pose->pose.position.y + sin(tf::getYaw(pose->pose.orientation));
-
-            LocalPlannerActionGoal goal;
-            goal.goal.orientation_constraint = oc;
-            goal.goal.plan = resp.plan;
-            plan_pub_.publish(goal);
+
+    OrientationConstraint oc;
+    oc.frame = "/map";
+    oc.look_at.x = pose->pose.position.x + cos(tf::getYaw(pose->pose.orientation));
+    oc.look_at.y = pose->pose.position.y + sin(tf::getYaw(pose->pose.orientation));
+
+    // With a time budget the plan is improved in the background
+    bool anytime = anytime_time_budget_ > 0;
+    std::vector<geometry_msgs::PoseStamped> plan;
+    bool succes;
+    double epsilon;
+    if (planRequest(position_constraints, anytime ? anytime_time_budget_ : -1, anytime ? &oc : NULL, plan, succes, epsilon)) {
+        if(succes) {
+            // An anytime plan was sent with its refinement already
+            if (!anytime) publishPlan(plan, oc);
             ROS_INFO("GPI: Succesfully published plan to local planner :)");
         } else {
             ROS_INFO("GPI: Sorry, I can't find a valid plan to there :(.");
@@ -89,40 +166,326 @@ void GlobalPlannerInterface::poseCallback(const geometry_msgs::PoseStampedConstP
 
 bool GlobalPlannerInterface::checkPlan(CheckPlanRequest &req, CheckPlanResponse &resp)
 {
-    // Lock the costmap for a sec
-    boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+    if(req.plan.size() == 0) { ROS_ERROR("No plan specified so no check can be performed."); return false; }
 
+    resp.valid = findFirstBlockedPose(req.plan) < 0;
+    return true;
+}
+
+bool GlobalPlannerInterface::checkPlanBlocked(cb_base_navigation::CheckPlanBlocked::Request &req, cb_base_navigation::CheckPlanBlocked::Response &resp)
+{
     if(req.plan.size() == 0) { ROS_ERROR("No plan specified so no check can be performed."); return false; }
-    resp.valid = global_planner_->checkPlan(req.plan);
+
+    resp.first_blocked = findFirstBlockedPose(req.plan);
+    resp.valid = resp.first_blocked < 0;
     return true;
 }
 
+int GlobalPlannerInterface::findFirstBlockedPose(const std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    // A check only reads the costmap
+    boost::shared_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+
+    if (planner_pool_.empty())
+        return global_planner_->findFirstBlockedPose(plan);
+
+    // Next to the running searches
+    boost::unique_lock<boost::mutex> check_lock(check_mutex_);
+    return check_planner_->findFirstBlockedPose(plan);
+}
+
 bool GlobalPlannerInterface::getPlan(GetPlanRequest &req, GetPlanResponse &resp)
 {
-    // Lock the costmap for a sec
-    boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+    double epsilon;
+    return planRequest(req.goal_position_constraints, anytime_time_budget_ > 0 ? anytime_time_budget_ : -1, NULL, resp.plan, resp.succes, epsilon);
+}
+
+bool GlobalPlannerInterface::getPlanAnytime(cb_base_navigation::GetPlanAnytime::Request &req, cb_base_navigation::GetPlanAnytime::Response &resp)
+{
+    return planRequest(req.goal_position_constraints, std::max(0.0, req.time_budget), req.send_to_local_planner ? &req.orientation_constraint : NULL,
+                       resp.plan, resp.succes, resp.epsilon);
+}
 
+bool GlobalPlannerInterface::planRequest(const std::vector<PositionConstraint>& position_constraints, double time_budget, const OrientationConstraint* refine,
+                                         std::vector<geometry_msgs::PoseStamped>& plan, bool& succes, double& epsilon)
+{
     // Check the input
-    if(req.goal_position_constraints.size() > 1) { ROS_ERROR("You have specified more than 1 constraint, this is not yet supported."); return false; }
-    if(req.goal_position_constraints.size() == 0) { ROS_ERROR("No goal position constraint specified, planner cannot create plan."); return false; }
+    if(position_constraints.size() > 1) { ROS_ERROR("You have specified more than 1 constraint, this is not yet supported."); return false; }
+    if(position_constraints.size() == 0) { ROS_ERROR("No goal position constraint specified, planner cannot create plan."); return false; }
+
+    // A new plan replaces the one that is refined
+    unsigned int request = cancelRefinement();
+
+    ros::WallTime start = ros::WallTime::now();
+    cb_base_navigation::PlanStatistics statistics;
+    statistics.header.stamp = ros::Time::now();
+    PlanSnapshot snapshot;
+    PlanSnapshot* record = record_snapshots_ ? &snapshot : NULL;
+    bool ok, refinable = false;
+
+    if (planner_pool_.empty()) {
+        // Lock the costmap for a sec
+        boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+        statistics.lock_wait = (ros::WallTime::now() - start).toSec();
+        ok = makePlan(global_planner_.get(), position_constraints, time_budget, plan, succes, epsilon, statistics, record);
+        refinable = ok && refine && succes && global_planner_->canImprovePlan();
+    } else {
+        // Concurrent requests: the searches only read the costmap, each on a planner instance of its own
+        GlobalPlannerPlugin* planner = acquirePlanner();
+        {
+            boost::shared_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+            statistics.lock_wait = (ros::WallTime::now() - start).toSec();
+            ok = makePlan(planner, position_constraints, time_budget, plan, succes, epsilon, statistics, record);
+            refinable = ok && refine && succes && planner->canImprovePlan();
+        }
+
+        // The refinement keeps the instance with its search until it ends
+        if (refinable) startRefinement(planner, request, plan, *refine, epsilon);
+        else releasePlanner(planner);
+    }
+    if (refinable && planner_pool_.empty()) startRefinement(global_planner_.get(), request, plan, *refine, epsilon);
+
+    // The refinement sends the plan first, then its improvements
+    if (ok && refine && succes && !plan.empty() && !refinable) publishPlan(plan, *refine);
+
+    if (ok && statistics_pub_.getNumSubscribers() > 0) {
+        statistics.header.frame_id = global_frame_;
+        statistics.succes = succes;
+        statistics.total = (ros::WallTime::now() - start).toSec();
+        statistics_pub_.publish(statistics);
+    }
+
+    // Written without the costmap lock
+    if (snapshot.getCostmap()) {
+        char filename[64];
+        snprintf(filename, sizeof(filename), "/plan_%u.%09u.snapshot", statistics.header.stamp.sec, statistics.header.stamp.nsec);
+        if (snapshot.write(snapshot_directory_ + filename)) ROS_INFO_STREAM("GPI: Recorded plan request in '" << snapshot_directory_ + filename << "'.");
+    }
+    return ok;
+}
+
+void GlobalPlannerInterface::publishPlan(const std::vector<geometry_msgs::PoseStamped>& plan, const OrientationConstraint& orientation_constraint)
+{
+    LocalPlannerActionGoal goal;
+    goal.goal.orientation_constraint = orientation_constraint;
+    goal.goal.plan = plan;
+    plan_pub_.publish(goal);
+}
 
+unsigned int GlobalPlannerInterface::cancelRefinement()
+{
+    boost::shared_ptr<boost::thread> thread;
+    unsigned int request;
+    {
+        boost::unique_lock<boost::mutex> lock(refine_mutex_);
+        request = ++refine_request_;
+        thread.swap(refine_thread_);
+    }
+
+    // It notices within a slice, the costmap is not locked here
+    if (thread) thread->join();
+    return request;
+}
+
+void GlobalPlannerInterface::startRefinement(GlobalPlannerPlugin* planner, unsigned int request, const std::vector<geometry_msgs::PoseStamped>& plan,
+                                             const OrientationConstraint& orientation_constraint, double epsilon)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(refine_mutex_);
+        if (request == refine_request_) {
+            publishPlan(plan, orientation_constraint);
+            refine_thread_.reset(new boost::thread(boost::bind(&GlobalPlannerInterface::refinePlan, this, planner, request, plan, orientation_constraint, epsilon)));
+            return;
+        }
+    }
+
+    // A later request came in meanwhile
+    if (!planner_pool_.empty()) releasePlanner(planner);
+}
+
+void GlobalPlannerInterface::refinePlan(GlobalPlannerPlugin* planner, unsigned int request, std::vector<geometry_msgs::PoseStamped> plan,
+                                        OrientationConstraint orientation_constraint, double epsilon)
+{
+    ros::WallTime end = ros::WallTime::now() + ros::WallDuration(anytime_max_refine_time_);
+    bool refining = true;
+    while (refining && ros::WallTime::now() < end) {
+        // In slices, so costmap updates and other requests do not wait for the whole refinement
+        bool improved = false;
+        if (planner_pool_.empty()) {
+            boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+            refining = refineSlice(planner, request, plan, epsilon, improved);
+        } else {
+            boost::shared_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+            refining = refineSlice(planner, request, plan, epsilon, improved);
+        }
+        if (!improved) continue;
+
+        {
+            boost::unique_lock<boost::mutex> lock(refine_mutex_);
+            if (request != refine_request_) break;
+            publishPlan(plan, orientation_constraint);
+        }
+        ROS_INFO("GPI: Published an improved plan (epsilon %.2f) to the local planner.", epsilon);
+
+        boost::unique_lock<boost::mutex> lock(vis_mutex_);
+        vis_.publishGlobalPlanMarker(plan);
+        vis_.publishGlobalPlanMarkerArray(plan);
+    }
+
+    if (!planner_pool_.empty()) releasePlanner(planner);
+}
+
+bool GlobalPlannerInterface::refineSlice(GlobalPlannerPlugin* planner, unsigned int request, std::vector<geometry_msgs::PoseStamped>& plan, double& epsilon, bool& improved)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(refine_mutex_);
+        if (request != refine_request_) return false;
+    }
+    if (!planner->canImprovePlan()) return false;
+
+    std::vector<geometry_msgs::PoseStamped> improved_plan;
+    if (!planner->improvePlan(anytime_refine_slice_, improved_plan, epsilon)) return true;
+
+    // Only cell changes the planner cannot see can block it, then the search is outdated
+    if (!planner->checkPlan(improved_plan)) {
+        ROS_WARN("GPI: The improved plan is blocked, the plan is not improved anymore.");
+        return false;
+    }
+
+    plan.swap(improved_plan);
+    improved = true;
+    return true;
+}
+
+bool GlobalPlannerInterface::getPlans(cb_base_navigation::GetPlans::Request &req, cb_base_navigation::GetPlans::Response &resp)
+{
+    if(req.goal_position_constraints.size() == 0) { ROS_ERROR("No goal position constraints specified, planner cannot create plans."); return false; }
+
+    if (planner_pool_.empty()) {
+        // Lock the costmap once for all constraints
+        boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+        return makePlans(global_planner_.get(), req, resp);
+    }
+
+    GlobalPlannerPlugin* planner = acquirePlanner();
+    bool ok;
+    {
+        boost::shared_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+        ok = makePlans(planner, req, resp);
+    }
+    releasePlanner(planner);
+    return ok;
+}
+
+bool GlobalPlannerInterface::getPlanCosts(cb_base_navigation::GetPlanCosts::Request &req, cb_base_navigation::GetPlanCosts::Response &resp)
+{
+    if(req.goal_position_constraints.size() == 0) { ROS_ERROR("No goal position constraints specified, planner cannot calculate costs."); return false; }
+
+    if (planner_pool_.empty()) {
+        boost::unique_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+        return calculatePlanCosts(global_planner_.get(), req, resp);
+    }
+
+    GlobalPlannerPlugin* planner = acquirePlanner();
+    bool ok;
+    {
+        boost::shared_lock< boost::shared_mutex > lock(*(costmap_.getCostmap()->getLock()));
+        ok = calculatePlanCosts(planner, req, resp);
+    }
+    releasePlanner(planner);
+    return ok;
+}
+
+bool GlobalPlannerInterface::makePlan(GlobalPlannerPlugin* planner, const std::vector<PositionConstraint>& position_constraints, double time_budget,
+                                      std::vector<geometry_msgs::PoseStamped>& plan, bool& succes, double& epsilon, cb_base_navigation::PlanStatistics& statistics,
+                                      PlanSnapshot* snapshot)
+{
     // Get if the robot pose is available
-    if ( ! costmap_.getRobotPose(global_pose_)) { ROS_ERROR("Could not get global robot pose. We can't generate a plan, sorry."); return false; }
+    tf::Stamped<tf::Pose> global_pose;
+    if ( ! costmap_.getRobotPose(global_pose)) { ROS_ERROR("Could not get global robot pose. We can't generate a plan, sorry."); return false; }
 
     // Container for goal positions in map frame
     std::vector<tf::Point> goal_positions;
 
     // Plan the global path
-    if(global_planner_->makePlan(global_pose_, req.goal_position_constraints[0], resp.plan, goal_positions)) {
+    ros::WallTime plan_start = ros::WallTime::now();
+    epsilon = 1;
+    if (time_budget < 0) {
+        succes = planner->makePlan(global_pose, position_constraints[0], plan, goal_positions);
+    } else {
+        // The wait for the costmap counts to the budget
+        succes = planner->makePlanAnytime(global_pose, position_constraints[0], std::max(0.0, time_budget - statistics.lock_wait), plan, goal_positions, epsilon);
+    }
+    double planning_time = (ros::WallTime::now() - plan_start).toSec();
+    planner->getStatistics(statistics);
+
+    // The costmap is still locked, so the snapshot has what the planner saw
+    if (snapshot && (!succes || plan.empty() || planning_time >= snapshot_min_planning_time_)) {
+        costmap_2d::Costmap2D* costmap = costmap_.getCostmap();
+        snapshot->info.width = costmap->getSizeInCellsX();
+        snapshot->info.height = costmap->getSizeInCellsY();
+        snapshot->info.resolution = costmap->getResolution();
+        snapshot->info.origin_x = costmap->getOriginX();
+        snapshot->info.origin_y = costmap->getOriginY();
+        snapshot->info.robot_x = global_pose.getOrigin().getX();
+        snapshot->info.robot_y = global_pose.getOrigin().getY();
+        snapshot->info.robot_yaw = tf::getYaw(global_pose.getRotation());
+
+        tf::Transform frame_pose;
+        snapshot->info.has_frame_pose = planner->getConstraintFramePose(frame_pose);
+        if (snapshot->info.has_frame_pose) {
+            snapshot->info.frame_x = frame_pose.getOrigin().getX();
+            snapshot->info.frame_y = frame_pose.getOrigin().getY();
+            snapshot->info.frame_yaw = tf::getYaw(frame_pose.getRotation());
+        }
+
+        snapshot->info.succes = succes;
+        snapshot->info.stamp = statistics.header.stamp.toSec();
+        snapshot->info.planning_time = planning_time;
+        snapshot->info.plan_size = plan.size();
+        snapshot->global_frame = costmap_.getGlobalFrameID();
+        snapshot->constraint_frame = position_constraints[0].frame;
+        snapshot->constraint = position_constraints[0].constraint;
+        snapshot->copyCostmap(costmap->getCharMap());
+    }
+
+    if (succes) {
         // Visualize me something
-        vis_.publishGlobalPlanMarker(resp.plan);
-        vis_.publishGlobalPlanMarkerArray(resp.plan);
+        ros::WallTime start = ros::WallTime::now();
+        boost::unique_lock<boost::mutex> lock(vis_mutex_);
+        vis_.publishGlobalPlanMarker(plan);
+        vis_.publishGlobalPlanMarkerArray(plan);
         vis_.publishGoalPositionsMarker(goal_positions);
-        resp.succes = true;
-    } else {
-        resp.succes = false;
+        statistics.visualization = (ros::WallTime::now() - start).toSec();
+    }
+    return true;
+}
+
+bool GlobalPlannerInterface::makePlans(GlobalPlannerPlugin* planner, cb_base_navigation::GetPlans::Request &req, cb_base_navigation::GetPlans::Response &resp)
+{
+    // Get if the robot pose is available
+    tf::Stamped<tf::Pose> global_pose;
+    if ( ! costmap_.getRobotPose(global_pose)) { ROS_ERROR("Could not get global robot pose. We can't generate plans, sorry."); return false; }
+
+    std::vector<std::vector<geometry_msgs::PoseStamped> > plans;
+    if (!planner->makePlans(global_pose, req.goal_position_constraints, plans, resp.costs, resp.failed)) return false;
+
+    resp.plans.resize(plans.size());
+    for (unsigned int i = 0; i < plans.size(); ++i) {
+        resp.plans[i].header.frame_id = costmap_.getGlobalFrameID();
+        resp.plans[i].header.stamp = ros::Time::now();
+        resp.plans[i].poses.swap(plans[i]);
     }
     return true;
 }
 
+bool GlobalPlannerInterface::calculatePlanCosts(GlobalPlannerPlugin* planner, cb_base_navigation::GetPlanCosts::Request &req, cb_base_navigation::GetPlanCosts::Response &resp)
+{
+    // Get if the robot pose is available
+    tf::Stamped<tf::Pose> global_pose;
+    if ( ! costmap_.getRobotPose(global_pose)) { ROS_ERROR("Could not get global robot pose. We can't calculate plan costs, sorry."); return false; }
+
+    return planner->getPlanCosts(global_pose, req.goal_position_constraints, resp.costs, resp.lengths, resp.failed);
+}
+
 }
@@ -0,0 +1,133 @@
+#include "cb_base_navigation/global_planner/plan_snapshot.h"
+
+#include <ros/console.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
+namespace cb_global_planner
+{
+
+namespace
+{
+
+const char MAGIC[8] = { 'C', 'B', 'P', 'L', 'A', 'N', 'S', '\0' };
+
+}
+
+const uint32_t PlanSnapshot::VERSION;
+const uint32_t PlanSnapshot::ALIGNMENT;
+
+PlanSnapshot::PlanSnapshot() : mapping_(NULL), mapping_size_(0), mapped_costmap_(NULL)
+{
+    memset(&info, 0, sizeof(info));
+}
+
+PlanSnapshot::~PlanSnapshot()
+{
+    unmap();
+}
+
+void PlanSnapshot::unmap()
+{
+    if (mapping_) munmap(mapping_, mapping_size_);
+    mapping_ = NULL;
+    mapping_size_ = 0;
+    mapped_costmap_ = NULL;
+}
+
+void PlanSnapshot::copyCostmap(const unsigned char* costmap)
+{
+    unmap();
+    costmap_.assign(costmap, costmap + (size_t) info.width * info.height);
+}
+
+const unsigned char* PlanSnapshot::getCostmap() const
+{
+    if (mapped_costmap_) return mapped_costmap_;
+    return costmap_.empty() ? NULL : &costmap_[0];
+}
+
+bool PlanSnapshot::write(const std::string& filename) const
+{
+    const unsigned char* costmap = getCostmap();
+    size_t costmap_size = (size_t) info.width * info.height;
+    if (!costmap && costmap_size > 0) { ROS_ERROR("[Plan snapshot] No costmap to write to '%s'.", filename.c_str()); return false; }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.header_size = sizeof(FileHeader);
+    header.global_frame_size = global_frame.size();
+    header.constraint_frame_size = constraint_frame.size();
+    header.constraint_size = constraint.size();
+    header.info = info;
+
+    uint64_t strings_end = sizeof(FileHeader) + global_frame.size() + constraint_frame.size() + constraint.size();
+    header.costmap_offset = (strings_end + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    file.write((const char*) &header, sizeof(header));
+    file << global_frame << constraint_frame << constraint;
+    std::vector<char> padding(header.costmap_offset - strings_end, 0);
+    if (!padding.empty()) file.write(&padding[0], padding.size());
+    if (costmap_size > 0) file.write((const char*) costmap, costmap_size);
+
+    if (!file) { ROS_ERROR("[Plan snapshot] Could not write '%s'.", filename.c_str()); return false; }
+    return true;
+}
+
+bool PlanSnapshot::map(const std::string& filename)
+{
+    unmap();
+    costmap_.clear();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) { ROS_ERROR("[Plan snapshot] Could not open '%s'.", filename.c_str()); return false; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(FileHeader)) {
+        ROS_ERROR("[Plan snapshot] '%s' is not a plan snapshot.", filename.c_str());
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) { ROS_ERROR("[Plan snapshot] Could not map '%s'.", filename.c_str()); return false; }
+    mapping_ = mapping;
+    mapping_size_ = st.st_size;
+
+    const FileHeader& header = *(const FileHeader*) mapping_;
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.header_size != sizeof(FileHeader)) {
+        ROS_ERROR("[Plan snapshot] '%s' is not a plan snapshot of this version.", filename.c_str());
+        unmap();
+        return false;
+    }
+
+    uint64_t strings_end = sizeof(FileHeader) + (uint64_t) header.global_frame_size + header.constraint_frame_size + header.constraint_size;
+    if (strings_end > header.costmap_offset || header.costmap_offset + (uint64_t) header.info.width * header.info.height > mapping_size_) {
+        ROS_ERROR("[Plan snapshot] '%s' is truncated.", filename.c_str());
+        unmap();
+        return false;
+    }
+
+    info = header.info;
+    const char* strings = (const char*) mapping_ + sizeof(FileHeader);
+    global_frame.assign(strings, header.global_frame_size);
+    constraint_frame.assign(strings + header.global_frame_size, header.constraint_frame_size);
+    constraint.assign(strings + header.global_frame_size + header.constraint_frame_size, header.constraint_size);
+    mapped_costmap_ = (const unsigned char*) mapping_ + header.costmap_offset;
+
+    // The costmap is read in the order of the search, not front to back
+    madvise(mapping_, mapping_size_, MADV_WILLNEED);
+    return true;
+}
+
+}
@@ -3,17 +3,40 @@
 #include <visualization_msgs/Marker.h>
 #include <visualization_msgs/MarkerArray.h>
 
+#include <math.h> // for hypot
+
 namespace cb_global_planner {
 
-Visualization::Visualization()
+namespace
+{
+
+// visualization_msgs::Marker::DELETEALL, which older message versions do not define
+const int DELETEALL = 3;
+
+// Step between the indices of a list of size n so that at most max_size of them are used
+unsigned int getStride(unsigned int n, int max_size)
+{
+    return (max_size > 0 && n > (unsigned int) max_size) ? (n + max_size - 1) / max_size : 1;
+}
+
+}
+
+Visualization::Visualization() : num_arrows_(0)
 {
     ros::NodeHandle nh("~/visualization");
     goal_positions_marker_pub_ = nh.advertise<visualization_msgs::Marker>("markers/goal_positions", 1);
     global_plan_marker_pub_ = nh.advertise<visualization_msgs::Marker>("markers/global_plan", 1);
     global_plan_marker_array_pub_ = nh.advertise<visualization_msgs::MarkerArray>("marker_arrays/global_plan", 1);
+
+    nh.param("compact", compact_, false);
+    nh.param("arrow_spacing", arrow_spacing_, 0.25);
+    nh.param("max_arrows", max_arrows_, 200);
+    nh.param("max_points", max_points_, 2000);
 }
 
 void Visualization::publishGlobalPlanMarker(const std::vector<geometry_msgs::PoseStamped>& plan, const std::string& frame) {
+    if (global_plan_marker_pub_.getNumSubscribers() == 0) return;
+
     // General properties
     visualization_msgs::Marker line_strip;
     line_strip.scale.x = 0.05;
@@ -27,9 +50,12 @@ void Visualization::publishGlobalPlanMarker(const std::vector<geometry_msgs::Pos
     line_strip.type = visualization_msgs::Marker::LINE_STRIP;
     line_strip.action = visualization_msgs::Marker::ADD;
 
-    // Push back all pnts
-    for (std::vector<geometry_msgs::PoseStamped>::const_iterator it = plan.begin(); it != plan.end(); ++it)
-        line_strip.points.push_back(it->pose.position);
+    // Push back all pnts (compact: evenly spread, always the goal)
+    unsigned int stride = compact_ ? getStride(plan.size(), max_points_) : 1;
+    for (unsigned int i = 0; i < plan.size(); i += stride)
+        line_strip.points.push_back(plan[i].pose.position);
+    if (stride > 1 && !plan.empty() && (plan.size() - 1) % stride != 0)
+        line_strip.points.push_back(plan.back().pose.position);
 
     // Publish plan
     global_plan_marker_pub_.publish(line_strip);
@@ -37,6 +63,9 @@ void Visualization::publishGlobalPlanMarker(const std::vector<geometry_msgs::Pos
 
 void Visualization::publishGlobalPlanMarkerArray(const std::vector<geometry_msgs::PoseStamped>& plan, const std::string& frame)
 {
+    // The arrows of the last plan stay until someone subscribes again
+    if (global_plan_marker_array_pub_.getNumSubscribers() == 0) return;
+
     visualization_msgs::MarkerArray array;
 
     visualization_msgs::Marker m;
@@ -54,10 +83,34 @@ void Visualization::publishGlobalPlanMarkerArray(const std::vector<geometry_msgs
     m.id = 0;
     m.type = visualization_msgs::Marker::ARROW;
 
+    if (compact_)
+    {
+        // One message: clear everything, then an arrow every arrow_spacing
+        m.action = DELETEALL;
+        array.markers.push_back(m);
+
+        m.action = visualization_msgs::Marker::ADD;
+        double distance = arrow_spacing_;
+        for (unsigned int i = 0; i < plan.size() && (int) m.id < max_arrows_; ++i)
+        {
+            if (i > 0)
+                distance += hypot(plan[i].pose.position.x - plan[i-1].pose.position.x, plan[i].pose.position.y - plan[i-1].pose.position.y);
+            if (distance < arrow_spacing_) continue;
+
+            m.pose = plan[i].pose;
+            m.id++;
+            array.markers.push_back(m);
+            distance = 0;
+        }
+
+        num_arrows_ = m.id;
+        global_plan_marker_array_pub_.publish(array);
+        return;
+    }
+
     // Clear the markers
-    static unsigned int prev = 0;
     m.action = visualization_msgs::Marker::DELETE;
-    for (unsigned int i = 0; i < prev; ++i)
+    for (unsigned int i = 0; i < num_arrows_; ++i)
     {
         m.id++;
         array.markers.push_back(m);
@@ -76,7 +129,7 @@ void Visualization::publishGlobalPlanMarkerArray(const std::vector<geometry_msgs
         array.markers.push_back(m);
     }
 
-    prev = m.id;
+    num_arrows_ = m.id;
 
     // Publish plan
     global_plan_marker_array_pub_.publish(array);
@@ -84,6 +137,8 @@ void Visualization::publishGlobalPlanMarkerArray(const std::vector<geometry_msgs
 
 void Visualization::publishGoalPositionsMarker(const std::vector<tf::Point>& positions, const std::string& frame)
 {
+    if (goal_positions_marker_pub_.getNumSubscribers() == 0) return;
+
     // General properties
     visualization_msgs::Marker cube_list;
     cube_list.scale.x = 0.05;
@@ -99,12 +154,13 @@ void Visualization::publishGoalPositionsMarker(const std::vector<tf::Point>& pos
     cube_list.type = visualization_msgs::Marker::CUBE_LIST;
     cube_list.action = visualization_msgs::Marker::ADD;
 
-    // Push back all pnts
-    for (std::vector<tf::Point>::const_iterator it = positions.begin(); it != positions.end(); ++it)
+    // Push back all pnts (compact: evenly spread)
+    unsigned int stride = compact_ ? getStride(positions.size(), max_points_) : 1;
+    for (unsigned int i = 0; i < positions.size(); i += stride)
     {
         geometry_msgs::Point p;
-        p.x = it->x();
-        p.y = it->y();
+        p.x = positions[i].x();
+        p.y = positions[i].y();
         cube_list.points.push_back(p);
     }
 
@@ -1,4 +1,5 @@
 #include "cb_base_navigation/local_planner/local_planner_interface.h"
+#include "cb_base_navigation/costmap_layers/clearance_layer.h"
 
 #include <tue/profiling/ros/profile_publisher.h>
 #include <tue/profiling/scoped_timer.h>
@@ -6,13 +7,22 @@
 #include <boost/thread.hpp>
 #include <base_local_planner/goal_functions.h>
 
-// Querying world model (ED)
-#include <ed_msgs/SimpleQuery.h>
+#include <algorithm>
 
 using namespace cb_planner_msgs_srvs;
 
 namespace cb_local_planner {
 
+namespace {
+
+// A pose closer than this to the robot is passed, the plan continues after it [m^2]
+const double PRUNE_DISTANCE_SQ = 0.5;
+
+// The passed pose is searched in this arc length ahead of the cursor, the robot never gets further in one cycle [m]
+const double PRUNE_LOOKAHEAD = 2.0;
+
+}
+
 LocalPlannerInterface::~LocalPlannerInterface()
 {
     // Clean things up
@@ -23,12 +33,25 @@ LocalPlannerInterface::~LocalPlannerInterface()
 
     controller_thread_->interrupt();
     controller_thread_->join();
+
+    if (pipelined_)
+    {
+        costmap_update_thread_->interrupt();
+        costmap_update_thread_->join();
+        costmap_publish_thread_->interrupt();
+        costmap_publish_thread_->join();
+    }
+
+    delete entity_poses_;
 }
 
 LocalPlannerInterface::LocalPlannerInterface(costmap_2d::Costmap2DROS* costmap) :
+    costmap_update_thread_(0),
+    costmap_publish_thread_(0),
     lp_loader_("nav_core", "nav_core::BaseLocalPlanner"),
     tf_(new tf::TransformListener(ros::Duration(10))),
-    costmap_(costmap)
+    costmap_(costmap),
+    plan_index_(0)
 {
     ros::NodeHandle gh;
     ros::NodeHandle nh("~");
@@ -40,6 +63,18 @@ LocalPlannerInterface::LocalPlannerInterface(costmap_2d::Costmap2DROS* costmap)
     nh.param("global_frame", global_frame_, std::string("/map"));
     nh.param("controller_frequency", controller_frequency_, 20.0);
 
+    // Pipelined mode: costmap updates and publishing do not delay the velocity commands
+    nh.param("pipelined", pipelined_, false);
+    nh.param("costmap_update_frequency", costmap_update_frequency_, controller_frequency_);
+    nh.param("costmap_publish_frequency", costmap_publish_frequency_, 2.0);
+    nh.param("costmap_max_age", costmap_max_age_, 0.5);
+
+    // Entity poses: the orientation constraint frame is polled, a pose older than max_age [s] is not used
+    double entity_poll_frequency, entity_max_age;
+    nh.param("entity_poses/poll_frequency", entity_poll_frequency, 10.0);
+    nh.param("entity_poses/max_age", entity_max_age, 0.5);
+    entity_poses_ = new cb_base_navigation::EntityPoseCache(entity_poll_frequency, entity_max_age);
+
     // ROS Publishers
     vel_pub_ = gh.advertise<geometry_msgs::Twist>("cmd_vel", 1);
 
@@ -72,8 +107,11 @@ LocalPlannerInterface::LocalPlannerInterface(costmap_2d::Costmap2DROS* costmap)
     // Start the controller thread
     controller_thread_ = new boost::thread(boost::bind(&LocalPlannerInterface::controllerThread, this));
 
-    ros::NodeHandle n;
-    ed_client_ = n.serviceClient<ed_msgs::SimpleQuery>("ed/simple_query");
+    if (pipelined_)
+    {
+        costmap_update_thread_ = new boost::thread(boost::bind(&LocalPlannerInterface::costmapUpdateThread, this));
+        costmap_publish_thread_ = new boost::thread(boost::bind(&LocalPlannerInterface::costmapPublishThread, this));
+    }
 }
 
 void LocalPlannerInterface::topicGoalCallback(const LocalPlannerActionGoalConstPtr& goal)
@@ -84,8 +122,10 @@ void LocalPlannerInterface::topicGoalCallback(const LocalPlannerActionGoalConstP
 
     goal_ = goal->goal;
 
+    resetPlanProgress();
+
     if (isGoalSet()) {
-        updateEndGoalOrientation();
+        updateEndGoalOrientation(true); // not in the control loop, may wait for ED
         local_planner_->setPlan(goal_.plan);
     } else {
         ROS_ERROR("Received a plan of length 0, is something wrong?");
@@ -100,8 +140,10 @@ void LocalPlannerInterface::actionServerSetPlan()
 
     goal_ = *action_server_->acceptNewGoal();
 
+    resetPlanProgress();
+
     if (isGoalSet()) {
-        updateEndGoalOrientation();
+        updateEndGoalOrientation(true); // not in the control loop, may wait for ED
         local_planner_->setPlan(goal_.plan);
     } else {
         ROS_ERROR("Received a plan of length 0, is something wrong?");
@@ -114,6 +156,7 @@ void LocalPlannerInterface::actionServerPreempt()
 
     action_server_->setPreempted();
     goal_.plan.clear();
+    resetPlanProgress();
 }
 
 void LocalPlannerInterface::controllerThread()
@@ -140,19 +183,31 @@ void LocalPlannerInterface::controllerThread()
     {
         tue::ScopedTimer timer(profiler, "total");
 
+        if (!pipelined_)
         {
-            tue::ScopedTimer timer(profiler, "updateMap()");
-            costmap_->updateMap();
-        }
+            {
+                tue::ScopedTimer timer(profiler, "updateMap()");
+                costmap_->updateMap();
+            }
 
-        {
-            tue::ScopedTimer timer(profiler, "publishCostmap()");
-            costmap_->getPublisher()->publishCostmap();
-        }
+            {
+                tue::ScopedTimer timer(profiler, "publishCostmap()");
+                costmap_->getPublisher()->publishCostmap();
+            }
 
+            {
+                tue::ScopedTimer timer(profiler, "doSomeMotionPlanning()");
+                doSomeMotionPlanning();
+            }
+        }
+        else
         {
-            tue::ScopedTimer timer(profiler, "publishCostmap()");
-            doSomeMotionPlanning();
+            tue::ScopedTimer timer(profiler, "doSomeMotionPlanning()");
+
+            // The costmap does not change while the velocity is computed on it
+            boost::shared_lock<boost::shared_mutex> lock(costmap_mtx_);
+            if (isCostmapCurrent())
+                doSomeMotionPlanning();
         }
 
         {
@@ -178,40 +233,113 @@ void LocalPlannerInterface::controllerThread()
     }
 }
 
-void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan){
-    std::vector<geometry_msgs::PoseStamped>::iterator it = plan.begin();
-    while(it != plan.end()){
-      const geometry_msgs::PoseStamped& w = *it;
-      // Fixed error bound of 2 meters for now. Can reduce to a portion of the map size or based on the resolution
-      double x_diff = global_pose.getOrigin().x() - w.pose.position.x;
-      double y_diff = global_pose.getOrigin().y() - w.pose.position.y;
-      double distance_sq = x_diff * x_diff + y_diff * y_diff;
-      if(distance_sq < .5){
-        it = plan.erase(it);
-        ROS_DEBUG("Nearest waypoint to <%f, %f> is <%f, %f>\n", global_pose.getOrigin().x(), global_pose.getOrigin().y(), w.pose.position.x, w.pose.position.y);
-        break;
-      }
-      it = plan.erase(it);
+void LocalPlannerInterface::costmapUpdateThread()
+{
+    ros::Rate r(costmap_update_frequency_);
+
+    ROS_INFO_STREAM("LPI: Started costmap update thread @ " << costmap_update_frequency_ << " hz!");
+
+    while (ros::ok())
+    {
+        boost::this_thread::interruption_point();
+
+        {
+            boost::unique_lock<boost::shared_mutex> lock(costmap_mtx_);
+            costmap_->updateMap();
+            costmap_stamp_ = ros::Time::now();
+        }
+
+        if (!r.sleep())
+            ROS_WARN_STREAM_THROTTLE(1.0, "LPI: Costmap update rate of " << costmap_update_frequency_ << " hz not met, last update took "
+                                     << r.cycleTime().toSec() << " s.");
+    }
+}
+
+void LocalPlannerInterface::costmapPublishThread()
+{
+    ros::Rate r(costmap_publish_frequency_);
+
+    while (ros::ok())
+    {
+        boost::this_thread::interruption_point();
+
+        {
+            boost::shared_lock<boost::shared_mutex> lock(costmap_mtx_);
+            costmap_->getPublisher()->publishCostmap();
+        }
+
+        r.sleep();
+    }
+}
+
+bool LocalPlannerInterface::isCostmapCurrent()
+{
+    if (!costmap_stamp_.isZero() && (ros::Time::now() - costmap_stamp_).toSec() <= costmap_max_age_)
+        return true;
+
+    // Do not drive on an outdated costmap
+    boost::unique_lock<boost::mutex> lock(goal_mtx_);
+    if (isGoalSet())
+    {
+        ROS_WARN_THROTTLE(1.0, "LPI: The local costmap has not been updated for more than %.2f s, stopping.", costmap_max_age_);
+        geometry_msgs::Twist tw;
+        vel_pub_.publish(tw);
     }
-  }
+    return false;
+}
 
-double getDistance(const std::vector<geometry_msgs::PoseStamped>& plan)
+void LocalPlannerInterface::resetPlanProgress()
 {
+    plan_index_ = 0;
+    plan_distances_.resize(goal_.plan.size());
+
     double distance = 0;
-    if (plan.size() > 1)
-        for (unsigned int i = 1; i < plan.size(); ++i)
-            distance+=hypot(plan[i].pose.position.x-plan[i-1].pose.position.x, plan[i].pose.position.y-plan[i-1].pose.position.y);
-    return distance;
+    for (unsigned int i = 0; i < goal_.plan.size(); ++i)
+    {
+        if (i > 0)
+            distance += hypot(goal_.plan[i].pose.position.x - goal_.plan[i-1].pose.position.x,
+                              goal_.plan[i].pose.position.y - goal_.plan[i-1].pose.position.y);
+        plan_distances_[i] = distance;
+    }
+}
+
+void LocalPlannerInterface::updatePlanProgress()
+{
+    // Only the poses within the lookahead of the cursor are candidates, found by bisection on the arc lengths
+    std::vector<double>::const_iterator end = std::upper_bound(plan_distances_.begin() + plan_index_, plan_distances_.end(),
+                                                               plan_distances_[plan_index_] + PRUNE_LOOKAHEAD);
+
+    for (unsigned int i = plan_index_; i < (unsigned int) (end - plan_distances_.begin()); ++i)
+    {
+        const geometry_msgs::PoseStamped& w = goal_.plan[i];
+        double x_diff = global_pose_.getOrigin().x() - w.pose.position.x;
+        double y_diff = global_pose_.getOrigin().y() - w.pose.position.y;
+        if (x_diff * x_diff + y_diff * y_diff < PRUNE_DISTANCE_SQ)
+        {
+            // The remaining plan starts after the nearest waypoint, but always holds the goal
+            plan_index_ = std::min(i + 1, (unsigned int) goal_.plan.size() - 1);
+            ROS_DEBUG("Nearest waypoint to <%f, %f> is <%f, %f>\n", global_pose_.getOrigin().x(), global_pose_.getOrigin().y(), w.pose.position.x, w.pose.position.y);
+            return;
+        }
+    }
 }
 
-bool getBlockedPoint(const std::vector<geometry_msgs::PoseStamped>& plan, costmap_2d::Costmap2D* costmap, geometry_msgs::Point& p)
+bool getBlockedPoint(const std::vector<geometry_msgs::PoseStamped>& plan, unsigned int begin, costmap_2d::Costmap2DROS* costmap_ros, geometry_msgs::Point& p)
 {
-    for (std::vector<geometry_msgs::PoseStamped>::const_iterator it = plan.begin(); it != plan.end(); ++it)
+    // With a clearance layer the footprint is checked, otherwise the cost of the cell of a pose
+    const cb_base_navigation::ClearanceLayer* clearance = cb_base_navigation::ClearanceLayer::find(costmap_ros->getLayeredCostmap());
+    costmap_2d::Costmap2D* costmap = costmap_ros->getCostmap();
+    cb_base_navigation::FootprintCover footprint;
+    if (clearance) footprint = cb_base_navigation::FootprintCover(costmap_ros->getRobotFootprint(), costmap->getResolution());
+
+    for (std::vector<geometry_msgs::PoseStamped>::const_iterator it = plan.begin() + begin; it != plan.end(); ++it)
     {
         unsigned int mx, my;
         if (costmap->worldToMap(it->pose.position.x, it->pose.position.y, mx, my))
         {
-            if (costmap->getCost(mx, my) >= costmap_2d::INSCRIBED_INFLATED_OBSTACLE)
+            bool blocked = clearance ? !clearance->isFootprintFree(footprint, it->pose.position.x, it->pose.position.y, tf::getYaw(it->pose.orientation))
+                                     : costmap->getCost(mx, my) >= costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+            if (blocked)
             {
                 p = it->pose.position;
                 return true;
@@ -238,6 +366,7 @@ void LocalPlannerInterface::doSomeMotionPlanning()
         ROS_INFO("LPI: Local planner arrived at the goal position/orientation; clearing plan...");
         action_server_->setSucceeded();
         goal_.plan.clear();
+        resetPlanProgress();
         return;
     }
 
@@ -246,57 +375,30 @@ void LocalPlannerInterface::doSomeMotionPlanning()
     feedback_.blocked = !local_planner_->computeVelocityCommands(tw);
     vel_pub_.publish(tw);
 
-    // 4) Get the pruned plan
-    std::vector<geometry_msgs::PoseStamped> pruned_plan = goal_.plan;
-    prunePlan(global_pose_, pruned_plan);
+    // 4) Move the cursor past the waypoints we have reached
+    updatePlanProgress();
 
-    // 4) Publish some feedback to via the action_server
-    feedback_.dtg = getDistance(pruned_plan);
+    // 5) Publish some feedback to via the action_server
+    feedback_.dtg = plan_distances_.back() - plan_distances_[plan_index_];
     if (feedback_.dtg < 1)
-        feedback_.dtg = base_local_planner::getGoalPositionDistance(global_pose_, pruned_plan.end()->pose.position.x, pruned_plan.end()->pose.position.y);
+        feedback_.dtg = base_local_planner::getGoalPositionDistance(global_pose_, goal_.plan.back().pose.position.x, goal_.plan.back().pose.position.y);
     if (feedback_.blocked)
-        feedback_.blocked = getBlockedPoint(pruned_plan, costmap_->getCostmap(), feedback_.point_blocked);
+        feedback_.blocked = getBlockedPoint(goal_.plan, plan_index_, costmap_, feedback_.point_blocked);
     action_server_->publishFeedback(feedback_);
 }
 
-bool LocalPlannerInterface::updateEndGoalOrientation()
+bool LocalPlannerInterface::updateEndGoalOrientation(bool wait_for_frame)
 {
     if (!isGoalSet()) return false;
 
     tf::Transform constraint_to_world_tf;
-
-    if (goal_.orientation_constraint.frame == "/map" || goal_.orientation_constraint.frame == "map")
-    {
-        constraint_to_world_tf = tf::Transform::getIdentity();
-    }
-    else
+    if (!entity_poses_->getPose(goal_.orientation_constraint.frame, constraint_to_world_tf, wait_for_frame))
     {
-        ed_msgs::SimpleQuery ed_query;
-        ed_query.request.id = goal_.orientation_constraint.frame;
-
-        if (!ed_client_.call(ed_query))
-        {
-            ROS_ERROR("LPI: Failed to get robot orientation constraint frame: ED could not be queried.");
-            return false;
-        }
-
-        if (ed_query.response.entities.empty())
-        {
-            ROS_ERROR_STREAM("LPI: Failed to get robot orientation constraint frame: ED returns 'no such entity'. ("
-                             << goal_.orientation_constraint.frame << ").");
-            return false;
-        }
-
-        const ed_msgs::EntityInfo& e_info = ed_query.response.entities.front();
-
-        tf::Transform world_to_constraint_tf;
-        tf::poseMsgToTF(e_info.pose, world_to_constraint_tf);
-        constraint_to_world_tf = world_to_constraint_tf;
+        ROS_ERROR_STREAM_THROTTLE(1.0, "LPI: Failed to get robot orientation constraint frame: no recent pose of '"
+                                  << goal_.orientation_constraint.frame << "'.");
+        return false;
     }
 
-
-
-
 //    // Request the desired transform from constraint frame to map
 //    tf::StampedTransform constraint_to_world_tf;
 //    try {
@@ -0,0 +1,102 @@
+#include "cb_base_navigation/costmap_layers/clearance_layer.h"
+
+#include <costmap_2d/cost_values.h>
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace cb_base_navigation;
+
+namespace {
+
+// Distance [cells] from (x, y) to the nearest lethal cell, by trying them all
+double bruteForceDistance(const costmap_2d::Costmap2D& costmap, int x, int y)
+{
+    double best = HUGE_VAL;
+    for (unsigned int j = 0; j < costmap.getSizeInCellsY(); ++j)
+    {
+        for (unsigned int i = 0; i < costmap.getSizeInCellsX(); ++i)
+        {
+            if (costmap.getCost(i, j) != costmap_2d::LETHAL_OBSTACLE) continue;
+            double dx = (double) i - x, dy = (double) j - y;
+            best = std::min(best, sqrt(dx * dx + dy * dy));
+        }
+    }
+    return best;
+}
+
+void expectBruteForceClearance(const ClearanceLayer& layer, const costmap_2d::Costmap2D& costmap, const char* when)
+{
+    for (unsigned int y = 0; y < costmap.getSizeInCellsY(); ++y)
+    {
+        for (unsigned int x = 0; x < costmap.getSizeInCellsX(); ++x)
+        {
+            double expected = std::min(bruteForceDistance(costmap, x, y) * costmap.getResolution(), layer.getMaxDistance());
+            double wx, wy;
+            costmap.mapToWorld(x, y, wx, wy);
+            ASSERT_NEAR(expected, layer.getClearance(wx, wy), 1e-4) << when << ", cell (" << x << ", " << y << ")";
+        }
+    }
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(ClearanceLayer, DistanceTransformIsTheBruteForceDistance)
+{
+    const int width = 70, height = 45;
+    srand(3);
+    costmap_2d::Costmap2D costmap(width, height, 0.05, 0, 0);
+    for (unsigned int i = 0; i < 40; ++i) costmap.setCost(rand() % width, rand() % height, costmap_2d::LETHAL_OBSTACLE);
+
+    std::vector<float> f(width * height);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x) f[y * width + x] = (costmap.getCost(x, y) == costmap_2d::LETHAL_OBSTACLE) ? 0 : 1e20;
+    }
+    ClearanceLayer::distanceTransform(f, width, height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            double expected = bruteForceDistance(costmap, x, y);
+            ASSERT_NEAR(expected * expected, f[y * width + x], 1e-3 * (1 + expected * expected)) << "cell (" << x << ", " << y << ")";
+        }
+    }
+}
+
+TEST(ClearanceLayer, UpdatesGiveTheBruteForceClearance)
+{
+    const int width = 90, height = 70;
+    srand(5);
+    costmap_2d::Costmap2D costmap(width, height, 0.05, -1.0, -2.0);
+    for (unsigned int i = 0; i < 100; ++i) costmap.setCost(rand() % width, rand() % height, costmap_2d::LETHAL_OBSTACLE);
+
+    // the first update computes every cell, the ones after that only the surroundings of the changed window
+    ClearanceLayer layer;
+    layer.updateCosts(costmap, 0, 0, width, height);
+    expectBruteForceClearance(layer, costmap, "full update");
+
+    for (unsigned int u = 0; u < 100; ++u)
+    {
+        int x0 = rand() % width, y0 = rand() % height;
+        int x1 = std::min(width, x0 + 1 + rand() % 6), y1 = std::min(height, y0 + 1 + rand() % 6);
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x) costmap.setCost(x, y, (rand() % 5 == 0) ? costmap_2d::LETHAL_OBSTACLE : costmap_2d::FREE_SPACE);
+        }
+        layer.updateCosts(costmap, x0, y0, x1, y1);
+        EXPECT_LT(layer.getCellsUpdated(), (unsigned int) (width * height));
+        if (u % 20 == 0) expectBruteForceClearance(layer, costmap, "window update");
+    }
+    expectBruteForceClearance(layer, costmap, "last window update");
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
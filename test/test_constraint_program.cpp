@@ -0,0 +1,158 @@
+#include "cb_base_navigation/global_planner/constraint_program.h"
+#include "cb_base_navigation/global_planner/exprtk.h"
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+using namespace cb_global_planner;
+
+namespace {
+
+// Position constraints as they are sent to the planner, and the parts of the grammar they are made of
+const char* CONSTRAINTS[] = {
+    "(x-1.3)^2 + (y-2.7)^2 < 3^2",
+    "x^2 + y^2 > 1 and x^2 + y^2 < 2^2",
+    "-1 < x and x < 1 and -0.5 < y and y < 0.5 or x > 3",
+    "abs(x) + abs(y) <= 2",
+    "hypot(x-1, y) < 1.5 xor y > 0",
+    "not(x < 0) nand y < 0",
+    "x > 0 nor y > 0",
+    "x >= -1 xnor y <= 1",
+    "sqrt(x^2 + y^2) < 2 & atan2(y, x) > 0",
+    "sin(x) < cos(y) | tan(x) > 5",
+    "exp(x) < 2 and log(y) > 0",
+    "floor(x) == 1 and ceil(y) != 2",
+    "min(x, y) > -1 and max(x, y) < 1",
+    "x % 2 < 1",
+    "x^-2 > 1",
+    "2^x < y",
+    "asin(y/4) + acos(x/4) > 1",
+    "x*0.1 == 0.3",
+    "x == 1.0000000001",
+    "x == y",
+    "x != -y",
+    "x == log(0)",
+    "x < log(0) or y > -log(0)",
+    "1/x > 1e300",
+    "x - y == 0 and y <> 1",
+    "-x^2 < -1",
+    "2 * -x - 3 > y / 2 - 1",
+};
+const unsigned int NUM_CONSTRAINTS = sizeof(CONSTRAINTS) / sizeof(CONSTRAINTS[0]);
+
+struct Exprtk
+{
+    double x, y;
+    exprtk::symbol_table<double> symbol_table;
+    exprtk::expression<double> expression;
+
+    bool compile(const std::string& constraint)
+    {
+        symbol_table.add_variable("x", x);
+        symbol_table.add_variable("y", y);
+        expression.register_symbol_table(symbol_table);
+        exprtk::parser<double> parser;
+        return parser.compile(constraint, expression);
+    }
+
+    bool evaluate(double px, double py)
+    {
+        x = px;
+        y = py;
+        return expression.value();
+    }
+};
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(ConstraintProgram, GivesTheResultsOfExprtkOnGrids)
+{
+    static const double scales[] = { 0.05, 0.25, 4.0 };
+    static const int N = 40;
+
+    for (unsigned int c = 0; c < NUM_CONSTRAINTS; ++c)
+    {
+        Exprtk reference;
+        ASSERT_TRUE(reference.compile(CONSTRAINTS[c])) << CONSTRAINTS[c];
+        ConstraintProgram program;
+        ASSERT_TRUE(program.compile(CONSTRAINTS[c])) << CONSTRAINTS[c];
+
+        std::vector<unsigned char> result(2 * N + 1);
+        for (unsigned int s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s)
+        {
+            for (int j = -N; j <= N; ++j)
+            {
+                double y = j * scales[s];
+                program.evaluateLine(-N * scales[s], y, scales[s], 0, 2 * N + 1, &result[0]);
+                for (int i = -N; i <= N; ++i)
+                {
+                    double x = -N * scales[s] + (i + N) * scales[s];
+                    ASSERT_EQ(reference.evaluate(x, y), (bool) result[i + N]) << CONSTRAINTS[c] << " at (" << x << ", " << y << ")";
+                    ASSERT_EQ(reference.evaluate(x, y), program.evaluate(x, y)) << CONSTRAINTS[c] << " at (" << x << ", " << y << ")";
+                }
+            }
+        }
+    }
+}
+
+TEST(ConstraintProgram, GivesTheResultsOfExprtkOnSpecialValues)
+{
+    // near-equal, tiny, huge and infinite coordinates, where a tolerance or rounding would show
+    static const double values[] = { 0.0, -0.0, 1e-300, 1e-12, 0.3, 0.1 + 0.2, 1.0, 1.0 + 1e-12, 1.0000000001, 2.0, 1e300, HUGE_VAL,
+                                     -1e-12, -0.3, -1.0, -1e300, -HUGE_VAL };
+    static const unsigned int n = sizeof(values) / sizeof(values[0]);
+
+    for (unsigned int c = 0; c < NUM_CONSTRAINTS; ++c)
+    {
+        Exprtk reference;
+        ASSERT_TRUE(reference.compile(CONSTRAINTS[c]));
+        ConstraintProgram program;
+        ASSERT_TRUE(program.compile(CONSTRAINTS[c]));
+
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                EXPECT_EQ(reference.evaluate(values[i], values[j]), program.evaluate(values[i], values[j]))
+                        << CONSTRAINTS[c] << " at (" << values[i] << ", " << values[j] << ")";
+            }
+        }
+    }
+}
+
+TEST(ConstraintProgram, BoundingBoxHoldsEverySatisfiedPoint)
+{
+    static const double min = -10, max = 10, resolution = 0.05;
+
+    for (unsigned int c = 0; c < NUM_CONSTRAINTS; ++c)
+    {
+        ConstraintProgram program;
+        ASSERT_TRUE(program.compile(CONSTRAINTS[c]));
+
+        double bb_min_x, bb_min_y, bb_max_x, bb_max_y;
+        bool any = program.getBoundingBox(min, min, max, max, resolution, bb_min_x, bb_min_y, bb_max_x, bb_max_y);
+
+        for (double y = min + resolution / 2; y < max; y += resolution)
+        {
+            for (double x = min + resolution / 2; x < max; x += resolution)
+            {
+                if (!program.evaluate(x, y)) continue;
+                ASSERT_TRUE(any) << CONSTRAINTS[c] << " holds at (" << x << ", " << y << ")";
+                ASSERT_TRUE(x >= bb_min_x && x <= bb_max_x && y >= bb_min_y && y <= bb_max_y)
+                        << CONSTRAINTS[c] << " holds at (" << x << ", " << y << ") outside the bounding box";
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,57 @@
+#include "a_star_planner/a_star_planner.h"
+#include "d_star_lite_planner/d_star_lite_planner.h"
+#include "test_maps.h"
+
+#include <gtest/gtest.h>
+
+using namespace cb_global_planner;
+
+namespace {
+
+const int WIDTH = 120, HEIGHT = 100;
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(DStarLitePlanner, RepairedPlansCostAsMuchAsAFreshAStar)
+{
+    for (unsigned int seed = 1; seed <= 8; ++seed)
+    {
+        test_maps::ReplanScenario scenario(WIDTH, HEIGHT, seed);
+        AStarPlanner a_star(WIDTH, HEIGHT);
+        DStarLitePlanner d_star_lite;
+        unsigned int repairs = 0;
+
+        for (unsigned int s = 0; s < 15; ++s)
+        {
+            std::vector<int> a_xs, a_ys, d_xs, d_ys;
+            unsigned int a_tier, d_tier;
+            a_star.setCostmap(&scenario.costmap[0]);
+            bool a_found = a_star.planTiered(scenario.mx_tier, scenario.my_tier, CostModel::NUM_GOAL_TIERS, scenario.mx_robot, scenario.my_robot, a_xs, a_ys, a_tier);
+            bool d_found = d_star_lite.plan(&scenario.costmap[0], WIDTH, HEIGHT, scenario.mx_tier, scenario.my_tier, CostModel::NUM_GOAL_TIERS,
+                                            scenario.mx_robot, scenario.my_robot, d_xs, d_ys, d_tier);
+            if (!d_star_lite.getStatistics().restarted) ++repairs;
+
+            ASSERT_EQ(a_found, d_found) << "seed " << seed << ", step " << s;
+            if (a_found)
+            {
+                double a_cost = scenario.planCost(a_xs, a_ys), d_cost = scenario.planCost(d_xs, d_ys);
+                EXPECT_GE(d_cost, 0) << "seed " << seed << ", step " << s;
+                EXPECT_NEAR(a_cost, d_cost, 1e-6 * (1 + a_cost)) << "seed " << seed << ", step " << s;
+                EXPECT_EQ(a_tier, d_tier);
+                EXPECT_EQ(scenario.mx_robot, d_xs.front());
+                EXPECT_EQ(scenario.my_robot, d_ys.front());
+            }
+            scenario.step(a_xs, a_ys);
+        }
+        // the scenario has to exercise the repair, not only new searches
+        EXPECT_GT(repairs, 0u) << "seed " << seed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
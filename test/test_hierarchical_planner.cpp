@@ -0,0 +1,67 @@
+#include "a_star_planner/a_star_planner.h"
+#include "hierarchical_planner/hierarchical_planner.h"
+#include "test_maps.h"
+
+#include <gtest/gtest.h>
+
+using namespace cb_global_planner;
+
+namespace {
+
+const int WIDTH = 120, HEIGHT = 100;
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(HierarchicalPlanner, UpdatedGraphPlansLikeAFreshGraph)
+{
+    for (unsigned int seed = 1; seed <= 8; ++seed)
+    {
+        test_maps::ReplanScenario scenario(WIDTH, HEIGHT, seed);
+        AStarPlanner a_star(WIDTH, HEIGHT);
+        HierarchicalPlanner hierarchical;
+        hierarchical.setClusterSize(16);
+
+        for (unsigned int s = 0; s < 10; ++s)
+        {
+            std::vector<int> a_xs, a_ys, h_xs, h_ys, f_xs, f_ys;
+            unsigned int a_tier, h_tier, f_tier;
+            a_star.setCostmap(&scenario.costmap[0]);
+            bool a_found = a_star.planTiered(scenario.mx_tier, scenario.my_tier, CostModel::NUM_GOAL_TIERS, scenario.mx_robot, scenario.my_robot, a_xs, a_ys, a_tier);
+            bool h_found = hierarchical.plan(&scenario.costmap[0], WIDTH, HEIGHT, scenario.mx_tier, scenario.my_tier, CostModel::NUM_GOAL_TIERS,
+                                             scenario.mx_robot, scenario.my_robot, h_xs, h_ys, h_tier);
+
+            HierarchicalPlanner fresh;
+            fresh.setClusterSize(16);
+            bool f_found = fresh.plan(&scenario.costmap[0], WIDTH, HEIGHT, scenario.mx_tier, scenario.my_tier, CostModel::NUM_GOAL_TIERS,
+                                      scenario.mx_robot, scenario.my_robot, f_xs, f_ys, f_tier);
+
+            // the graph that was updated cluster by cluster plans like one built from scratch
+            ASSERT_EQ(f_found, h_found) << "seed " << seed << ", step " << s;
+            if (h_found)
+            {
+                double f_cost = scenario.planCost(f_xs, f_ys);
+                EXPECT_NEAR(f_cost, scenario.planCost(h_xs, h_ys), 1e-6 * (1 + f_cost)) << "seed " << seed << ", step " << s;
+            }
+
+            // and, as it is not optimal, finds a valid plan whenever A* does, never cheaper than the A* plan
+            ASSERT_EQ(a_found, h_found) << "seed " << seed << ", step " << s;
+            if (a_found)
+            {
+                double a_cost = scenario.planCost(a_xs, a_ys), h_cost = scenario.planCost(h_xs, h_ys);
+                EXPECT_GE(h_cost, a_cost - 1e-6 * (1 + a_cost)) << "seed " << seed << ", step " << s;
+                EXPECT_EQ(a_tier, h_tier);
+                EXPECT_EQ(scenario.mx_robot, h_xs.front());
+                EXPECT_EQ(scenario.my_robot, h_ys.front());
+            }
+            scenario.step(a_xs, a_ys);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
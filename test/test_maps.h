@@ -0,0 +1,157 @@
+#ifndef cb_base_navigation_TEST_MAPS_H_
+#define cb_base_navigation_TEST_MAPS_H_
+
+#include "a_star_planner/cost_model.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace test_maps {
+
+/**
+ * @brief Adds a rectangular obstacle with an inflation gradient of radius r around it, or clears that area
+ */
+inline void addObstacle(std::vector<unsigned char>& costmap, int width, int height, int x0, int y0, int w, int h, int r, bool add = true)
+{
+    for (int y = y0 - r; y < y0 + h + r; ++y)
+    {
+        for (int x = x0 - r; x < x0 + w + r; ++x)
+        {
+            if (x < 0 || y < 0 || x >= width || y >= height) continue;
+            if (!add)
+            {
+                costmap[width * y + x] = 0;
+                continue;
+            }
+            int dx = std::max(0, std::max(x0 - x, x - (x0 + w - 1)));
+            int dy = std::max(0, std::max(y0 - y, y - (y0 + h - 1)));
+            int d = std::max(dx, dy);
+            unsigned char c = (d == 0) ? 254 : (unsigned char) (252 * (r - d + 1) / (r + 1));
+            costmap[width * y + x] = std::max(costmap[width * y + x], c);
+        }
+    }
+}
+
+/**
+ * @brief Random obstacles on free space
+ */
+inline void generateCostmap(std::vector<unsigned char>& costmap, int width, int height, int num_obstacles)
+{
+    costmap.assign(width * height, 0);
+    for (int i = 0; i < num_obstacles; ++i)
+    {
+        addObstacle(costmap, width, height, rand() % width, rand() % height, 1 + rand() % 15, 1 + rand() % 15, rand() % 6);
+    }
+}
+
+/**
+ * @brief The traversable cells within r of (cx, cy), divided in goal tiers like the AStarPlannerGPP does
+ */
+inline void goalTiers(const std::vector<unsigned char>& costmap, int width, int height, int cx, int cy, int r,
+                      const cb_global_planner::CostModel& cost_model, std::vector<unsigned int>* mx_tier, std::vector<unsigned int>* my_tier)
+{
+    for (unsigned int t = 0; t < cb_global_planner::CostModel::NUM_GOAL_TIERS; ++t)
+    {
+        mx_tier[t].clear();
+        my_tier[t].clear();
+    }
+    for (int y = std::max(0, cy - r); y <= std::min(height - 1, cy + r); ++y)
+    {
+        for (int x = std::max(0, cx - r); x <= std::min(width - 1, cx + r); ++x)
+        {
+            unsigned char c = costmap[width * y + x];
+            if (cost_model.getTraversalTime(c) == DBL_MAX) continue;
+            unsigned int t = cost_model.getGoalTier(c);
+            mx_tier[t].push_back(x);
+            my_tier[t].push_back(y);
+        }
+    }
+}
+
+/**
+ * @brief Cost of a cell plan like the search computes it (every cell but the last one), -1 if two cells of the plan are not neighbours
+ */
+inline double planCost(const std::vector<unsigned char>& costmap, int width, const cb_global_planner::CostModel& cost_model,
+                       const std::vector<int>& plan_xs, const std::vector<int>& plan_ys)
+{
+    double cost = 0;
+    for (unsigned int i = 0; i + 1 < plan_xs.size(); ++i)
+    {
+        int dx = abs(plan_xs[i + 1] - plan_xs[i]), dy = abs(plan_ys[i + 1] - plan_ys[i]);
+        if (dx > 1 || dy > 1 || (dx == 0 && dy == 0)) return -1;
+        cost += cost_model.getTraversalTime(costmap[width * plan_ys[i] + plan_xs[i]]) * ((dx && dy) ? 1.414213562 : 1.0);
+    }
+    return cost;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+/**
+ * Replans of one incremental planner in changing costmaps: the robot follows the plan a few cells, obstacles
+ * appear on the plan and elsewhere or disappear, and the goal tiers follow the costmap
+ */
+class ReplanScenario
+{
+
+public:
+
+    std::vector<unsigned char> costmap;
+    std::vector<unsigned int> mx_tier[cb_global_planner::CostModel::NUM_GOAL_TIERS], my_tier[cb_global_planner::CostModel::NUM_GOAL_TIERS];
+    int mx_robot, my_robot;
+
+    ReplanScenario(int width, int height, unsigned int seed) : width_(width), height_(height)
+    {
+        srand(seed);
+        generateCostmap(costmap, width_, height_, 20);
+        goal_x_ = rand() % width_;
+        goal_y_ = rand() % height_;
+        goalTiers(costmap, width_, height_, goal_x_, goal_y_, 4, cost_model_, mx_tier, my_tier);
+        mx_robot = 1 + rand() % (width_ - 2);
+        my_robot = 1 + rand() % (height_ - 2);
+    }
+
+    void step(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys)
+    {
+        if (plan_xs.size() > 4)
+        {
+            mx_robot = plan_xs[3];
+            my_robot = plan_ys[3];
+        }
+
+        unsigned int changes = rand() % 3;
+        for (unsigned int c = 0; c < changes; ++c)
+        {
+            if (plan_xs.size() > 10 && rand() % 2)
+            {
+                int i = 4 + rand() % (plan_xs.size() - 4);
+                addObstacle(costmap, width_, height_, plan_xs[i], plan_ys[i], 1 + rand() % 4, 1 + rand() % 4, rand() % 4);
+            }
+            else
+            {
+                addObstacle(costmap, width_, height_, rand() % width_, rand() % height_, 1 + rand() % 6, 1 + rand() % 6, rand() % 3, rand() % 2);
+            }
+        }
+        goalTiers(costmap, width_, height_, goal_x_, goal_y_, 4, cost_model_, mx_tier, my_tier);
+    }
+
+    double planCost(const std::vector<int>& plan_xs, const std::vector<int>& plan_ys) const
+    {
+        return test_maps::planCost(costmap, width_, cost_model_, plan_xs, plan_ys);
+    }
+
+private:
+
+    int width_, height_;
+    int goal_x_, goal_y_;
+    cb_global_planner::CostModel cost_model_;
+
+};
+
+
+}
+
+#endif /* TEST_MAPS_H_ */
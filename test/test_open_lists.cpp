@@ -0,0 +1,144 @@
+#include "a_star_planner/a_star_planner.h"
+#include "a_star_planner/open_list.h"
+#include "test_maps.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+using namespace cb_global_planner;
+
+namespace {
+
+// Pushes and pops with monotone keys like A* with a consistent heuristic: pushed keys are never below the last popped key
+template <class OpenList>
+void runMonotone(OpenList& open, unsigned int seed, std::vector<double>& popped)
+{
+    srand(seed);
+    open.prepare(1000);
+    popped.clear();
+    double last = 0;
+    for (unsigned int i = 0; i < 5000; ++i)
+    {
+        unsigned int pushes = rand() % 4;
+        for (unsigned int p = 0; p < pushes; ++p)
+        {
+            // a few equal keys, as in uniform cost regions
+            open.push(rand() % 1000, last + (rand() % 3 == 0 ? 0.0 : (rand() % 1000) * 0.01));
+        }
+        if (!open.empty())
+        {
+            last = open.topKey();
+            popped.push_back(last);
+            open.pop();
+        }
+    }
+    while (!open.empty())
+    {
+        popped.push_back(open.topKey());
+        open.pop();
+    }
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(OpenLists, RadixPopsTheKeysOfTheBinaryHeap)
+{
+    BinaryOpenList binary;
+    RadixOpenList radix;
+    std::vector<double> binary_keys, radix_keys;
+    for (unsigned int seed = 1; seed <= 5; ++seed)
+    {
+        runMonotone(binary, seed, binary_keys);
+        runMonotone(radix, seed, radix_keys);
+        ASSERT_EQ(binary_keys.size(), radix_keys.size());
+        for (unsigned int i = 0; i < binary_keys.size(); ++i) ASSERT_EQ(binary_keys[i], radix_keys[i]) << "pop " << i;
+    }
+}
+
+TEST(OpenLists, QuaternaryKeepsTheLowestKeyPerCell)
+{
+    // the indexed heap holds every cell once, with its lowest key
+    QuaternaryOpenList quaternary;
+    std::map<int, double> reference;
+    srand(7);
+    quaternary.prepare(500);
+    for (unsigned int i = 0; i < 20000; ++i)
+    {
+        if (rand() % 3 != 0)
+        {
+            int k = rand() % 500;
+            double f = (rand() % 10000) * 0.01;
+            std::map<int, double>::iterator it = reference.find(k);
+            if (it == reference.end() || f < it->second)
+            {
+                reference[k] = f;
+                quaternary.push(k, f);
+            }
+        }
+        else if (!reference.empty())
+        {
+            ASSERT_FALSE(quaternary.empty());
+            double lowest = DBL_MAX;
+            for (std::map<int, double>::const_iterator it = reference.begin(); it != reference.end(); ++it) lowest = std::min(lowest, it->second);
+            ASSERT_EQ(lowest, quaternary.topKey());
+            ASSERT_EQ(lowest, reference[quaternary.top()]);
+            reference.erase(quaternary.top());
+            quaternary.pop();
+        }
+        ASSERT_EQ(reference.size(), quaternary.size());
+    }
+}
+
+TEST(OpenLists, PlannerGivesTheCostsOfTheBinaryHeap)
+{
+    const int width = 150, height = 120;
+    CostModel cost_model;
+    const AStarPlanner::OpenListType types[3] = { AStarPlanner::OPEN_LIST_BINARY, AStarPlanner::OPEN_LIST_QUATERNARY, AStarPlanner::OPEN_LIST_RADIX };
+    AStarPlanner* planners[3];
+    for (unsigned int p = 0; p < 3; ++p)
+    {
+        planners[p] = new AStarPlanner(width, height);
+        planners[p]->setNodeStorage(AStarPlanner::NODE_STORAGE_FLAT);
+        planners[p]->setOpenListType(types[p]);
+    }
+
+    srand(11);
+    std::vector<unsigned char> costmap;
+    for (unsigned int q = 0; q < 40; ++q)
+    {
+        test_maps::generateCostmap(costmap, width, height, 25);
+        std::vector<unsigned int> mx_tier[CostModel::NUM_GOAL_TIERS], my_tier[CostModel::NUM_GOAL_TIERS];
+        test_maps::goalTiers(costmap, width, height, rand() % width, rand() % height, 4, cost_model, mx_tier, my_tier);
+        int mx_robot = 1 + rand() % (width - 2), my_robot = 1 + rand() % (height - 2);
+
+        bool found[3];
+        double cost[3];
+        unsigned int tier[3];
+        for (unsigned int p = 0; p < 3; ++p)
+        {
+            std::vector<int> plan_xs, plan_ys;
+            planners[p]->setCostmap(&costmap[0]);
+            found[p] = planners[p]->planTiered(mx_tier, my_tier, CostModel::NUM_GOAL_TIERS, mx_robot, my_robot, plan_xs, plan_ys, tier[p]);
+            cost[p] = test_maps::planCost(costmap, width, cost_model, plan_xs, plan_ys);
+        }
+        for (unsigned int p = 1; p < 3; ++p)
+        {
+            ASSERT_EQ(found[0], found[p]) << "query " << q << ", open list " << p;
+            if (!found[0]) continue;
+            EXPECT_GE(cost[p], 0);
+            EXPECT_NEAR(cost[0], cost[p], 1e-6 * (1 + cost[0])) << "query " << q << ", open list " << p;
+            EXPECT_EQ(tier[0], tier[p]);
+        }
+    }
+
+    for (unsigned int p = 0; p < 3; ++p) delete planners[p];
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+#include "a_star_planner/plan_validity_tracker.h"
+
+#include <costmap_2d/cost_values.h>
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+using namespace cb_global_planner;
+
+namespace {
+
+const int WIDTH = 200, HEIGHT = 200;
+const double RESOLUTION = 0.05, ORIGIN_X = -5, ORIGIN_Y = -5;
+
+// Random walk over the cells, with every third pose left out like in a simplified plan
+void generatePlan(std::vector<geometry_msgs::PoseStamped>& plan)
+{
+    plan.clear();
+    int x = 20, y = 20;
+    for (unsigned int i = 0; i < 600; ++i)
+    {
+        x = std::max(1, std::min(WIDTH - 2, x + rand() % 3 - 1));
+        y = std::max(1, std::min(HEIGHT - 2, y + rand() % 3 - 1));
+        if (i % 3 == 0) continue;
+        geometry_msgs::PoseStamped pose;
+        pose.pose.position.x = ORIGIN_X + (x + 0.5) * RESOLUTION;
+        pose.pose.position.y = ORIGIN_Y + (y + 0.5) * RESOLUTION;
+        pose.pose.orientation.w = 1;
+        plan.push_back(pose);
+    }
+}
+
+/**
+ * Changes random squares of the costmap, tells the layer their bounds like the layered costmap does and compares the
+ * tracker with a tracker that checks the whole plan every time
+ */
+void compareWithFullCheck(bool footprint_checks)
+{
+    srand(footprint_checks ? 4 : 3);
+    costmap_2d::Costmap2D costmap(WIDTH, HEIGHT, RESOLUTION, ORIGIN_X, ORIGIN_Y);
+    CostModel cost_model;
+    UpdatedBoundsLayer layer;
+    cb_base_navigation::ClearanceLayer clearance;
+    std::vector<geometry_msgs::Point> footprint(4);
+    footprint[0].x = 0.1;  footprint[0].y = 0.08;
+    footprint[1].x = 0.1;  footprint[1].y = -0.08;
+    footprint[2].x = -0.1; footprint[2].y = -0.08;
+    footprint[3].x = -0.1; footprint[3].y = 0.08;
+    cb_base_navigation::FootprintCover cover(footprint, 0.02);
+    const cb_base_navigation::ClearanceLayer* clearance_layer = footprint_checks ? &clearance : NULL;
+    if (footprint_checks) clearance.updateCosts(costmap, 0, 0, WIDTH, HEIGHT);
+
+    std::vector<geometry_msgs::PoseStamped> plan;
+    generatePlan(plan);
+
+    PlanValidityTracker tracker;
+    unsigned int poses_checked = 0, poses_checked_full = 0, blocked = 0;
+    for (unsigned int u = 0; u < 1000; ++u)
+    {
+        double min_x = 1e30, min_y = 1e30, max_x = -1e30, max_y = -1e30;
+        unsigned int changes = rand() % 3;
+        for (unsigned int c = 0; c < changes; ++c)
+        {
+            int cx = rand() % WIDTH, cy = rand() % HEIGHT, r = rand() % 4;
+            int x0 = std::max(0, cx - r), y0 = std::max(0, cy - r), x1 = std::min(WIDTH, cx + r + 1), y1 = std::min(HEIGHT, cy + r + 1);
+            for (int y = y0; y < y1; ++y)
+            {
+                for (int x = x0; x < x1; ++x) costmap.setCost(x, y, (rand() % 4 == 0) ? costmap_2d::LETHAL_OBSTACLE : costmap_2d::FREE_SPACE);
+            }
+            if (footprint_checks) clearance.updateCosts(costmap, x0, y0, x1, y1);
+            min_x = std::min(min_x, ORIGIN_X + x0 * RESOLUTION);
+            min_y = std::min(min_y, ORIGIN_Y + y0 * RESOLUTION);
+            max_x = std::max(max_x, ORIGIN_X + x1 * RESOLUTION);
+            max_y = std::max(max_y, ORIGIN_Y + y1 * RESOLUTION);
+        }
+        layer.updateBounds(0, 0, 0, &min_x, &min_y, &max_x, &max_y);
+
+        // not every update is followed by a check, and now and then the robot gets a new plan
+        if (rand() % 3 == 0) continue;
+        if (rand() % 50 == 0) generatePlan(plan);
+
+        int first_blocked = tracker.findFirstBlockedPose(costmap, cost_model, &layer, clearance_layer, cover, plan);
+        poses_checked += tracker.getPosesChecked();
+
+        PlanValidityTracker full;
+        int expected = full.findFirstBlockedPose(costmap, cost_model, NULL, clearance_layer, cover, plan);
+        poses_checked_full += full.getPosesChecked();
+
+        ASSERT_EQ(expected, first_blocked) << "update " << u;
+        if (expected >= 0) ++blocked;
+    }
+
+    // the comparison means little if plans are never blocked or always at once
+    EXPECT_GT(blocked, 0u);
+    EXPECT_LT(poses_checked, poses_checked_full);
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+TEST(PlanValidityTracker, FindsTheBlockedPoseOfAFullCheck)
+{
+    compareWithFullCheck(false);
+}
+
+TEST(PlanValidityTracker, FindsTheBlockedPoseOfAFullFootprintCheck)
+{
+    compareWithFullCheck(true);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}